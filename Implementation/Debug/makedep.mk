@@ -48,13 +48,31 @@ Source\debug.c
 
 Source\encoder.c
 
+Source\encoderCounter.c
+
+Source\encoderVelocity.c
+
+Source\gpioFast.c
+
+Source\i2cBus.c
+
 Source\motor.c
 
 Source\pid.c
 
+Source\regmap.c
+
 Source\scheduler.c
 
 Source\surface_sensor.c
 
 Source\vl53l0x.c
 
+Source\vl53l0x_adaptive.c
+
+Source\vl53l0x_array.c
+
+Source\vl53l0x_filter.c
+
+Source\vl53l0x_history.c
+
@@ -12,4 +12,22 @@
 #define GEAR_RATIO 30
 #define WHEEL_DIAMETER 10
 
+/**	Number of encoders which can be registered with encoder_init. Must not be greater than 8.
+*/
+#define ENCODER_MAX_ENCODERS	8
+
+/**	Fractional bits of the velocity computed by encoderVelocity_update
+*/
+#define ENCODERVELOCITY_FRACTION_BITS	8
+
+/**	Time in milliseconds without any edge after which the velocity is 0
+*/
+#define ENCODERVELOCITY_STOP_TIME_MS	250
+
+/**	Timers counting encoder edges with encoderCounter. Their overflow interrupts are handled by encoderCounter, so they must not be used in the timer, counter or PWM configuration.
+*/
+//#define ENCODERCOUNTER_USING_TIMER0
+//#define ENCODERCOUNTER_USING_TIMER1
+//#define ENCODERCOUNTER_USING_TIMER3
+
 #endif /* ENCODER_CONFIG_H_ */
\ No newline at end of file
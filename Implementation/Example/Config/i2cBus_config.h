@@ -0,0 +1,39 @@
+/**	@file		i2cBus_config.h
+	@brief		I2C transaction engine configuration
+	@details	Specifies the following:
+				- if the TWI interrupt drives the transactions
+				- how many segments a transaction can chain
+				- when a device falls back to a lower bus frequency
+				- if the transactions are traced and how many are kept
+				These defines are used for code size and memory usage reduction, so set the defines accordingly.
+*/
+
+#ifndef I2CBUS_CONFIG_H_
+#define I2CBUS_CONFIG_H_
+
+/**	Runs the transactions from the TWI interrupt, so the CPU is free while the bus is busy. The engine then owns the TWI peripheral and its interrupt vector, so I2C_INTERRUPT_MODE must stay undefined in i2c_config.h.
+	Without it, transactions run to completion inside @link i2cBus_submit @endlink using the blocking HAL calls.
+*/
+//#define I2CBUS_INTERRUPT_MODE
+
+/**	Largest number of segments in a @link i2cBus_transaction_struct_t @endlink. Each one takes 4 bytes of RAM in every transaction.
+*/
+#define I2CBUS_MAX_SEGMENTS	8
+
+/**	Number of failed transactions in a row after which a device with a @link i2cBus_speed_struct_t @endlink halves its bus frequency
+*/
+#define I2CBUS_FALLBACK_FAILURES	3
+
+/**	Lowest frequency in Hz a device falls back to. Standard mode.
+*/
+#define I2CBUS_MIN_FREQUENCY	100000
+
+/**	Records every transaction in a RAM ring buffer, see @link i2cBus_dumpTrace @endlink. Costs two clock reads per transaction and @link I2CBUS_TRACE_SIZE @endlink * 14 + 15 bytes of RAM.
+*/
+//#define I2CBUS_TRACE
+
+/**	Number of transactions kept by the trace. The oldest ones are overwritten. Must not be greater than 255.
+*/
+#define I2CBUS_TRACE_SIZE	32
+
+#endif /* I2CBUS_CONFIG_H_ */
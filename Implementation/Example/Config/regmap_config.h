@@ -0,0 +1,15 @@
+/**	@file		regmap_config.h
+	@brief		Register map configuration
+	@details	Specifies the following:
+				- how many registers of a device can be cached
+				These defines are used for code size and memory usage reduction, so set the defines accordingly.
+*/
+
+#ifndef REGMAP_CONFIG_H_
+#define REGMAP_CONFIG_H_
+
+/**	Largest number of registers flagged @link REGMAP_CACHED @endlink in a @link regmap_map_struct_t @endlink. Each one takes 1 byte of RAM in every @link regmap_struct_t @endlink. Must not be greater than 8, checked at compile time. A map with more cached registers is reported by regmap_init and its extra ones aren't cached.
+*/
+#define REGMAP_CACHE_SIZE	8
+
+#endif /* REGMAP_CONFIG_H_ */
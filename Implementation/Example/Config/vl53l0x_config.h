@@ -9,4 +9,24 @@
 #ifndef VL53L0X_CONFIG_H_
 #define VL53L0X_CONFIG_H_
 
-#endif /* VL53L0X_CONFIG_H_ */
\ No newline at end of file
+/**	Highest I2C frequency in Hz used with the sensors. 400 kHz fast mode is the most the VL53L0X supports.
+*/
+#define VL53L0X_I2C_FREQUENCY	400000
+
+/**	Maximum number of sensors handled by a @link vl53l0x_array_struct_t @endlink. Sensor masks are 8 bit wide, so do not go above 8.
+*/
+#define VL53L0X_ARRAY_MAX_SENSORS	8
+
+/**	Keeps per sensor I2C counters and a sample latency histogram, see @link vl53l0x_statistics_struct_t @endlink. Costs a few cycles per transfer and @link VL53L0X_LATENCY_BINS @endlink * 2 + 22 bytes of RAM per sensor.
+*/
+//#define VL53L0X_STATISTICS
+
+/**	Number of samples in the running median of a @link vl53l0x_filter_struct_t @endlink. Odd, small values keep the update cheap: 3 removes single spikes, 5 removes two consecutive ones.
+*/
+#define VL53L0X_FILTER_MEDIAN_SIZE	5
+
+/**	Number of samples kept by a @link vl53l0x_history_struct_t @endlink. Each one takes 13 bytes of RAM. Must not be greater than 255.
+*/
+#define VL53L0X_HISTORY_SIZE	16
+
+#endif /* VL53L0X_CONFIG_H_ */
@@ -6,14 +6,25 @@
 #include "debug.h"
 #include "timer.h"
 #include "vl53l0x.h"
+#include "vl53l0x_adaptive.h"
+#include "vl53l0x_array.h"
+#include "vl53l0x_filter.h"
+#include "vl53l0x_history.h"
 #include <util/delay.h>
 
+#include <avr/eeprom.h>
 #include <avr/interrupt.h>
 
 timer_struct_t s_timeoutTimer;
 vl53l0x_struct_t s_frontSensor;
-vl53l0x_struct_t s_leftSensor;
-vl53l0x_struct_t s_rightSensor;
+gpio_struct_t s_frontSensorInterrupt;
+volatile bool obstacleFlag = FALSE;
+vl53l0x_filter_struct_t s_frontFilter;
+vl53l0x_adaptive_struct_t s_frontAdaptive;
+vl53l0x_history_struct_t s_frontHistory;
+vl53l0x_calibration_struct_t EEMEM s_frontCalibrationStore;
+vl53l0x_struct_t as_sensors[3];
+vl53l0x_array_struct_t s_sensorArray;
 
 void distanceSensor_init()
 {
@@ -73,11 +84,11 @@ void distanceSensor_sleepTest()
 				i++;
 			}
 		}
-		vl53l0x_stop(&s_frontSensor);
+		/* Standby keeps the configuration, resuming only restarts ranging */
+		vl53l0x_standby(&s_frontSensor);
 		_delay_ms(3000);
 		i = 0;
-		vl53l0x_start(&s_frontSensor);
-		vl53l0x_startContinuous(&s_frontSensor, 30);
+		vl53l0x_resume(&s_frontSensor);
 	}
 }
 
@@ -145,23 +156,178 @@ void distanceSensor_singleTest()
 	}
 }
 
+void distanceSensor_filterTest()
+{
+	vl53l0x_start(&s_frontSensor);
+	vl53l0x_startContinuous(&s_frontSensor, 0);
+
+	s_frontFilter.ps_sensor = &s_frontSensor;
+	/* 0.25 MCPS */
+	s_frontFilter.minSignalRate = 32;
+	s_frontFilter.maxRange = 2000;
+	s_frontFilter.emaShift = 2;
+	vl53l0x_filter_init(&s_frontFilter);
+
+	while (1)
+	{
+		if (vl53l0x_filter_update(&s_frontFilter) == VL53L0X_FILTER_FILTERED)
+		{
+			debug_writeDecimal(s_frontFilter.range);
+			debug_writeNewLine();
+		}
+	}
+}
+
+void distanceSensor_adaptiveTest()
+{
+	vl53l0x_start(&s_frontSensor);
+
+	s_frontAdaptive.ps_sensor = &s_frontSensor;
+	s_frontAdaptive.continuous = TRUE;
+	s_frontAdaptive.rangingPeriod = 0;
+	s_frontAdaptive.nearRange = 200;
+	s_frontAdaptive.farRange = 1000;
+	s_frontAdaptive.fastVelocity = 500;
+	s_frontAdaptive.slowVelocity = 100;
+	s_frontAdaptive.noisyVariance = 400;
+	s_frontAdaptive.hysteresisShift = 3;
+	s_frontAdaptive.dwell = 4;
+	vl53l0x_adaptive_init(&s_frontAdaptive);
+
+	s_frontFilter.ps_sensor = &s_frontSensor;
+	s_frontFilter.minSignalRate = 32;
+	s_frontFilter.maxRange = 2000;
+	s_frontFilter.emaShift = 1;
+	vl53l0x_filter_init(&s_frontFilter);
+
+	/* Should come from the motion controller */
+	vl53l0x_adaptive_setVelocity(&s_frontAdaptive, 300);
+
+	while (1)
+	{
+		if (vl53l0x_filter_update(&s_frontFilter) != VL53L0X_FILTER_STALE)
+		{
+			if (vl53l0x_adaptive_update(&s_frontAdaptive, s_frontFilter.range))
+			{
+				debug_writeString("Mode ");
+				debug_writeDecimal(s_frontAdaptive.e_mode);
+				debug_writeNewLine();
+			}
+		}
+	}
+}
+
+void distanceSensor_historyTest()
+{
+	vl53l0x_historyIterator_struct_t s_iterator;
+	vl53l0x_record_struct_t const * ps_record;
+	u32 printed = 0;
+	u32 now;
+
+	vl53l0x_start(&s_frontSensor);
+	vl53l0x_startContinuous(&s_frontSensor, 0);
+
+	s_frontHistory.ps_sensor = &s_frontSensor;
+	vl53l0x_history_init(&s_frontHistory);
+
+	while (1)
+	{
+		vl53l0x_history_update(&s_frontHistory);
+
+		/* Every 8 samples, print the ones read during the last 100 ms with their age */
+		if (vl53l0x_history_countSince(&s_frontHistory, printed) >= 8)
+		{
+			printed = s_frontHistory.pushCount;
+			now = vl53l0x_getMilliseconds();
+			vl53l0x_history_window(&s_frontHistory, &s_iterator, now - 100, now);
+			while ((ps_record = vl53l0x_history_next(&s_iterator)) != NULL)
+			{
+				debug_writeDecimal(ps_record->s_sample.range);
+				debug_writeChar('@');
+				debug_writeDecimal(now - ps_record->timestamp);
+				debug_writeChar(' ');
+			}
+			debug_writeNewLine();
+		}
+	}
+}
+
+void distanceSensor_calibrationTest()
+{
+	u16 distance;
+	vl53l0x_calibration_struct_t s_calibration;
+
+	vl53l0x_start(&s_frontSensor);
+	vl53l0x_setMode(&s_frontSensor, VL53L0X_MAX_SPEED);
+
+	/* Calibrate once behind the cover glass, then restore from EEPROM at each power up */
+	eeprom_read_block(&s_calibration, &s_frontCalibrationStore, sizeof(s_calibration));
+	if (s_calibration.valid == TRUE)
+		vl53l0x_setCalibration(&s_frontSensor, &s_calibration);
+	else
+	{
+		debug_writeString("White target at 100mm");
+		debug_writeNewLine();
+		_delay_ms(5000);
+		vl53l0x_calibrateOffset(&s_frontSensor, 100, 20);
+		debug_writeString("Grey target at 600mm");
+		debug_writeNewLine();
+		_delay_ms(5000);
+		vl53l0x_calibrateCrosstalk(&s_frontSensor, 600, 20);
+		debug_writeString("White target at 100mm");
+		debug_writeNewLine();
+		_delay_ms(5000);
+		vl53l0x_calibrateOffset(&s_frontSensor, 100, 20);
+		eeprom_update_block(vl53l0x_getCalibration(&s_frontSensor), &s_frontCalibrationStore, sizeof(s_calibration));
+	}
+
+	vl53l0x_startContinuous(&s_frontSensor, 0);
+
+	while (1)
+	{
+		distance = vl53l0x_readRangeContinuous(&s_frontSensor);
+		if (distance != 0xffff)
+		{
+			debug_writeDecimal(distance);
+			debug_writeNewLine();
+		}
+	}
+}
+
+void distanceSensor_obstacleInterrupt()
+{
+	obstacleFlag = TRUE;
+}
+
 void distanceSensor_obstacleTest()
 {
 	u16 distance;
 	u16 obstacleDistance = 100;
 
+	s_frontSensorInterrupt.port = PD;
+	s_frontSensorInterrupt.number = 6;
+	gpio_init(s_frontSensorInterrupt);
+	gpio_attachInterrupt(s_frontSensorInterrupt, INTERRUPT_TOGGLE, distanceSensor_obstacleInterrupt);
+	gpio_enableInterrupt(s_frontSensorInterrupt, INTERRUPT_TOGGLE);
+
 	vl53l0x_start(&s_frontSensor);
+	/* Only samples closer than the obstacle distance raise the interrupt */
+	vl53l0x_setInterruptMode(&s_frontSensor, VL53L0X_INTERRUPT_LEVEL_LOW, obstacleDistance, 0);
 	vl53l0x_startContinuous(&s_frontSensor, 30);
 
 	while (1)
 	{
-		distance = vl53l0x_readRangeContinuous(&s_frontSensor);
-		if (distance != 0xffff)
+		/* The MCU could sleep here, nothing is read from the sensor until the GPIO1 pin changes */
+		if (obstacleFlag)
 		{
-			if (distance < obstacleDistance)
-				debug_writeString("Obstacle");
-			else
-				debug_writeString("Clear");
+			obstacleFlag = FALSE;
+			distance = vl53l0x_readRangeContinuous(&s_frontSensor);
+			if (distance != 0xffff)
+			{
+				debug_writeString("Obstacle ");
+				debug_writeDecimal(distance);
+				debug_writeNewLine();
+			}
 		}
 	}
 }
@@ -175,70 +341,68 @@ void distanceSensor_multiInit()
 	timer_enableInterrupt(s_timeoutTimer, OVERFLOW);
 	timer_start(s_timeoutTimer);
 
-	s_frontSensor.address = VL53L0X_ADDRESS_DEFAULT;
-	s_frontSensor.i2cTimeout = 100;
-	s_frontSensor.xshutPin.port = PD;
-	s_frontSensor.xshutPin.number = 7;
+	as_sensors[0].i2cTimeout = 100;
+	as_sensors[0].xshutPin.port = PC;
+	as_sensors[0].xshutPin.number = 2;
+
+	as_sensors[1].i2cTimeout = 100;
+	as_sensors[1].xshutPin.port = PD;
+	as_sensors[1].xshutPin.number = 7;
 
-	s_leftSensor.address = VL53L0X_ADDRESS_DEFAULT;
-	s_leftSensor.i2cTimeout = 100;
-	s_leftSensor.xshutPin.port = PC;
-	s_leftSensor.xshutPin.number = 2;
+	as_sensors[2].i2cTimeout = 100;
+	as_sensors[2].xshutPin.port = PC;
+	as_sensors[2].xshutPin.number = 3;
 
-	s_rightSensor.address = VL53L0X_ADDRESS_DEFAULT;
-	s_rightSensor.i2cTimeout = 100;
-	s_rightSensor.xshutPin.port = PC;
-	s_rightSensor.xshutPin.number = 3;
+	s_sensorArray.ps_sensors = as_sensors;
+	s_sensorArray.sensorCount = 3;
+	s_sensorArray.firstAddress = VL53L0X_ADDRESS_DEFAULT + 1;
+	s_sensorArray.mode = VL53L0X_DEFAULT;
+	s_sensorArray.rangingPeriod = 0;
+	s_sensorArray.singleShot = FALSE;
 
 	sei();
 
-	vl53l0x_init(&s_frontSensor);
-	vl53l0x_init(&s_leftSensor);
-	vl53l0x_init(&s_rightSensor);
+	vl53l0x_array_init(&s_sensorArray);
 }
 
 void distanceSensor_multiDefaultTest()
 {
+	u8 i;
 
-	u16 distance;
-	vl53l0x_start(&s_leftSensor);
-	vl53l0x_setAddress(&s_leftSensor, s_leftSensor.address + 1);
-	vl53l0x_setMode(&s_leftSensor, VL53L0X_DEFAULT);
-	vl53l0x_startContinuous(&s_leftSensor, 0);
-	
-	vl53l0x_start(&s_rightSensor);
-	vl53l0x_setAddress(&s_rightSensor, s_rightSensor.address + 2);
-	vl53l0x_setMode(&s_rightSensor, VL53L0X_DEFAULT);
-	vl53l0x_startContinuous(&s_rightSensor, 0);
-	
-	vl53l0x_start(&s_frontSensor);
-	vl53l0x_setMode(&s_frontSensor, VL53L0X_DEFAULT);
-	vl53l0x_startContinuous(&s_frontSensor, 0);
+	vl53l0x_array_start(&s_sensorArray);
 
 	while (1)
 	{
-	   
 		/* This can be put in a scheduler if no GPIO pin from the sensor is available */
-		distance = vl53l0x_readRangeContinuous(&s_leftSensor);
-		if (distance != 0xffff)
+		if (vl53l0x_array_read(&s_sensorArray) != 0)
 		{
-			debug_writeDecimal(distance);
-			debug_writeChar(' ');
+			for (i = 0; i < s_sensorArray.sensorCount; i++)
+			{
+				debug_writeDecimal(s_sensorArray.au16_ranges[i]);
+				debug_writeChar(' ');
+			}
+			debug_writeNewLine();
 		}
-		
-		distance = vl53l0x_readRangeContinuous(&s_frontSensor);
-		if (distance != 0xffff)
+	}
+}
+
+void distanceSensor_multiBatchTest()
+{
+	u8 i;
+
+	s_sensorArray.singleShot = TRUE;
+	vl53l0x_array_start(&s_sensorArray);
+
+	while (1)
+	{
+		/* All the sensors range at the same time, a sample set takes about one timing budget */
+		vl53l0x_array_measure(&s_sensorArray);
+		for (i = 0; i < s_sensorArray.sensorCount; i++)
 		{
-			debug_writeDecimal(distance);
+			debug_writeDecimal(s_sensorArray.au16_ranges[i]);
 			debug_writeChar(' ');
 		}
-		
-		distance = vl53l0x_readRangeContinuous(&s_rightSensor);
-		if (distance != 0xffff)
-		{
-			debug_writeDecimal(distance);
-			debug_writeNewLine();
-		}
+		debug_writeNewLine();
+		_delay_ms(100);
 	}
 }
-
@@ -3,14 +3,19 @@
 	@author		Adrian Grosu
 	@version	1.0
 	@date		31.10.2017
-	@details	Supports encoders with 2 pin outputs
+	@details	Supports quadrature encoders with 2 pin outputs. Every edge of either output is decoded through a state transition table, so the counter has 4 counts per encoder cycle and goes down when the wheel turns backwards.
+				Any number of encoders up to @link ENCODER_MAX_ENCODERS @endlink can be used. Each one is bound to the interrupts of its own pins only, so an edge costs the same whatever the number of encoders.
+				Transitions where both outputs changed at once can't be decoded. They are counted in illegalTransitions instead, a growing value means edges are missed.
 				1. Initialize a @link encoder_struct_t @endlink. You do not need to initialize the structure members beforehand, you only have to declare them and set their values.
 				2. Pass it to @link encoder_init @endlink.
 				3. Call @link encoder_start @endlink.
-				4. Call @link encoder_getCounter @endlink when needed to check the number of impulses
+				4. Call @link encoder_getCounter @endlink when needed to check the number of impulses. It is positive when output A leads output B.
+				- Set f_clock and call @link encoder_getDelta @endlink periodically to get the counts and the time since the previous call, taken in the same instant.
+				- Call @link encoder_getIllegalTransitions @endlink to check the signal quality.
 				- You can reset the counter by calling @link encoder_resetCounter @endlink.
 				- You can stop the encoders by calling @link encoder_stop @endlink.
 	@remark		@link encoder_stop @endlink doesn't reset the value of the counter, it only disables the interrupts.
+				The counters are updated from interrupts, the functions read them with the interrupts disabled for the copy only.
 */
 
 
@@ -23,66 +28,115 @@
 /************************************************************************/
 
 #include "gpio.h"
+#include "gpioFast.h"
 #include "math.h"
 #include "uart.h"
+#include "encoder_config.h"
 
 /************************************************************************/
 /* Defines, enums, structs, types                                       */
 /************************************************************************/
 
+/** Clock giving the elapsed time to @link encoder_getDelta @endlink. Any free running counter works. It is read with the interrupts enabled, between two copies of the counter, and read again if an edge came meanwhile. A short one, like a timer register read, pairs the counter and time best.
+*/
+typedef u32 (*encoder_clock_t)(void);
+
+/** Counts and time since the previous @link encoder_getDelta @endlink
+*/
+typedef struct encoder_delta_struct_t{
+/** Signed counter change */
+	s32 counts;
+/** Clock ticks elapsed */
+	u32 elapsed;
+}encoder_delta_struct_t;
+
 /** Encoder configuration structure
 */
 
 typedef struct encoder_struct_t{
-/** Counter for the number of impulses generated by the encoder*/
-	u32 counter;
-/** The last state of the 2 encoder outputs */
+/** Signed counter of the edges generated by the encoder, 4 per encoder cycle */
+	volatile s32 counter;
+/** Number of transitions where both outputs changed at once */
+	volatile u32 illegalTransitions;
+/** The last state of the 2 encoder outputs, (A << 1) | B */
 	u8 lastState;
-/** The current state of the 2 encoder outputs*/
-	u8 currentState;
 /** First output pin of the encoder */
 	gpio_struct_t A;
 /** Second output pin of the encoder */
 	gpio_struct_t B;
+/** Registers of the first output pin, read by the interrupt handler
+	@remark	Do not modify!
+*/
+	gpioFast_struct_t s_fastA;
+/** Registers of the second output pin, read by the interrupt handler
+	@remark	Do not modify!
+*/
+	gpioFast_struct_t s_fastB;
 /** Pointer to counter handling function */
 	void (*p_countCallback)(void);
+/** Clock for @link encoder_getDelta @endlink, NULL if the elapsed time isn't needed */
+	encoder_clock_t f_clock;
+/** Counter at the previous @link encoder_getDelta @endlink
+	@remark	Do not modify!
+*/
+	s32 deltaCounter;
+/** Clock at the previous @link encoder_getDelta @endlink
+	@remark	Do not modify!
+*/
+	u32 deltaTime;
 }encoder_struct_t;
 
 /************************************************************************/
 /* Exported functions                                                   */
 /************************************************************************/
 
-/** Initializes encoder driver.
-	@remark		Must be called before any other encoder function
+/** Initializes encoder driver and registers the encoder.
+	@remark		Must be called before any other encoder function. The encoder structure must stay in place as long as its interrupts are used.
 	@param[in]	s_encoder: encoder parameters to initialize
+	@return		FALSE if @link ENCODER_MAX_ENCODERS @endlink encoders are already registered
 */
-void encoder_init(encoder_struct_t *s_encoder);
+bool encoder_init(encoder_struct_t *s_encoder);
 
 /** Starts encoder driver.
 	@pre		Must be called after the encoder was initialized (with @link encoder_init @endlink).
 	@param[in]	s_encoder: encoder peripheral to use
 */
-void encoder_start(encoder_struct_t s_encoder);
+void encoder_start(encoder_struct_t *s_encoder);
 
 /** Stops encoder driver.
 	@pre		Must be called after the encoder was initialized (with @link encoder_init @endlink).
 	@param[in]	s_encoder: encoder peripheral to use
 */
-void encoder_stop(encoder_struct_t s_encoder);
+void encoder_stop(encoder_struct_t *s_encoder);
 
 /** Returns the impulse counter for the specified encoder peripheral.
 	@pre		Must be called after the encoder was initialized (with @link encoder_init @endlink).
 	@param[in]	s_encoder: encoder peripheral to use
-	@return		32 bit unsigned value of the counter
+	@return		32 bit signed value of the counter
 */
-u32 encoder_getCounter(encoder_struct_t s_encoder);
+s32 encoder_getCounter(encoder_struct_t *s_encoder);
 
-/** Resets the impulse counter for the specified encoder peripheral.
+/** Returns the number of transitions which couldn't be decoded because both outputs changed at once.
+	@pre		Must be called after the encoder was initialized (with @link encoder_init @endlink).
+	@param[in]	s_encoder: encoder peripheral to use
+	@return		Number of illegal transitions since the last reset
+*/
+u32 encoder_getIllegalTransitions(encoder_struct_t *s_encoder);
+
+/** Resets the impulse counter and the illegal transition counter for the specified encoder peripheral.
 	@pre		Must be called after the encoder was initialized (with @link encoder_init @endlink).
 	@param[in]	s_encoder: encoder peripheral to use
 */
 void encoder_resetCounter(encoder_struct_t *s_encoder);
 
-double encoder_getDistanceCm(encoder_struct_t s_encoder);
+/** Returns the counter change and the elapsed time since the previous call, both sampled together. The first call after @link encoder_init @endlink or @link encoder_resetCounter @endlink measures from that call.
+	@remark		The pairing is exact unless edges keep coming during every read of f_clock. After a few tries the last counter copy is taken, off by the edges of one clock read.
+	@pre		Must be called after the encoder was initialized (with @link encoder_init @endlink).
+	@param[in]	s_encoder: encoder peripheral to use
+	@param[out]	ps_delta: counts and clock ticks, elapsed is 0 without f_clock
+*/
+void encoder_getDelta(encoder_struct_t *s_encoder, encoder_delta_struct_t *ps_delta);
+
+double encoder_getDistanceCm(encoder_struct_t *s_encoder);
 
 #endif /* ENCODER_H_ */
\ No newline at end of file
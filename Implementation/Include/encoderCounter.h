@@ -0,0 +1,96 @@
+/**	@file		encoderCounter.h
+	@brief		Encoder counting in a hardware timer
+	@details	Counts the edges of one encoder output in a timer clocked from its external pin (Tn), so no interrupt runs per edge and the CPU cost doesn't depend on the wheel speed.
+				The timer only counts up. The direction is taken at each update, either from a direction level on a pin or from a function returning the commanded motor direction, and the edges counted since the previous update get its sign.
+				The hardware count is 8 or 16 bit. The overflow interrupt of the timer adds 256 or 65536 to a software high part, so the count is 32 bit and no edge is lost however far apart the updates are.
+				Basic flow:
+				1. Connect the encoder output to the Tn pin of the timer and define ENCODERCOUNTER_USING_TIMERn in encoder_config.h. Do not use the timer for anything else, nor enable it in the HAL timer configuration.
+				2. Initialize a @link encoderCounter_struct_t @endlink and pass it to @link encoderCounter_init @endlink.
+				3. Call @link encoderCounter_update @endlink periodically, for instance from a scheduler task.
+				- Read the counter with @link encoderCounter_getCounter @endlink, reset it with @link encoderCounter_resetCounter @endlink.
+	@remark		A raw quadrature output B can't be the direction pin, its level between edges doesn't tell the direction. Use the direction output of a quadrature decoder, or the commanded direction for single channel encoders.
+*/
+
+#ifndef ENCODERCOUNTER_H_
+#define ENCODERCOUNTER_H_
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include "types.h"
+#include "gpio.h"
+#include "gpioFast.h"
+#include "timer.h"
+#include "encoder_config.h"
+
+/************************************************************************/
+/* Defines, enums, structs, types                                       */
+/************************************************************************/
+
+/**	Returns the commanded direction: positive to count up, negative to count down, 0 to keep the previous direction
+*/
+typedef s8 (*encoderCounter_direction_t)(void);
+
+/**	Encoder counted by a timer
+*/
+typedef struct encoderCounter_struct_t
+{
+/**	Timer counting the encoder edges: TIMER0, TIMER1 or TIMER3
+*/
+	timer_peripheral_enum_t peripheral;
+/**	Direction pin, high counts up. Only used if f_direction is NULL.
+*/
+	gpio_struct_t direction;
+/**	Commanded direction, NULL to use the direction pin
+*/
+	encoderCounter_direction_t f_direction;
+/**	Signed counter of the edges
+	@remark	Do not modify!
+*/
+	s32 counter;
+/**	Extended timer value at the last update
+	@remark	Do not modify!
+*/
+	u32 lastCount;
+/**	Direction of the last update, 1 or -1
+	@remark	Do not modify!
+*/
+	s8 sign;
+/**	Registers of the direction pin
+	@remark	Do not modify!
+*/
+	gpioFast_struct_t s_fastDirection;
+}encoderCounter_struct_t;
+
+/************************************************************************/
+/* Exported functions                                                   */
+/************************************************************************/
+
+/**	Sets the timer to count the rising edges of its Tn pin, enables its overflow interrupt and resets the counter.
+	@param[in]	ps_encoder: encoder to initialize
+	@return		FALSE if the timer can't count external edges or isn't enabled in encoder_config.h
+*/
+bool encoderCounter_init(encoderCounter_struct_t* ps_encoder);
+
+/**	Adds the edges counted by the timer since the previous update, with the current direction.
+	@pre		Must be called after the encoder was initialized (with @link encoderCounter_init @endlink).
+	@param[in]	ps_encoder: encoder to update
+	@return		The updated counter
+*/
+s32 encoderCounter_update(encoderCounter_struct_t* ps_encoder);
+
+/**	Returns the counter as of the last update.
+	@pre		Must be called after the encoder was initialized (with @link encoderCounter_init @endlink).
+	@param[in]	ps_encoder: encoder to use
+	@return		32 bit signed value of the counter
+*/
+s32 encoderCounter_getCounter(encoderCounter_struct_t* ps_encoder);
+
+/**	Resets the counter. The edges counted since the last update are dropped.
+	@pre		Must be called after the encoder was initialized (with @link encoderCounter_init @endlink).
+	@param[in]	ps_encoder: encoder to use
+*/
+void encoderCounter_resetCounter(encoderCounter_struct_t* ps_encoder);
+
+#endif /* ENCODERCOUNTER_H_ */
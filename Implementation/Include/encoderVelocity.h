@@ -0,0 +1,117 @@
+/**	@file		encoderVelocity.h
+	@brief		Wheel velocity from timestamped encoder edges
+	@details	Estimates the velocity of a quadrature encoder with the M/T method: every period it counts the encoder cycles since the previous estimate and divides them by the time between the first and the last of their edges, both timestamped by an input capture unit.
+				At high speed many cycles fall in a period and the estimate is an edge count over an exactly measured time. At low speed a period holds one cycle or none and the estimate becomes the inverse of the cycle time.
+				Without any edge the velocity can't be higher than one cycle over the time since the last edge, so it decays towards 0 and is 0 after @link ENCODERVELOCITY_STOP_TIME_MS @endlink. The first edge after the stop only starts a new measurement.
+				Basic flow:
+				1. Connect output A of the encoder to an input capture pin (ICPn) and set the capture on rising edges. Output B may be on any pin.
+				2. Initialize a @link encoderVelocity_struct_t @endlink and pass it to @link encoderVelocity_init @endlink.
+				3. Call @link encoderVelocity_capture @endlink with the captured timer value (ICRn) from the input capture interrupt.
+				4. Call @link encoderVelocity_update @endlink periodically, for instance from a scheduler task, then read velocity and latency.
+	@remark		The capture timer must run from a 16 bit counter. The update period must be shorter than 32768 timer ticks.
+*/
+
+#ifndef ENCODERVELOCITY_H_
+#define ENCODERVELOCITY_H_
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include "types.h"
+#include "gpio.h"
+#include "gpioFast.h"
+#include "encoder_config.h"
+
+/************************************************************************/
+/* Defines, enums, structs, types                                       */
+/************************************************************************/
+
+/**	Encoder counts per captured edge: one rising edge of output A per cycle, 4 counts per cycle
+*/
+#define ENCODERVELOCITY_COUNTS_PER_EDGE	4
+
+/**	Free running 16 bit timer the captures are taken from, usually returns TCNTn. It is read with the interrupts disabled.
+*/
+typedef u16 (*encoderVelocity_timer_t)(void);
+
+/**	Velocity estimator of one encoder
+*/
+typedef struct encoderVelocity_struct_t
+{
+/**	Output B of the encoder, read on each capture to get the direction
+*/
+	gpio_struct_t B;
+/**	Frequency of the capture timer in Hz, at least 1 kHz
+*/
+	u32 timerFrequency;
+/**	Reads the capture timer
+*/
+	encoderVelocity_timer_t f_timer;
+/**	Signed velocity in encoder counts per second, with @link ENCODERVELOCITY_FRACTION_BITS @endlink fractional bits. Positive when output A leads output B, like the encoder counter.
+*/
+	s32 velocity;
+/**	Age of velocity in timer ticks when it was computed: time from the middle of the measured edges to the update
+*/
+	u32 latency;
+/**	Registers of output B
+	@remark	Do not modify!
+*/
+	gpioFast_struct_t s_fastB;
+/**	Captures since the last update, signed by direction
+	@remark	Do not modify!
+*/
+	volatile s16 edges;
+/**	Captures since the last update
+	@remark	Do not modify!
+*/
+	volatile u16 captures;
+/**	Timer value of the last capture
+	@remark	Do not modify!
+*/
+	volatile u16 lastCapture;
+/**	Timer value at the last update
+	@remark	Do not modify!
+*/
+	u16 lastUpdate;
+/**	Timer ticks from the last edge used to the last update
+	@remark	Do not modify!
+*/
+	u32 sinceEdge;
+/**	Whether an edge was seen since the estimator was initialized or stopped
+	@remark	Do not modify!
+*/
+	bool edgeSeen;
+}encoderVelocity_struct_t;
+
+/************************************************************************/
+/* Exported functions                                                   */
+/************************************************************************/
+
+/**	Initializes the estimator. The velocity starts at 0.
+	@param[in]	ps_velocity: estimator to initialize, with B, timerFrequency and f_timer set
+*/
+void encoderVelocity_init(encoderVelocity_struct_t* ps_velocity);
+
+/**	Records a rising edge of output A.
+	@remark		Call it from the input capture interrupt only.
+	@param[in]	ps_velocity: estimator of the encoder
+	@param[in]	u16_timestamp: captured timer value
+*/
+void encoderVelocity_capture(encoderVelocity_struct_t* ps_velocity, u16 u16_timestamp);
+
+/**	Computes the velocity from the edges captured since the previous call.
+	@pre		Must be called after the estimator was initialized (with @link encoderVelocity_init @endlink).
+	@remark		The interrupts are disabled only while the capture state is copied.
+	@param[in]	ps_velocity: estimator of the encoder
+	@return		The new velocity, also kept in velocity
+*/
+s32 encoderVelocity_update(encoderVelocity_struct_t* ps_velocity);
+
+/**	Converts the latency of the last update to microseconds.
+	@param[in]	ps_velocity: estimator of the encoder
+	@return		Latency in microseconds
+*/
+u32 encoderVelocity_getLatencyUs(encoderVelocity_struct_t* ps_velocity);
+
+#endif /* ENCODERVELOCITY_H_ */
@@ -0,0 +1,89 @@
+/**	@file		gpioFast.h
+	@brief		Fast access to GPIO pins from interrupt handlers
+	@details	The HAL GPIO functions find the registers of a pin from its port on every call. This module does it once, so a pin is then read or written with a single register access.
+				Basic flow:
+				1. Initialize the pin with the HAL (gpio_init).
+				2. Pass it to @link gpioFast_init @endlink to fill a @link gpioFast_struct_t @endlink.
+				3. Use @link gpioFast_read @endlink, @link gpioFast_set @endlink, @link gpioFast_reset @endlink and @link gpioFast_toggle @endlink, also from interrupt handlers.
+	@remark		The direction and pullup of the pin aren't changed by this module.
+*/
+
+#ifndef GPIOFAST_H_
+#define GPIOFAST_H_
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include "types.h"
+#include "gpio.h"
+
+/************************************************************************/
+/* Defines, enums, structs, types                                       */
+/************************************************************************/
+
+/**	Registers of a pin, resolved once
+*/
+typedef struct gpioFast_struct_t
+{
+/**	Input register (PINx) of the port
+*/
+	volatile u8* pu8_pin;
+/**	Output register (PORTx) of the port
+*/
+	volatile u8* pu8_port;
+/**	Bit of the pin in the registers
+*/
+	u8 mask;
+}gpioFast_struct_t;
+
+/************************************************************************/
+/* Exported functions                                                   */
+/************************************************************************/
+
+/**	Resolves the registers of a pin.
+	@param[out]	ps_fast: registers of the pin
+	@param[in]	s_gpio: pin to resolve
+*/
+void gpioFast_init(gpioFast_struct_t* ps_fast, gpio_struct_t s_gpio);
+
+/**	Reads an input pin.
+	@pre		Must be called after the pin was resolved (with @link gpioFast_init @endlink).
+	@param[in]	ps_fast: pin to read
+	@return		0 if the pin is low, its mask otherwise
+*/
+static inline u8 gpioFast_read(gpioFast_struct_t const * ps_fast)
+{
+	return *ps_fast->pu8_pin & ps_fast->mask;
+}
+
+/**	Drives an output pin high.
+	@pre		Must be called after the pin was resolved (with @link gpioFast_init @endlink).
+	@remark		Read-modify-write of the output register, an interrupt changing the same port meanwhile loses its change.
+	@param[in]	ps_fast: pin to set
+*/
+static inline void gpioFast_set(gpioFast_struct_t const * ps_fast)
+{
+	*ps_fast->pu8_port |= ps_fast->mask;
+}
+
+/**	Drives an output pin low.
+	@pre		Must be called after the pin was resolved (with @link gpioFast_init @endlink).
+	@remark		Read-modify-write of the output register, an interrupt changing the same port meanwhile loses its change.
+	@param[in]	ps_fast: pin to reset
+*/
+static inline void gpioFast_reset(gpioFast_struct_t const * ps_fast)
+{
+	*ps_fast->pu8_port &= ~ps_fast->mask;
+}
+
+/**	Toggles an output pin. Writing the input register toggles only the pins written as 1, so no other pin of the port is touched.
+	@pre		Must be called after the pin was resolved (with @link gpioFast_init @endlink).
+	@param[in]	ps_fast: pin to toggle
+*/
+static inline void gpioFast_toggle(gpioFast_struct_t const * ps_fast)
+{
+	*ps_fast->pu8_pin = ps_fast->mask;
+}
+
+#endif /* GPIOFAST_H_ */
@@ -0,0 +1,271 @@
+/**	@file		i2cBus.h
+	@brief		Queued I2C transaction engine shared by all the devices of the bus
+	@details	Drivers describe each transfer with a @link i2cBus_transaction_struct_t @endlink and submit it to a queue. The bus works through the queue back to back.
+				With I2CBUS_INTERRUPT_MODE defined in i2cBus_config.h the transactions are driven by the TWI interrupt and the CPU keeps running while the bus is busy. Otherwise they run inside @link i2cBus_submit @endlink using the blocking HAL calls.
+				A transaction is one bus frame, from start to stop condition. It chains up to @link I2CBUS_MAX_SEGMENTS @endlink segments:
+				- @link i2cBus_addWrite @endlink and @link i2cBus_addRead @endlink begin a new message, with a repeated start if it isn't the first one.
+				- @link i2cBus_appendData @endlink continues the previous message without a repeated start, so a register index and its data can come from different buffers.
+				For instance "clear the interrupt, then read the status" is addWrite(clear) + addWrite(status index) + addRead(status), one frame instead of two.
+				Basic flow:
+				1. Call @link i2cBus_init @endlink with the bus frequency. Drivers using the bus call it too, only the first call has an effect.
+				2. Call @link i2cBus_begin @endlink on a @link i2cBus_transaction_struct_t @endlink, then add its segments. Optionally set f_callback and p_context.
+				3. Pass it to @link i2cBus_submit @endlink and carry on. The transaction is done once its status isn't @link I2CBUS_PENDING @endlink anymore, the callback is then called.
+				- @link i2cBus_transfer @endlink submits a transaction and waits for it, for drivers with a blocking API.
+				- Each device may carry a @link i2cBus_speed_struct_t @endlink set up with @link i2cBus_initSpeed @endlink. The bus switches to its frequency before each of its transactions,
+				  and lowers that frequency after @link I2CBUS_FALLBACK_FAILURES @endlink failed transactions in a row. Transactions without one run at the frequency given to @link i2cBus_init @endlink,
+				  so keep that one at the rate of the slowest device.
+				- With I2CBUS_TRACE defined in i2cBus_config.h, every transaction is recorded with its timestamps once a clock is given to @link i2cBus_setTraceClock @endlink.
+				  @link i2cBus_dumpTrace @endlink prints the records on the debug UART, for Tools/i2c_trace.py to turn into per device bus usage, idle gaps and hot registers.
+	@remark		The transaction and its buffers belong to the engine until it is done. Don't modify or reuse them before.
+	@remark		Only chain messages with repeated starts if the device accepts them. Otherwise use one transaction per message.
+*/
+
+#ifndef I2CBUS_H_
+#define I2CBUS_H_
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include "types.h"
+#include "i2cBus_config.h"
+
+/************************************************************************/
+/* Defines, enums, structs, types                                       */
+/************************************************************************/
+
+/**	Segment flag: bytes are read from the device. Otherwise they are written.
+*/
+#define I2CBUS_SEGMENT_READ		0x01
+/**	Segment flag: continues the message of the previous segment, without a repeated start
+*/
+#define I2CBUS_SEGMENT_CONTINUE	0x02
+
+/**	Trace record flag: the frame writes bytes to the device
+*/
+#define I2CBUS_TRACE_WRITE		0x01
+/**	Trace record flag: the frame reads bytes from the device
+*/
+#define I2CBUS_TRACE_READ		0x02
+/**	Trace record flag: the frame starts by writing a byte, which the record keeps as register
+*/
+#define I2CBUS_TRACE_REGISTER	0x04
+
+/**	State of a transaction
+*/
+typedef enum i2cBus_status_enum_t
+{
+/**	Queued or running */
+	I2CBUS_PENDING,
+/**	All the bytes were transferred */
+	I2CBUS_DONE,
+/**	The device didn't acknowledge its address or a written byte */
+	I2CBUS_NACK,
+/**	Bus error, for instance an illegal start or stop condition */
+	I2CBUS_ERROR
+}i2cBus_status_enum_t;
+
+/**	Part of a transaction: a buffer written to or read from the device
+*/
+typedef struct i2cBus_segment_struct_t
+{
+/**	Bytes to write or buffer for the bytes read. Written segments are never modified.
+*/
+	u8* pu8_data;
+/**	Number of bytes
+*/
+	u8 length;
+/**	Combination of I2CBUS_SEGMENT_READ and I2CBUS_SEGMENT_CONTINUE
+*/
+	u8 flags;
+}i2cBus_segment_struct_t;
+
+/**	Bus speed profile of a device
+*/
+typedef struct i2cBus_speed_struct_t
+{
+/**	Highest SCL frequency in Hz the device supports
+	@remark	Do not modify! Set by @link i2cBus_initSpeed @endlink.
+*/
+	u32 maxFrequency;
+/**	SCL frequency in Hz currently used with the device. Starts at maxFrequency and is halved after @link I2CBUS_FALLBACK_FAILURES @endlink failed transactions in a row, down to @link I2CBUS_MIN_FREQUENCY @endlink.
+	@remark	Do not modify!
+*/
+	u32 frequency;
+/**	TWBR value giving frequency, computed once per frequency change
+	@remark	Do not modify!
+*/
+	u8 bitRate;
+/**	Failed transactions in a row
+	@remark	Do not modify!
+*/
+	u8 failures;
+}i2cBus_speed_struct_t;
+
+/**	Transaction as recorded by the trace
+*/
+typedef struct i2cBus_traceRecord_struct_t
+{
+/**	Clock when the start condition was requested
+*/
+	u32 start;
+/**	Clock when the transaction was done
+*/
+	u32 end;
+/**	Bytes of the frame, address bytes included
+*/
+	u16 bytes;
+/**	7 bit address of the device
+*/
+	u8 address;
+/**	First byte written, the register index for most devices. Only valid with @link I2CBUS_TRACE_REGISTER @endlink.
+*/
+	u8 reg;
+/**	Combination of @link I2CBUS_TRACE_WRITE @endlink, @link I2CBUS_TRACE_READ @endlink and @link I2CBUS_TRACE_REGISTER @endlink
+*/
+	u8 flags;
+/**	Final @link i2cBus_status_enum_t @endlink of the transaction
+*/
+	u8 status;
+}i2cBus_traceRecord_struct_t;
+
+/**	Clock used to timestamp the trace. Any free running counter works, microseconds make the tool output readable. It is read from the TWI interrupt in interrupt mode.
+*/
+typedef u32 (*i2cBus_clock_t)(void);
+
+struct i2cBus_transaction_struct_t;
+
+/**	Function called when a transaction is done. In interrupt mode it runs inside the TWI interrupt, so keep it short. It may submit another transaction.
+*/
+typedef void (*i2cBus_callback_t)(struct i2cBus_transaction_struct_t* ps_transaction);
+
+/**	One bus frame with a device
+*/
+typedef struct i2cBus_transaction_struct_t
+{
+/**	7 bit address of the device
+	@remark	Do not modify! Set by @link i2cBus_begin @endlink.
+*/
+	u8 address;
+/**	Speed profile of the device. NULL runs the transaction at the frequency given to @link i2cBus_init @endlink.
+	@remark	Do not modify! Set by @link i2cBus_begin @endlink.
+*/
+	i2cBus_speed_struct_t* ps_speed;
+/**	Segments in bus order
+	@remark	Do not modify! Filled by @link i2cBus_addWrite @endlink, @link i2cBus_addRead @endlink and @link i2cBus_appendData @endlink.
+*/
+	i2cBus_segment_struct_t as_segments[I2CBUS_MAX_SEGMENTS];
+/**	Number of segments used
+	@remark	Do not modify!
+*/
+	u8 segmentCount;
+/**	Called when the transaction is done. May be NULL.
+*/
+	i2cBus_callback_t f_callback;
+/**	Free for the submitter, for instance to find its device from the callback
+*/
+	void* p_context;
+/**	State of the transaction
+	@remark	Do not modify!
+*/
+	volatile i2cBus_status_enum_t e_status;
+/**	Next transaction in the queue
+	@remark	Do not modify!
+*/
+	struct i2cBus_transaction_struct_t* ps_next;
+}i2cBus_transaction_struct_t;
+
+/************************************************************************/
+/* Exported functions                                                   */
+/************************************************************************/
+
+/**	Initializes the I2C peripheral. Only the first call has an effect, so every driver on the bus can call it.
+	@param[in]	u32_frequency: SCL frequency in Hz
+*/
+void i2cBus_init(u32 u32_frequency);
+
+/**	Sets up the speed profile of a device, starting at its highest frequency.
+	@remark		Call it again to go back to the highest frequency after a fallback, for instance once the device was reset.
+	@param[in]	ps_speed: speed profile to set up
+	@param[in]	u32_maxFrequency: highest SCL frequency in Hz the device supports
+*/
+void i2cBus_initSpeed(i2cBus_speed_struct_t* ps_speed, u32 u32_maxFrequency);
+
+/**	Empties a transaction and sets its device. The callback is cleared.
+	@param[in]	ps_transaction: transaction to build
+	@param[in]	u8_address: 7 bit address of the device
+	@param[in]	ps_speed: speed profile of the device, or NULL for the default bus frequency
+*/
+void i2cBus_begin(i2cBus_transaction_struct_t* ps_transaction, u8 u8_address, i2cBus_speed_struct_t* ps_speed);
+
+/**	Adds a message writing bytes to the device.
+	@param[in]	ps_transaction: transaction to build
+	@param[in]	pu8_data: bytes to write
+	@param[in]	u8_length: number of bytes. 0 only checks that the device answers.
+	@return		FALSE if the transaction has no segment left
+*/
+bool i2cBus_addWrite(i2cBus_transaction_struct_t* ps_transaction, u8 const * pu8_data, u8 u8_length);
+
+/**	Adds a message reading bytes from the device.
+	@param[in]	ps_transaction: transaction to build
+	@param[out]	pu8_data: buffer for the bytes read
+	@param[in]	u8_length: number of bytes, at least 1
+	@return		FALSE if the transaction has no segment left or u8_length is 0
+*/
+bool i2cBus_addRead(i2cBus_transaction_struct_t* ps_transaction, u8* pu8_data, u8 u8_length);
+
+/**	Continues the last message with another buffer, in the same direction.
+	@param[in]	ps_transaction: transaction to build
+	@param[in]	pu8_data: bytes to write, or buffer for the bytes read
+	@param[in]	u8_length: number of bytes, at least 1
+	@return		FALSE if the transaction has no segment left, no message yet or u8_length is 0
+*/
+bool i2cBus_appendData(i2cBus_transaction_struct_t* ps_transaction, u8* pu8_data, u8 u8_length);
+
+/**	Returns the number of bytes a transaction puts on the bus, address bytes included.
+	@param[in]	ps_transaction: transaction to use
+	@return		Number of bytes
+*/
+u16 i2cBus_getFrameBytes(i2cBus_transaction_struct_t const * ps_transaction);
+
+/**	Queues a transaction. The bus starts on it right away if it is idle.
+	@pre		Must be called after the bus was initialized (with @link i2cBus_init @endlink) and the transaction was built.
+	@remark		Without I2CBUS_INTERRUPT_MODE the transaction, and any other one queued meanwhile, is done when this returns.
+	@param[in]	ps_transaction: transaction to run
+	@return		FALSE if the transaction is still pending from an earlier submission
+*/
+bool i2cBus_submit(i2cBus_transaction_struct_t* ps_transaction);
+
+/**	Queues a transaction and waits until it is done.
+	@pre		Must be called after the bus was initialized (with @link i2cBus_init @endlink). Must not be called from an interrupt, nor from a transaction callback. In interrupt mode, interrupts must be enabled.
+	@param[in]	ps_transaction: transaction to run
+	@return		Final state of the transaction
+*/
+i2cBus_status_enum_t i2cBus_transfer(i2cBus_transaction_struct_t* ps_transaction);
+
+/**	Returns whether transactions are queued or running.
+	@return		TRUE until the queue is empty
+*/
+bool i2cBus_isBusy();
+
+#ifdef I2CBUS_TRACE
+/**	Starts recording the transactions with the given clock.
+	@param[in]	f_clock: clock read at the start and end of each transaction. NULL stops the recording.
+*/
+void i2cBus_setTraceClock(i2cBus_clock_t f_clock);
+
+/**	Takes the oldest record out of the trace.
+	@param[out]	ps_record: oldest record
+	@return		FALSE if the trace is empty
+*/
+bool i2cBus_popTrace(i2cBus_traceRecord_struct_t* ps_record);
+
+/**	Prints the recorded transactions on the debug UART, oldest first, and removes them from the trace.
+	@pre		The debug UART must be started (with debug_start).
+	@remark		Format: a line "I2CTRACE count dropped", one line per record "address register bytes flags status start end", then "END". All the values are hexadecimal.
+				dropped counts the records overwritten since the previous dump. Records added during the dump are left for the next one.
+*/
+void i2cBus_dumpTrace();
+#endif
+
+#endif /* I2CBUS_H_ */
@@ -0,0 +1,222 @@
+/**	@file		regmap.h
+	@brief		Register map access to I2C devices
+	@details	Describes a device by a constant table of its registers and gives typed, cached access to them over @link i2cBus.h @endlink, so drivers don't have to pack bytes or track register values themselves.
+				Registers missing from the table are 8 bit wide and volatile. Only the wider, little endian and cached registers have to be listed.
+				Basic flow:
+				1. Declare a constant array of @link regmap_register_struct_t @endlink and a @link regmap_map_struct_t @endlink pointing to it. Drivers usually keep both in their source file.
+				2. Call @link regmap_init @endlink on a @link regmap_struct_t @endlink with the map, the device address and its highest bus frequency.
+				3. Use @link regmap_read @endlink and @link regmap_write @endlink. Values are packed with the width and byte order of the register.
+				- Registers flagged @link REGMAP_CACHED @endlink are only changed by the driver. Reading them after the first access is answered from the cache and writing the value they already hold is skipped.
+				- Devices with paged registers name their page select register in the map. The register map follows the writes to it, so a register is found on the page it was declared on.
+				- @link regmap_writeSequence @endlink chains a list of 8 bit register writes into as few bus frames as possible, leaving out the ones the cache makes useless.
+				- @link regmap_readBlock @endlink and @link regmap_writeBlock @endlink move consecutive registers in one message, @link regmap_readBlockThenWrite @endlink adds a register write to the same frame.
+				- Call @link regmap_invalidate @endlink whenever the device is reset.
+				- Frames a driver submits itself, for instance to poll without waiting, start with @link regmap_beginFrame @endlink and are handed to @link regmap_endFrame @endlink when they finish, so they follow the page and cache state like the others.
+	@remark		The transfers wait for the bus, see @link i2cBus_transfer @endlink. A device which doesn't answer reads as 0xFF bytes.
+	@remark		Part of a failed frame may have reached the device, so the cache is forgotten after it and the next frame selects the page again.
+*/
+
+#ifndef REGMAP_H_
+#define REGMAP_H_
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include "i2cBus.h"
+#include "regmap_config.h"
+
+#if REGMAP_CACHE_SIZE > 8
+#error REGMAP_CACHE_SIZE must not be greater than 8, the bits of regmap_struct_t.cacheValid
+#endif
+
+/************************************************************************/
+/* Defines, enums, structs, types                                       */
+/************************************************************************/
+
+/**	Register flag: the value only changes when the driver writes it, so it can be cached. Only for 8 bit registers.
+*/
+#define REGMAP_CACHED			0x01
+/**	Register flag: the least significant byte comes first. Otherwise the most significant one does.
+*/
+#define REGMAP_LITTLE_ENDIAN	0x02
+
+/**	Description of a register
+*/
+typedef struct regmap_register_struct_t
+{
+/**	Page the register is on. 0 for devices without pages.
+*/
+	u8 page;
+/**	Address of the register, or of its first byte
+*/
+	u8 address;
+/**	Width in bytes: 1, 2 or 4
+*/
+	u8 width;
+/**	Combination of @link REGMAP_CACHED @endlink and @link REGMAP_LITTLE_ENDIAN @endlink
+*/
+	u8 flags;
+}regmap_register_struct_t;
+
+/**	Description of a device, shared by all the devices of the same kind
+*/
+typedef struct regmap_map_struct_t
+{
+/**	Registers which aren't 8 bit, big endian and volatile
+*/
+	regmap_register_struct_t const * as_registers;
+/**	Number of registers in as_registers
+*/
+	u8 registerCount;
+/**	Whether the device has a page select register
+*/
+	bool paged;
+/**	Address of the page select register, accessible on every page. Not used if paged is FALSE.
+*/
+	u8 pageRegister;
+}regmap_map_struct_t;
+
+/**	One device accessed through its register map
+*/
+typedef struct regmap_struct_t
+{
+/**	Description of the device
+	@remark	Do not modify!
+*/
+	regmap_map_struct_t const * ps_map;
+/**	7 bit address of the device. May be changed between two accesses, for instance after programming a new address into the device.
+*/
+	u8 address;
+/**	Bus speed profile of the device
+*/
+	i2cBus_speed_struct_t s_busSpeed;
+/**	Page selected by the driver
+	@remark	Do not modify!
+*/
+	u8 page;
+/**	FALSE after a failed transfer, until the page select is written again
+	@remark	Do not modify!
+*/
+	bool pageKnown;
+/**	Page select written at the start of the frame following a failed transfer
+	@remark	Do not modify!
+*/
+	u8 au8_pageSelect[2];
+/**	Values of the cached registers, in the order of the map
+	@remark	Do not modify!
+*/
+	u8 au8_cache[REGMAP_CACHE_SIZE];
+/**	Bit n is set if au8_cache[n] matches the device
+	@remark	Do not modify!
+*/
+	u8 cacheValid;
+/**	Bus frames sent to the device. Accesses answered from the cache aren't counted.
+*/
+	u32 transactions;
+/**	Bytes on the bus, including address and register bytes
+*/
+	u32 bytes;
+}regmap_struct_t;
+
+/************************************************************************/
+/* Exported functions                                                   */
+/************************************************************************/
+
+/**	Sets up the access to a device and initializes the bus if no one did yet.
+	@param[in]	ps_regmap: device to set up
+	@param[in]	ps_map: description of the device
+	@param[in]	u8_address: 7 bit address of the device
+	@param[in]	u32_maxFrequency: highest SCL frequency in Hz the device supports
+	@return		FALSE if the map flags more registers @link REGMAP_CACHED @endlink than @link REGMAP_CACHE_SIZE @endlink. The device is still usable, the registers beyond the cache size are accessed as volatile ones.
+*/
+bool regmap_init(regmap_struct_t* ps_regmap, regmap_map_struct_t const * ps_map, u8 u8_address, u32 u32_maxFrequency);
+
+/**	Forgets the cached values. The page goes back to 0, as on a device reset.
+	@remark		Call it after the device was reset.
+	@param[in]	ps_regmap: device to use
+*/
+void regmap_invalidate(regmap_struct_t* ps_regmap);
+
+/**	Starts a frame to the device for @link i2cBus_submit @endlink. If a failed transfer left the page unknown, the frame starts with the page select.
+	@pre		Must be called after the device was set up (with @link regmap_init @endlink).
+	@remark		Only for registers bypassing the cache. Don't start another access to the device until the frame was handed to @link regmap_endFrame @endlink.
+	@param[in]	ps_regmap: device to use
+	@param[out]	ps_transaction: transaction to start, its messages are added after the page select
+*/
+void regmap_beginFrame(regmap_struct_t* ps_regmap, i2cBus_transaction_struct_t* ps_transaction);
+
+/**	Accounts a finished frame started with @link regmap_beginFrame @endlink. It is counted, and after a failure its read buffers are filled with 0xFF and the cache and page are forgotten.
+	@remark		Call it from the transaction callback, also from the TWI interrupt.
+	@param[in]	ps_regmap: device to use
+	@param[in]	ps_transaction: finished transaction
+	@return		Final status of the transaction
+*/
+i2cBus_status_enum_t regmap_endFrame(regmap_struct_t* ps_regmap, i2cBus_transaction_struct_t* ps_transaction);
+
+/**	Reads a register with its width and byte order.
+	@pre		Must be called after the device was set up (with @link regmap_init @endlink).
+	@param[in]	ps_regmap: device to use
+	@param[in]	u8_register: address of the register on the current page
+	@return		Value of the register
+*/
+u32 regmap_read(regmap_struct_t* ps_regmap, u8 u8_register);
+
+/**	Writes a register with its width and byte order.
+	@pre		Must be called after the device was set up (with @link regmap_init @endlink).
+	@param[in]	ps_regmap: device to use
+	@param[in]	u8_register: address of the register on the current page
+	@param[in]	u32_value: value to write. Bits beyond the register width are ignored.
+*/
+void regmap_write(regmap_struct_t* ps_regmap, u8 u8_register, u32 u32_value);
+
+/**	Returns the cached value of a register without any bus access.
+	@pre		Must be called after the device was set up (with @link regmap_init @endlink).
+	@param[in]	ps_regmap: device to use
+	@param[in]	u8_page: page of the register
+	@param[in]	u8_register: address of the register
+	@param[out]	pu8_value: cached value
+	@return		FALSE if the register isn't cached or its value isn't known, for instance after a failed transfer
+*/
+bool regmap_getCached(regmap_struct_t* ps_regmap, u8 u8_page, u8 u8_register, u8* pu8_value);
+
+/**	Writes a list of 8 bit registers. The writes are chained into bus frames with repeated starts, writes of the value a cached register already holds are left out.
+	@pre		Must be called after the device was set up (with @link regmap_init @endlink).
+	@param[in]	ps_regmap: device to use
+	@param[in]	au8_writes: register and value pairs, in order
+	@param[in]	u8_count: number of pairs
+*/
+void regmap_writeSequence(regmap_struct_t* ps_regmap, u8 const (*au8_writes)[2], u8 u8_count);
+
+/**	Reads consecutive registers as raw bytes in one message.
+	@pre		Must be called after the device was set up (with @link regmap_init @endlink).
+	@remark		Bypasses the cache, so the block must not contain cached registers.
+	@param[in]	ps_regmap: device to use
+	@param[in]	u8_register: address of the first register
+	@param[out]	pu8_data: buffer for the bytes read
+	@param[in]	u8_length: number of bytes
+*/
+void regmap_readBlock(regmap_struct_t* ps_regmap, u8 u8_register, u8* pu8_data, u8 u8_length);
+
+/**	Writes consecutive registers as raw bytes in one message, without copying them.
+	@pre		Must be called after the device was set up (with @link regmap_init @endlink).
+	@remark		Bypasses the cache, so the block must not contain cached registers.
+	@param[in]	ps_regmap: device to use
+	@param[in]	u8_register: address of the first register
+	@param[in]	pu8_data: bytes to write
+	@param[in]	u8_length: number of bytes
+*/
+void regmap_writeBlock(regmap_struct_t* ps_regmap, u8 u8_register, u8 const * pu8_data, u8 u8_length);
+
+/**	Reads consecutive registers, then writes an 8 bit register in the same bus frame. Typically reads a result and acknowledges it.
+	@pre		Must be called after the device was set up (with @link regmap_init @endlink).
+	@param[in]	ps_regmap: device to use
+	@param[in]	u8_register: address of the first register to read
+	@param[out]	pu8_data: buffer for the bytes read
+	@param[in]	u8_length: number of bytes to read
+	@param[in]	u8_writeRegister: address of the register to write
+	@param[in]	u8_value: value to write
+*/
+void regmap_readBlockThenWrite(regmap_struct_t* ps_regmap, u8 u8_register, u8* pu8_data, u8 u8_length, u8 u8_writeRegister, u8 u8_value);
+
+#endif /* REGMAP_H_ */
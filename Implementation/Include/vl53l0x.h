@@ -1,6 +1,7 @@
 /**	@file		vl53l0x.h
 	@brief		VL53L0X distance sensor
-	@details	Supports only master mode without interrupts.
+	@details	Supports only master mode. The sensor interrupt can be routed to a host pin, see @link vl53l0x_setInterruptMode @endlink.
+				All the transfers go through the transaction queue of @link i2cBus.h @endlink, so other devices can share the bus.
 				Basic flow:
 				1. Initialize and start a timer. Make it call @link vl53l0x_incrementTimeoutCounter @endlink every millisecond.
 				2. Initialize a @link vl53l0x_struct_t @endlink.
@@ -8,7 +9,11 @@
 				4. Call @link vl53l0x_start @endlink.
 				5. Call @link vl53l0x_startContinuous @endlink to start continuous measurements.
 				6. Call @link vl53l0x_readRangeContinuous @endlink to get distance measurements. Measurement hasn't finished yet if return value is 0xFFFF.
+				- @link vl53l0x_requestRange @endlink polls for a sample without waiting for the bus. With I2CBUS_INTERRUPT_MODE the frames run from the TWI interrupt and a callback delivers the range, so the CPU is free meanwhile.
+				- Use @link vl53l0x_setInterruptMode @endlink to only get the samples below, above or outside distance thresholds. The GPIO1 pin of the sensor can then wake the host.
 				- Optionally you could use @link vl53l0x_setMode @endlink with one of the @link vl53l0x_mode_enum_t @endlink modes to change the measurement duration, accuracy or max range.
+				- Behind a cover glass, run @link vl53l0x_calibrateOffset @endlink and @link vl53l0x_calibrateCrosstalk @endlink once, store the result of @link vl53l0x_getCalibration @endlink and restore it after each power up with @link vl53l0x_setCalibration @endlink.
+				- To save power between bursts of measurements call @link vl53l0x_standby @endlink and @link vl53l0x_resume @endlink. The sensor keeps its address and configuration, so the first sample comes one timing budget after resuming.
 				- To stop the sensor (for power saving for instance) call @link vl53l0x_stop @endlink. Remember that continuous ranging has to be started in order to take measurements after calling @link vl53l0x_start @endlink.
 */
 
@@ -20,6 +25,8 @@
 /************************************************************************/
 
 #include "gpio.h"
+#include "regmap.h"
+#include "vl53l0x_config.h"
 
 /************************************************************************/
 /* Defines, enums, structs, types                                       */
@@ -43,6 +50,116 @@ typedef enum vl53l0x_mode_enum_t
 	VL53L0X_MAX_SPEED
 }vl53l0x_mode_enum_t;
 
+/**	Ranging steps whose VCSEL (laser) pulse period can be changed
+*/
+typedef enum vl53l0x_vcselPeriod_enum_t
+{
+/**	Pre-range step. Valid periods: 12, 14, 16, 18 PCLKs */
+	VL53L0X_VCSEL_PRE_RANGE,
+/**	Final range step. Valid periods: 8, 10, 12, 14 PCLKs */
+	VL53L0X_VCSEL_FINAL_RANGE
+}vl53l0x_vcselPeriod_enum_t;
+
+/**	Conditions signaled on the GPIO1 pin and in the interrupt status of the sensor
+*/
+typedef enum vl53l0x_interrupt_enum_t
+{
+/**	No interrupt */
+	VL53L0X_INTERRUPT_OFF,
+/**	Range is below the low threshold */
+	VL53L0X_INTERRUPT_LEVEL_LOW,
+/**	Range is above the high threshold */
+	VL53L0X_INTERRUPT_LEVEL_HIGH,
+/**	Range is below the low threshold or above the high threshold */
+	VL53L0X_INTERRUPT_OUT_OF_WINDOW,
+/**	Every new sample. Default after @link vl53l0x_start @endlink. */
+	VL53L0X_INTERRUPT_NEW_SAMPLE
+}vl53l0x_interrupt_enum_t;
+
+/**	Largest interrupt threshold in millimeters
+*/
+#define VL53L0X_THRESHOLD_MAX	8190
+
+/**	Range status of a valid measurement, see @link vl53l0x_sample_struct_t @endlink
+*/
+#define VL53L0X_RANGE_STATUS_VALID	11
+
+/**	Complete result of a ranging measurement
+*/
+typedef struct vl53l0x_sample_struct_t
+{
+/**	Range in millimeters. Only meaningful if rangeStatus is @link VL53L0X_RANGE_STATUS_VALID @endlink.
+*/
+	u16 range;
+/**	Range status reported by the sensor. @link VL53L0X_RANGE_STATUS_VALID @endlink for a valid range, other values flag sigma, signal or phase failures.
+*/
+	u8 rangeStatus;
+/**	Return signal rate in MCPS, Q9.7
+*/
+	u16 signalRate;
+/**	Ambient rate in MCPS, Q9.7
+*/
+	u16 ambientRate;
+/**	Number of SPADs which received the return signal, Q8.8
+*/
+	u16 effectiveSpadCount;
+}vl53l0x_sample_struct_t;
+
+/**	Offset and crosstalk compensation of a sensor
+*/
+typedef struct vl53l0x_calibration_struct_t
+{
+/**	Range offset in quarter millimeters, added by the sensor to every range. 12 bit signed.
+*/
+	s16 offset;
+/**	Crosstalk compensation rate in MCPS per SPAD, Q3.13. 0 disables the compensation.
+*/
+	u16 crosstalk;
+/**	TRUE once a calibration was run or restored. Until then the sensor keeps its factory offset and has no crosstalk compensation.
+*/
+	bool valid;
+}vl53l0x_calibration_struct_t;
+
+#ifdef VL53L0X_STATISTICS
+/**	Number of bins in the latency histogram. Bin 0 counts latencies under 1ms, bin n latencies from 2^(n-1) to 2^n - 1 ms, the last bin everything above.
+*/
+#define VL53L0X_LATENCY_BINS	8
+
+/**	I2C and polling counters of a sensor. Only available if VL53L0X_STATISTICS is defined in vl53l0x_config.h.
+*/
+typedef struct vl53l0x_statistics_struct_t
+{
+/**	I2C transactions with the sensor. Accesses answered from the register cache aren't counted.
+*/
+	u32 transactions;
+/**	Bytes on the bus, including address and register bytes
+*/
+	u32 bytes;
+/**	Polls which found no new sample
+*/
+	u32 emptyPolls;
+/**	Samples read from the sensor
+*/
+	u32 samples;
+/**	Operations which ran out of time
+*/
+	u16 timeouts;
+/**	Histogram of the time between the poll delivering a sample and the previous poll or measurement start, an upper bound of how long the sample waited to be read. Saturates at 0xFFFF.
+*/
+	u16 au16_latency[VL53L0X_LATENCY_BINS];
+/**	Time of the last poll or measurement start in milliseconds
+	@remark	Do not modify!
+*/
+	u32 lastPoll;
+}vl53l0x_statistics_struct_t;
+#endif
+
+struct vl53l0x_struct_t;
+
+/**	Function receiving the result of @link vl53l0x_requestRange @endlink: the range in millimeters, or 0xFFFF if no new sample was available. In interrupt mode it runs inside the TWI interrupt, so keep it short.
+*/
+typedef void (*vl53l0x_rangeCallback_t)(struct vl53l0x_struct_t* ps_sensor, u16 u16_range);
+
 /**	Information related to a ranging measurement
 */
 typedef struct vl53l0x_struct_t
@@ -63,11 +180,66 @@ typedef struct vl53l0x_struct_t
 /**	Start of timeout counter
 @remark	Do not modify!
 */
-	u16 timeoutStart;
+	u32 timeoutStart;
 /** Stop variable from manufacturer API, used when starting a measurement.
 	@remark	Do not modify!
 */
 	u8 stopVariable;
+/**	Measurement timing budget in microseconds, set by @link vl53l0x_setMode @endlink or @link vl53l0x_setTimingBudget @endlink.
+	@remark	Do not modify!
+*/
+	u32 timingBudget;
+/**	Pre-range VCSEL pulse period in PCLKs
+	@remark	Do not modify!
+*/
+	u8 preRangeVcselPeriod;
+/**	Final range VCSEL pulse period in PCLKs
+	@remark	Do not modify!
+*/
+	u8 finalRangeVcselPeriod;
+/**	Register access. Caches the page select and the configuration registers which only the driver changes, so redundant I2C transfers are skipped. Its bus speed profile is set to @link VL53L0X_I2C_FREQUENCY @endlink by @link vl53l0x_init @endlink,
+	call @link i2cBus_initSpeed @endlink on s_regmap.s_busSpeed after @link vl53l0x_init @endlink to use a lower rate. @link vl53l0x_start @endlink resets it to its highest frequency.
+	@remark	Do not modify otherwise!
+*/
+	regmap_struct_t s_regmap;
+/**	Offset and crosstalk compensation, applied again by @link vl53l0x_start @endlink if valid.
+	@remark	Do not modify! Use @link vl53l0x_setCalibration @endlink.
+*/
+	vl53l0x_calibration_struct_t s_calibration;
+/**	Period passed to the last @link vl53l0x_startContinuous @endlink, used again by @link vl53l0x_resume @endlink
+	@remark	Do not modify!
+*/
+	u32 rangingPeriod;
+/**	Whether continuous ranging was started and not stopped with @link vl53l0x_stopContinuous @endlink
+	@remark	Do not modify!
+*/
+	bool continuous;
+/**	Whether the sensor was put in standby with @link vl53l0x_standby @endlink
+	@remark	Do not modify!
+*/
+	bool standby;
+/**	Bus frame of @link vl53l0x_requestRange @endlink
+	@remark	Do not modify!
+*/
+	i2cBus_transaction_struct_t s_asyncTransaction;
+/**	Interrupt status and range read by @link vl53l0x_requestRange @endlink
+	@remark	Do not modify!
+*/
+	u8 au8_asyncData[3];
+/**	Callback of the pending @link vl53l0x_requestRange @endlink
+	@remark	Do not modify!
+*/
+	vl53l0x_rangeCallback_t f_rangeCallback;
+/**	Whether a @link vl53l0x_requestRange @endlink hasn't called its callback yet
+	@remark	Do not modify!
+*/
+	volatile bool asyncPending;
+#ifdef VL53L0X_STATISTICS
+/**	I2C and polling counters
+	@remark	Do not modify!
+*/
+	vl53l0x_statistics_struct_t s_statistics;
+#endif
 }vl53l0x_struct_t;
 
 /************************************************************************/
@@ -88,10 +260,25 @@ bool vl53l0x_start(vl53l0x_struct_t* ps_sensor);
 /**	Puts the sensor in low power mode
 	@pre		Must be called after the sensor was initialized (with @link vl53l0x_init @endlink).
 	@remark		This doesn't stop the I2C peripheral because other devices may be connected to it.
+	@remark		The sensor loses its address and configuration, @link vl53l0x_start @endlink has to run the whole initialization again. Use @link vl53l0x_standby @endlink for short pauses.
 	@param[in]	ps_sensor: sensor to use
 */
 void vl53l0x_stop(vl53l0x_struct_t* ps_sensor);
 
+/**	Stops ranging and leaves the sensor in software standby, keeping its address, mode, interrupt configuration and calibration.
+	@pre		Must be called after the sensor was started (with @link vl53l0x_start @endlink).
+	@remark		Software standby draws a few microamperes, slightly more than holding XSHUT low with @link vl53l0x_stop @endlink.
+	@param[in]	ps_sensor: sensor to use
+*/
+void vl53l0x_standby(vl53l0x_struct_t* ps_sensor);
+
+/**	Leaves standby. Continuous ranging is started again with the previous period if it was running when @link vl53l0x_standby @endlink was called.
+	@pre		Must be called after the sensor was put in standby (with @link vl53l0x_standby @endlink).
+	@remark		Only the ranging start is sent, the first sample is available after one timing budget.
+	@param[in]	ps_sensor: sensor to use
+*/
+void vl53l0x_resume(vl53l0x_struct_t* ps_sensor);
+
 /** Sets sensor's I2C address
 	@pre		Must be called after the sensor was initialized (with @link vl53l0x_init @endlink).
 	@remark		Call with 7 bit address
@@ -101,13 +288,51 @@ void vl53l0x_stop(vl53l0x_struct_t* ps_sensor);
 void vl53l0x_setAddress(vl53l0x_struct_t* ps_sensor, u8 u8_address);
 
 /** Switches between one of the ranging modes defined by @link vl53l0x_mode_enum_t @endlink
-	@pre		Must be called after the sensor was initialized (with @link vl53l0x_init @endlink).
+	@pre		Must be called after the sensor was started (with @link vl53l0x_start @endlink).
+	@remark		The mode settings are precomputed, so switching only takes a couple of register writes and can be done between measurements. Switching to or from @link VL53L0X_MAX_RANGE @endlink also changes the VCSEL periods, which needs a phase calibration and must not be done while ranging.
 	@param[in]	ps_sensor: sensor to use
 	@param[in]	e_mode: mode to set
-	@return		Sensor address
+	@return		Whether the mode was applied
 */
 bool vl53l0x_setMode(vl53l0x_struct_t* ps_sensor, vl53l0x_mode_enum_t e_mode);
 
+/** Sets the minimum return signal rate below which a measurement is reported as invalid. Lower values increase the range but also the chance of wrong readings.
+	@pre		Must be called after the sensor was started (with @link vl53l0x_start @endlink).
+	@param[in]	ps_sensor: sensor to use
+	@param[in]	u16_limit: limit in MCPS (million counts per second), Q9.7 fixed point format (0.25 MCPS is 32)
+*/
+void vl53l0x_setSignalRateLimit(vl53l0x_struct_t* ps_sensor, u16 u16_limit);
+
+/** Sets the time allowed for one measurement. Longer budgets give more accurate readings.
+	@pre		Must be called after the sensor was started (with @link vl53l0x_start @endlink).
+	@remark		Unlike @link vl53l0x_setMode @endlink, this reads the sequence step timeouts from the sensor to compute the final range timeout.
+	@param[in]	ps_sensor: sensor to use
+	@param[in]	u32_budget: timing budget in microseconds, at least 20000
+	@return		Whether the budget could be applied
+*/
+bool vl53l0x_setTimingBudget(vl53l0x_struct_t* ps_sensor, u32 u32_budget);
+
+/** Sets the VCSEL (laser) pulse period of a ranging step. Longer periods increase the range, shorter ones the accuracy.
+	@pre		Must be called after the sensor was started (with @link vl53l0x_start @endlink) and while it isn't ranging.
+	@remark		The step timeouts are converted to the new period and the timing budget is kept. A phase calibration is performed afterwards.
+	@param[in]	ps_sensor: sensor to use
+	@param[in]	e_vcselPeriodType: ranging step to change
+	@param[in]	u8_period: pulse period in PCLKs, see @link vl53l0x_vcselPeriod_enum_t @endlink for valid values
+	@return		Whether the period is valid and the phase calibration succeeded
+*/
+bool vl53l0x_setVcselPulsePeriod(vl53l0x_struct_t* ps_sensor, vl53l0x_vcselPeriod_enum_t e_vcselPeriodType, u8 u8_period);
+
+/** Selects the condition which raises the interrupt of the sensor. The GPIO1 pin is driven low and @link vl53l0x_readRangeContinuous @endlink returns a sample only while the condition is met, so the host can sleep or skip reads until then.
+	@pre		Must be called after the sensor was started (with @link vl53l0x_start @endlink).
+	@remark		Thresholds have a 2mm resolution. In the threshold modes samples which don't meet the condition are dropped by the sensor.
+	@param[in]	ps_sensor: sensor to use
+	@param[in]	e_mode: interrupt condition
+	@param[in]	u16_lowThreshold: low threshold in millimeters, used by @link VL53L0X_INTERRUPT_LEVEL_LOW @endlink and @link VL53L0X_INTERRUPT_OUT_OF_WINDOW @endlink
+	@param[in]	u16_highThreshold: high threshold in millimeters, used by @link VL53L0X_INTERRUPT_LEVEL_HIGH @endlink and @link VL53L0X_INTERRUPT_OUT_OF_WINDOW @endlink
+	@return		Whether the mode exists and the thresholds are valid (not above @link VL53L0X_THRESHOLD_MAX @endlink, low not above high)
+*/
+bool vl53l0x_setInterruptMode(vl53l0x_struct_t* ps_sensor, vl53l0x_interrupt_enum_t e_mode, u16 u16_lowThreshold, u16 u16_highThreshold);
+
 /** Starts continuous ranging measurements. If the argument is 0, continuous back-to-back mode is used (the sensor takes measurements as often as possible); otherwise continuous timed mode is used, with the specified inter-measurement period determining how often the sensor takes a measurement.
 	@pre	Must be called after the sensor was initialized (with @link vl53l0x_init @endlink).
 	@param[in]	ps_sensor: sensor to use
@@ -128,6 +353,22 @@ void vl53l0x_stopContinuous(vl53l0x_struct_t* ps_sensor);
 */
 u16 vl53l0x_readRangeContinuous(vl53l0x_struct_t* ps_sensor);
 
+/**	Polls for a range without waiting for the bus. One frame reads the interrupt status and the range. If a sample was ready, a second frame clears the interrupt from the completion of the first one, then the callback gets the range.
+	@pre		Must be called if the sensor is in continuous ranging mode (with @link vl53l0x_startContinuous @endlink) or a single measurement was started (with @link vl53l0x_startSingle @endlink).
+	@remark		Don't call any other function of the same sensor until the callback ran. The frames go through the register map, so they select page 0 again after a failed transfer and a failed frame forgets the cached registers. Without I2CBUS_INTERRUPT_MODE the callback runs before this function returns.
+	@remark		If the interrupt can't be cleared the callback gets 0xFFFF, the sample is then delivered by the next request.
+	@param[in]	ps_sensor: sensor to use
+	@param[in]	f_callback: function receiving the range
+	@return		FALSE if a request of this sensor is still pending
+*/
+bool vl53l0x_requestRange(vl53l0x_struct_t* ps_sensor, vl53l0x_rangeCallback_t f_callback);
+
+/**	Returns whether a @link vl53l0x_requestRange @endlink of the sensor hasn't called its callback yet.
+	@param[in]	ps_sensor: sensor to use
+	@return		TRUE until the callback was called
+*/
+bool vl53l0x_isRequestPending(vl53l0x_struct_t* ps_sensor);
+
 /** Performs a single-shot ranging measurement and returns the result.
 	@pre	Must be called after the sensor was initialized (with @link vl53l0x_init @endlink).
 	@param[in]	ps_sensor: sensor to use
@@ -135,15 +376,90 @@ u16 vl53l0x_readRangeContinuous(vl53l0x_struct_t* ps_sensor);
 */
 u16 vl53l0x_readRangeSingle(vl53l0x_struct_t* ps_sensor);
 
+/**	Reads the complete result of the last measurement, if a new one is available.
+	@pre		Must be called after the sensor was started (with @link vl53l0x_start @endlink) and a measurement was started.
+	@remark		Costs one burst read more than @link vl53l0x_readRangeContinuous @endlink, use it when the range status or signal rate are needed.
+	@param[in]	ps_sensor: sensor to use
+	@param[out]	ps_sample: measurement result, only written if a new sample was available
+	@return		Whether a new sample was available
+*/
+bool vl53l0x_readSample(vl53l0x_struct_t* ps_sensor, vl53l0x_sample_struct_t* ps_sample);
+
+/** Starts a single-shot ranging measurement and returns immediately.
+	@pre		Must be called after the sensor was initialized (with @link vl53l0x_init @endlink).
+	@remark		The result is collected with @link vl53l0x_readRangeContinuous @endlink, which returns 0xFFFF until the measurement has finished.
+	@param[in]	ps_sensor: sensor to use
+*/
+void vl53l0x_startSingle(vl53l0x_struct_t* ps_sensor);
+
+/**	Calibrates the range offset on a target at a known distance and applies it.
+	@pre		Must be called after the sensor was started (with @link vl53l0x_start @endlink), while it isn't ranging continuously.
+	@remark		Use a white target at about 100mm. The current crosstalk compensation stays enabled, so run it again after @link vl53l0x_calibrateCrosstalk @endlink for the best result.
+	@param[in]	ps_sensor: sensor to use
+	@param[in]	u16_targetDistance: distance to the target in millimeters
+	@param[in]	u8_samples: number of single shot measurements to average
+	@return		FALSE if no valid measurement was obtained, the previous offset is then restored
+*/
+bool vl53l0x_calibrateOffset(vl53l0x_struct_t* ps_sensor, u16 u16_targetDistance, u8 u8_samples);
+
+/**	Calibrates the crosstalk compensation on a target at a known distance and applies it.
+	@pre		Must be called after the sensor was started (with @link vl53l0x_start @endlink), while it isn't ranging continuously.
+	@remark		Use a grey target far enough to return a weak signal, typically 400 to 600mm, and calibrate the offset first.
+	@param[in]	ps_sensor: sensor to use
+	@param[in]	u16_targetDistance: distance to the target in millimeters
+	@param[in]	u8_samples: number of single shot measurements to average
+	@return		FALSE if no valid measurement was obtained, the previous compensation is then restored
+*/
+bool vl53l0x_calibrateCrosstalk(vl53l0x_struct_t* ps_sensor, u16 u16_targetDistance, u8 u8_samples);
+
+/**	Returns the offset and crosstalk compensation in use, to be stored in non-volatile memory.
+	@pre		Must be called after the sensor was started (with @link vl53l0x_start @endlink).
+	@param[in]	ps_sensor: sensor to use
+	@return		Calibration of the sensor
+*/
+vl53l0x_calibration_struct_t const * vl53l0x_getCalibration(vl53l0x_struct_t* ps_sensor);
+
+/**	Applies a stored offset and crosstalk compensation. It is applied again by each following @link vl53l0x_start @endlink.
+	@pre		Must be called after the sensor was started (with @link vl53l0x_start @endlink).
+	@param[in]	ps_sensor: sensor to use
+	@param[in]	ps_calibration: calibration returned by @link vl53l0x_getCalibration @endlink. Nothing is done if it isn't valid.
+*/
+void vl53l0x_setCalibration(vl53l0x_struct_t* ps_sensor, vl53l0x_calibration_struct_t const * ps_calibration);
+
 /**	Increments the timing variable used for I2C communication timeouts
 	@remark		Call this every millisecond
 */
 void vl53l0x_incrementTimeoutCounter();
 
+/**	Returns the number of milliseconds counted by @link vl53l0x_incrementTimeoutCounter @endlink
+	@return		milliseconds since the counter was started
+*/
+u32 vl53l0x_getMilliseconds();
+
 /** Indicates whether a I2C communication timeout has occurred.
 	@param[in]	ps_sensor: sensor to use
 	@return		whether timeout occurred
 */
 bool vl53l0x_timeoutOccurred(vl53l0x_struct_t* ps_sensor);
 
+#ifdef VL53L0X_STATISTICS
+/**	Returns the I2C and polling counters of a sensor.
+	@pre		Must be called after the sensor was initialized (with @link vl53l0x_init @endlink).
+	@param[in]	ps_sensor: sensor to use
+	@return		Counters since the sensor was initialized or the last @link vl53l0x_resetStatistics @endlink
+*/
+vl53l0x_statistics_struct_t const * vl53l0x_getStatistics(vl53l0x_struct_t* ps_sensor);
+
+/**	Clears the I2C and polling counters of a sensor.
+	@param[in]	ps_sensor: sensor to use
+*/
+void vl53l0x_resetStatistics(vl53l0x_struct_t* ps_sensor);
+
+/**	Writes the I2C and polling counters of a sensor on the debug interface.
+	@pre		The debug interface was started (with @link debug_start @endlink).
+	@param[in]	ps_sensor: sensor to use
+*/
+void vl53l0x_printStatistics(vl53l0x_struct_t* ps_sensor);
+#endif
+
 #endif /* VL53L0X_H_ */
\ No newline at end of file
@@ -0,0 +1,124 @@
+/**	@file		vl53l0x_adaptive.h
+	@brief		Automatic VL53L0X ranging mode selection
+	@details	Picks the @link vl53l0x_mode_enum_t @endlink of a sensor after every sample, from the latest range, its variance and the commanded velocity of the robot:
+				- @link VL53L0X_MAX_SPEED @endlink when moving fast or close to an obstacle, so the robot doesn't travel far between samples
+				- @link VL53L0X_MAX_RANGE @endlink when the target is far away
+				- @link VL53L0X_MAX_ACCURACY @endlink when the readings are noisy and the robot is slow enough for long measurements
+				- @link VL53L0X_DEFAULT @endlink otherwise
+				Every threshold has a hysteresis band and slower modes must be requested for several samples in a row before they are applied, so the mode doesn't thrash around a threshold. Switching to @link VL53L0X_MAX_SPEED @endlink is immediate.
+				Basic flow:
+				1. Start the sensor as usual (see @link vl53l0x.h @endlink).
+				2. Initialize a @link vl53l0x_adaptive_struct_t @endlink with the sensor and the thresholds.
+				3. Pass it to @link vl53l0x_adaptive_init @endlink. It applies the default mode and starts continuous ranging if requested.
+				4. Call @link vl53l0x_adaptive_setVelocity @endlink whenever the motion controller changes the speed.
+				5. Pass every valid range to @link vl53l0x_adaptive_update @endlink, preferably filtered (see @link vl53l0x_filter.h @endlink).
+*/
+
+#ifndef VL53L0X_ADAPTIVE_H_
+#define VL53L0X_ADAPTIVE_H_
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include "vl53l0x.h"
+
+/************************************************************************/
+/* Defines, enums, structs, types                                       */
+/************************************************************************/
+
+/**	Mode selection state of one sensor
+*/
+typedef struct vl53l0x_adaptive_struct_t
+{
+/**	Sensor whose mode is managed
+*/
+	vl53l0x_struct_t* ps_sensor;
+/**	If TRUE, the sensor ranges continuously and is stopped and restarted around mode changes. If FALSE, the caller starts single measurements itself.
+*/
+	bool continuous;
+/**	Period of continuous ranging in milliseconds, 0 for back-to-back
+*/
+	u32 rangingPeriod;
+/**	Ranges below this distance in millimeters select @link VL53L0X_MAX_SPEED @endlink
+*/
+	u16 nearRange;
+/**	Ranges above this distance in millimeters select @link VL53L0X_MAX_RANGE @endlink
+*/
+	u16 farRange;
+/**	Speeds above this value in mm/s select @link VL53L0X_MAX_SPEED @endlink
+*/
+	u16 fastVelocity;
+/**	Range variances above this value in mm^2 select @link VL53L0X_MAX_ACCURACY @endlink
+*/
+	u32 noisyVariance;
+/**	@link VL53L0X_MAX_ACCURACY @endlink is only selected below this speed in mm/s
+*/
+	u16 slowVelocity;
+/**	Width of the hysteresis bands, as a power of two fraction of each threshold: 3 gives bands of +-1/8 of the threshold.
+*/
+	u8 hysteresisShift;
+/**	Number of consecutive samples which must request a slower mode before it is applied
+*/
+	u8 dwell;
+/**	Mode currently applied
+	@remark	Do not modify!
+*/
+	vl53l0x_mode_enum_t e_mode;
+/**	Mode requested by the last samples
+	@remark	Do not modify!
+*/
+	vl53l0x_mode_enum_t e_candidate;
+/**	Number of consecutive samples which requested e_candidate
+	@remark	Do not modify!
+*/
+	u8 candidateCount;
+/**	Commanded speed in mm/s, sign ignored
+	@remark	Do not modify!
+*/
+	u16 velocity;
+/**	Previous range in millimeters, 0xFFFF before the first sample
+	@remark	Do not modify!
+*/
+	u16 lastRange;
+/**	Running mean of the change between two samples in 1/16 millimeters, the part of the change explained by motion
+	@remark	Do not modify!
+*/
+	s32 trend;
+/**	Running variance of the range around the trend in mm^2
+	@remark	Do not modify!
+*/
+	u32 variance;
+/**	Number of mode changes since the manager was initialized
+	@remark	Do not modify!
+*/
+	u16 switches;
+}vl53l0x_adaptive_struct_t;
+
+/************************************************************************/
+/* Exported functions                                                   */
+/************************************************************************/
+
+/**	Applies the default mode and clears the range statistics. Starts continuous ranging if continuous is set.
+	@pre		Must be called after the sensor was started (with @link vl53l0x_start @endlink) and while it isn't ranging.
+	@param[in]	ps_adaptive: mode manager to use
+	@return		Whether the default mode could be applied
+*/
+bool vl53l0x_adaptive_init(vl53l0x_adaptive_struct_t* ps_adaptive);
+
+/**	Sets the commanded speed of the robot.
+	@param[in]	ps_adaptive: mode manager to use
+	@param[in]	s16_velocity: speed in mm/s, forwards or backwards
+*/
+void vl53l0x_adaptive_setVelocity(vl53l0x_adaptive_struct_t* ps_adaptive, s16 s16_velocity);
+
+/**	Updates the range statistics with a new sample and changes the mode if needed.
+	@pre		Must be called after the manager was initialized (with @link vl53l0x_adaptive_init @endlink).
+	@remark		When not ranging continuously, call it between measurements.
+	@param[in]	ps_adaptive: mode manager to use
+	@param[in]	u16_range: latest valid range in millimeters. 0xFFFF is ignored.
+	@return		Whether the mode was changed
+*/
+bool vl53l0x_adaptive_update(vl53l0x_adaptive_struct_t* ps_adaptive, u16 u16_range);
+
+#endif /* VL53L0X_ADAPTIVE_H_ */
@@ -0,0 +1,146 @@
+/**	@file		vl53l0x_array.h
+	@brief		Multiple VL53L0X distance sensors sharing the same I2C bus
+	@details	Handles the XSHUT bring-up sequence and the I2C address assignment for up to @link VL53L0X_ARRAY_MAX_SENSORS @endlink sensors.
+				Basic flow:
+				1. Initialize and start a timer. Make it call @link vl53l0x_incrementTimeoutCounter @endlink every millisecond.
+				2. Declare an array of @link vl53l0x_struct_t @endlink. Only the XSHUT pin and the I2C timeout of each sensor have to be set, addresses are assigned by the array.
+				3. Initialize a @link vl53l0x_array_struct_t @endlink with the sensors, their number, the first address to assign, the ranging mode and the ranging period.
+				4. Pass it to @link vl53l0x_array_init @endlink.
+				5. Call @link vl53l0x_array_start @endlink. Sensors are released from reset one by one, given the addresses firstAddress, firstAddress + 1, ... and put in ranging mode.
+				6. Call @link vl53l0x_array_read @endlink to refresh the sample set. The latest range of each sensor can then be found in au16_ranges.
+				- Sensors which see each other's VCSEL pulses are declared in au8_conflicts. The array then computes a schedule of time slots, each slot firing a group of non-conflicting sensors in single-shot mode.
+				  The schedule uses as few slots as possible, then adds every sensor to each further slot where it disturbs no one, so isolated sensors range in every slot.
+				  If no conflicts are declared, all the sensors range continuously.
+				- Call @link vl53l0x_array_getSampleRate @endlink to get the rate each sensor achieves with the schedule.
+				- With singleShot set, the sensors only range when @link vl53l0x_array_measure @endlink is called. It starts every sensor of a slot back to back and gathers the results in the order they complete,
+				  so a sample set takes about one timing budget per slot instead of one per sensor.
+				- To stop all the sensors call @link vl53l0x_array_stop @endlink.
+	@remark		Every sensor must have its own XSHUT pin.
+*/
+
+#ifndef VL53L0X_ARRAY_H_
+#define VL53L0X_ARRAY_H_
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include "vl53l0x.h"
+#include "vl53l0x_config.h"
+
+/************************************************************************/
+/* Defines, enums, structs, types                                       */
+/************************************************************************/
+
+/**	Group of sensors sharing the same I2C bus
+*/
+typedef struct vl53l0x_array_struct_t
+{
+/**	Sensors handled by the array. Only xshutPin and i2cTimeout have to be set.
+*/
+	vl53l0x_struct_t* ps_sensors;
+/**	Number of sensors in ps_sensors. Must not be greater than @link VL53L0X_ARRAY_MAX_SENSORS @endlink.
+*/
+	u8 sensorCount;
+/**	7 bit address given to the first sensor. The following sensors get consecutive addresses. The range must not contain @link VL53L0X_ADDRESS_DEFAULT @endlink.
+*/
+	u8 firstAddress;
+/**	Ranging mode used by all the sensors
+*/
+	vl53l0x_mode_enum_t mode;
+/**	Period in milliseconds between two measurements. 0 for continuous back-to-back mode. Not used when sensors run on a schedule.
+*/
+	u32 rangingPeriod;
+/**	Sensors only range when @link vl53l0x_array_measure @endlink is called instead of continuously or on their own schedule.
+*/
+	bool singleShot;
+/**	Interference graph. Bit n of au8_conflicts[m] is set if sensors m and n must not range at the same time. Declaring the conflict on one of the two sensors is enough.
+*/
+	u8 au8_conflicts[VL53L0X_ARRAY_MAX_SENSORS];
+/**	Latest range in millimeters of each sensor. 0xFFFF until the first sample is received.
+	@remark	Do not modify!
+*/
+	u16 au16_ranges[VL53L0X_ARRAY_MAX_SENSORS];
+/**	Bit n is set if sensor n was started successfully.
+	@remark	Do not modify!
+*/
+	u8 activeSensors;
+/**	Ranging schedule. Bit n of au8_slots[m] is set if sensor n ranges during slot m.
+	@remark	Do not modify!
+*/
+	u8 au8_slots[VL53L0X_ARRAY_MAX_SENSORS];
+/**	Number of slots in the schedule
+	@remark	Do not modify!
+*/
+	u8 slotCount;
+/**	Slot currently ranging
+	@remark	Do not modify!
+*/
+	u8 currentSlot;
+/**	Sensors of the current slot which haven't delivered their sample yet
+	@remark	Do not modify!
+*/
+	u8 pendingSensors;
+/**	Start of the current slot in milliseconds
+	@remark	Do not modify!
+*/
+	u32 slotStart;
+/**	Start of the current pass through all the slots in milliseconds
+	@remark	Do not modify!
+*/
+	u32 frameStart;
+/**	Duration of the last complete pass through all the slots in milliseconds. 0 until a pass has completed.
+	@remark	Do not modify!
+*/
+	u32 frameDuration;
+}vl53l0x_array_struct_t;
+
+/************************************************************************/
+/* Exported functions                                                   */
+/************************************************************************/
+
+/** Initializes all the sensors of the array and holds them in reset.
+	@param[in]	ps_array: sensor array to use
+*/
+void vl53l0x_array_init(vl53l0x_array_struct_t* ps_array);
+
+/** Brings up the sensors one at a time, assigns their addresses, computes the ranging schedule from au8_conflicts and starts ranging, unless singleShot is set.
+	@pre		Must be called after the array was initialized (with @link vl53l0x_array_init @endlink).
+	@remark		A sensor which fails to start is held in reset so it doesn't block the address of the next one.
+	@param[in]	ps_array: sensor array to use
+	@return		Whether all the sensors were started successfully
+*/
+bool vl53l0x_array_start(vl53l0x_array_struct_t* ps_array);
+
+/** Puts all the sensors in low power mode.
+	@pre		Must be called after the array was initialized (with @link vl53l0x_array_init @endlink).
+	@param[in]	ps_array: sensor array to use
+*/
+void vl53l0x_array_stop(vl53l0x_array_struct_t* ps_array);
+
+/**	Polls every ranging sensor once and stores the new samples in au16_ranges. When running on a schedule, also starts the next slot once all the sensors of the current one have delivered.
+	@pre		Must be called after the array was started (with @link vl53l0x_array_start @endlink) without singleShot.
+	@remark		Call this often, the next slot is only started from here.
+	@param[in]	ps_array: sensor array to use
+	@return		Mask of the sensors that delivered a new sample
+*/
+u8 vl53l0x_array_read(vl53l0x_array_struct_t* ps_array);
+
+/**	Measures every sensor once and stores the samples in au16_ranges. The sensors of each slot are started back to back, then polled in turn so each result is read as soon as it is ready.
+	@pre		Must be called after the array was started (with @link vl53l0x_array_start @endlink) with singleShot set.
+	@remark		Blocks for about one timing budget per slot. A sensor which doesn't deliver within twice its timing budget is flagged as timed out.
+	@param[in]	ps_array: sensor array to use
+	@return		Mask of the sensors that delivered a new sample
+*/
+u8 vl53l0x_array_measure(vl53l0x_array_struct_t* ps_array);
+
+/**	Returns the sample rate a sensor achieves with the current schedule.
+	@pre		Must be called after the array was started (with @link vl53l0x_array_start @endlink).
+	@remark		Until a full pass through the schedule has been timed, the rate is estimated from the timing budget. With singleShot set, the rate assumes @link vl53l0x_array_measure @endlink is called back to back.
+	@param[in]	ps_array: sensor array to use
+	@param[in]	u8_sensor: index of the sensor in ps_sensors
+	@return		Samples per second multiplied by 1000
+*/
+u32 vl53l0x_array_getSampleRate(vl53l0x_array_struct_t* ps_array, u8 u8_sensor);
+
+#endif /* VL53L0X_ARRAY_H_ */
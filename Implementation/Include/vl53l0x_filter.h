@@ -0,0 +1,116 @@
+/**	@file		vl53l0x_filter.h
+	@brief		Outlier rejection and smoothing of VL53L0X ranges
+	@details	Each sample goes through three integer-only stages:
+				1. Rejection: samples with an invalid range status, a return signal below minSignalRate or a range above maxRange are dropped.
+				2. Running median of the last @link VL53L0X_FILTER_MEDIAN_SIZE @endlink accepted samples, which removes isolated spikes such as phase wrap-arounds.
+				3. Exponential smoothing of the median with a weight of 2^-emaShift.
+				The median is kept in a sorted copy of the window, so an update takes O(N) steps with N = @link VL53L0X_FILTER_MEDIAN_SIZE @endlink: a linear search for the oldest sample and an insertion shift. N is small and fixed, a few tens of compares for 5.
+				Basic flow:
+				1. Start the sensor and its continuous ranging as usual (see @link vl53l0x.h @endlink).
+				2. Initialize a @link vl53l0x_filter_struct_t @endlink with the sensor and the rejection limits.
+				3. Pass it to @link vl53l0x_filter_init @endlink.
+				4. Call @link vl53l0x_filter_update @endlink periodically. The filtered range is in range, the returned flag tells whether it changed.
+				- Samples read elsewhere (e.g. by a sensor array) can be fed with @link vl53l0x_filter_push @endlink instead.
+*/
+
+#ifndef VL53L0X_FILTER_H_
+#define VL53L0X_FILTER_H_
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include "vl53l0x.h"
+#include "vl53l0x_config.h"
+
+/************************************************************************/
+/* Defines, enums, structs, types                                       */
+/************************************************************************/
+
+/**	Quality of a filter output
+*/
+typedef enum vl53l0x_filterFlag_enum_t
+{
+/**	No new sample was accepted. The range is the previous output, or 0xFFFF if there never was one. */
+	VL53L0X_FILTER_STALE,
+/**	A new sample was accepted, but fewer than @link VL53L0X_FILTER_MEDIAN_SIZE @endlink samples have been seen since the filter was reset. The range is the median of what is available. */
+	VL53L0X_FILTER_VALID,
+/**	The range went through the full median and smoothing */
+	VL53L0X_FILTER_FILTERED
+}vl53l0x_filterFlag_enum_t;
+
+/**	Filtering state of one sensor
+*/
+typedef struct vl53l0x_filter_struct_t
+{
+/**	Sensor read by @link vl53l0x_filter_update @endlink
+*/
+	vl53l0x_struct_t* ps_sensor;
+/**	Minimum return signal rate in MCPS, Q9.7. Weaker samples are rejected.
+*/
+	u16 minSignalRate;
+/**	Maximum accepted range in millimeters. The sensor reports 8190 and above when it gets no usable return.
+*/
+	u16 maxRange;
+/**	Smoothing weight of a new median, as a power of two: 0 disables smoothing, 2 gives each new median a weight of 1/4.
+*/
+	u8 emaShift;
+/**	Latest output in millimeters
+	@remark	Do not modify!
+*/
+	u16 range;
+/**	Flag of the latest output
+	@remark	Do not modify!
+*/
+	vl53l0x_filterFlag_enum_t e_flag;
+/**	Samples rejected since the filter was reset
+	@remark	Do not modify!
+*/
+	u16 rejected;
+/**	Accepted samples, oldest first in insertion order starting at oldest
+	@remark	Do not modify!
+*/
+	u16 au16_window[VL53L0X_FILTER_MEDIAN_SIZE];
+/**	Same samples sorted by range
+	@remark	Do not modify!
+*/
+	u16 au16_sorted[VL53L0X_FILTER_MEDIAN_SIZE];
+/**	Number of valid entries in the windows
+	@remark	Do not modify!
+*/
+	u8 count;
+/**	Position of the oldest sample in au16_window
+	@remark	Do not modify!
+*/
+	u8 oldest;
+/**	Smoothed range in 1/16 millimeters
+	@remark	Do not modify!
+*/
+	u32 average;
+}vl53l0x_filter_struct_t;
+
+/************************************************************************/
+/* Exported functions                                                   */
+/************************************************************************/
+
+/**	Clears the filter history.
+	@param[in]	ps_filter: filter to use
+*/
+void vl53l0x_filter_init(vl53l0x_filter_struct_t* ps_filter);
+
+/**	Feeds a sample read elsewhere to the filter.
+	@pre		Must be called after the filter was initialized (with @link vl53l0x_filter_init @endlink).
+	@param[in]	ps_filter: filter to use
+	@param[in]	ps_sample: new measurement
+	@return		Quality of the output, STALE if the sample was rejected
+*/
+vl53l0x_filterFlag_enum_t vl53l0x_filter_push(vl53l0x_filter_struct_t* ps_filter, vl53l0x_sample_struct_t const * ps_sample);
+
+/**	Reads a new sample from the sensor, if one is available, and feeds it to the filter.
+	@pre		Must be called after the filter was initialized (with @link vl53l0x_filter_init @endlink) and the sensor is ranging.
+	@param[in]	ps_filter: filter to use
+	@return		Quality of the output, STALE if there was no new sample or it was rejected
+*/
+vl53l0x_filterFlag_enum_t vl53l0x_filter_update(vl53l0x_filter_struct_t* ps_filter);
+
+#endif /* VL53L0X_FILTER_H_ */
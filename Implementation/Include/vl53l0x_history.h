@@ -0,0 +1,154 @@
+/**	@file		vl53l0x_history.h
+	@brief		Timestamped history of VL53L0X samples
+	@details	Keeps the last @link VL53L0X_HISTORY_SIZE @endlink samples of a sensor with the time they were read, so fusion and velocity estimation know how old each range is.
+				Records are read in place: any number of consumers can look at the same history without copying it or querying the sensor again.
+				Basic flow:
+				1. Start the sensor and its continuous ranging as usual (see @link vl53l0x.h @endlink).
+				2. Set the sensor of a @link vl53l0x_history_struct_t @endlink and pass it to @link vl53l0x_history_init @endlink.
+				3. Call @link vl53l0x_history_update @endlink periodically, or @link vl53l0x_history_push @endlink with samples read elsewhere.
+				4. Read the records with @link vl53l0x_history_getLatest @endlink, @link vl53l0x_history_get @endlink, @link vl53l0x_history_getAt @endlink or iterate over a time window with @link vl53l0x_history_window @endlink and @link vl53l0x_history_next @endlink.
+				- Each consumer can remember pushCount and call @link vl53l0x_history_countSince @endlink to know how many records it hasn't seen yet.
+	@remark		Record pointers stay valid until the record is overwritten, i.e. for @link VL53L0X_HISTORY_SIZE @endlink - 1 more pushes. Don't push from an interrupt while iterating.
+*/
+
+#ifndef VL53L0X_HISTORY_H_
+#define VL53L0X_HISTORY_H_
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include <stddef.h>
+
+#include "vl53l0x.h"
+#include "vl53l0x_config.h"
+
+/************************************************************************/
+/* Defines, enums, structs, types                                       */
+/************************************************************************/
+
+/**	Sample with the time it was read
+*/
+typedef struct vl53l0x_record_struct_t
+{
+/**	Time the sample was read, in milliseconds of @link vl53l0x_getMilliseconds @endlink
+*/
+	u32 timestamp;
+/**	Measurement result
+*/
+	vl53l0x_sample_struct_t s_sample;
+}vl53l0x_record_struct_t;
+
+/**	Sample history of one sensor
+*/
+typedef struct vl53l0x_history_struct_t
+{
+/**	Sensor read by @link vl53l0x_history_update @endlink
+*/
+	vl53l0x_struct_t* ps_sensor;
+/**	Number of records pushed since the history was initialized. Wraps around.
+	@remark	Do not modify!
+*/
+	u32 pushCount;
+/**	Records, used as a ring
+	@remark	Do not modify!
+*/
+	vl53l0x_record_struct_t as_records[VL53L0X_HISTORY_SIZE];
+/**	Position of the newest record in as_records
+	@remark	Do not modify!
+*/
+	u8 newest;
+/**	Number of valid records
+	@remark	Do not modify!
+*/
+	u8 count;
+}vl53l0x_history_struct_t;
+
+/**	Position of an iteration over a time window
+*/
+typedef struct vl53l0x_historyIterator_struct_t
+{
+/**	History iterated over
+	@remark	Do not modify!
+*/
+	vl53l0x_history_struct_t const * ps_history;
+/**	Age of the next record to return
+	@remark	Do not modify!
+*/
+	u8 age;
+/**	Number of records left in the window
+	@remark	Do not modify!
+*/
+	u8 remaining;
+}vl53l0x_historyIterator_struct_t;
+
+/************************************************************************/
+/* Exported functions                                                   */
+/************************************************************************/
+
+/**	Clears the history.
+	@param[in]	ps_history: history to use
+*/
+void vl53l0x_history_init(vl53l0x_history_struct_t* ps_history);
+
+/**	Adds a record, overwriting the oldest one if the history is full.
+	@pre		Must be called after the history was initialized (with @link vl53l0x_history_init @endlink).
+	@remark		Timestamps must not decrease from one push to the next.
+	@param[in]	ps_history: history to use
+	@param[in]	ps_sample: measurement result
+	@param[in]	u32_timestamp: time the sample was read in milliseconds
+*/
+void vl53l0x_history_push(vl53l0x_history_struct_t* ps_history, vl53l0x_sample_struct_t const * ps_sample, u32 u32_timestamp);
+
+/**	Reads a new sample from the sensor, if one is available, and pushes it with the current time.
+	@pre		Must be called after the history was initialized (with @link vl53l0x_history_init @endlink) and the sensor is ranging.
+	@param[in]	ps_history: history to use
+	@return		Whether a new sample was pushed
+*/
+bool vl53l0x_history_update(vl53l0x_history_struct_t* ps_history);
+
+/**	Returns the newest record.
+	@param[in]	ps_history: history to use
+	@return		Newest record, NULL if the history is empty
+*/
+vl53l0x_record_struct_t const * vl53l0x_history_getLatest(vl53l0x_history_struct_t const * ps_history);
+
+/**	Returns a record by age.
+	@param[in]	ps_history: history to use
+	@param[in]	u8_age: 0 for the newest record, 1 for the one before, ...
+	@return		Record, NULL if the history doesn't go back that far
+*/
+vl53l0x_record_struct_t const * vl53l0x_history_get(vl53l0x_history_struct_t const * ps_history, u8 u8_age);
+
+/**	Returns the newest record read at or before a given time.
+	@remark		Binary search, at most log2(@link VL53L0X_HISTORY_SIZE @endlink) + 1 steps.
+	@param[in]	ps_history: history to use
+	@param[in]	u32_time: time in milliseconds
+	@return		Record, NULL if all the records are newer
+*/
+vl53l0x_record_struct_t const * vl53l0x_history_getAt(vl53l0x_history_struct_t const * ps_history, u32 u32_time);
+
+/**	Returns the number of records pushed since a consumer last looked.
+	@param[in]	ps_history: history to use
+	@param[in]	u32_pushCount: value of pushCount when the consumer last looked
+	@return		Number of new records. Can be larger than the number of records still available.
+*/
+u32 vl53l0x_history_countSince(vl53l0x_history_struct_t const * ps_history, u32 u32_pushCount);
+
+/**	Prepares an iteration over the records read between two times, oldest first.
+	@param[in]	ps_history: history to use
+	@param[out]	ps_iterator: iteration to prepare
+	@param[in]	u32_from: start of the window in milliseconds, included
+	@param[in]	u32_to: end of the window in milliseconds, included
+	@return		Number of records in the window
+*/
+u8 vl53l0x_history_window(vl53l0x_history_struct_t const * ps_history, vl53l0x_historyIterator_struct_t* ps_iterator, u32 u32_from, u32 u32_to);
+
+/**	Returns the next record of an iteration.
+	@pre		The iteration was prepared (with @link vl53l0x_history_window @endlink).
+	@param[in]	ps_iterator: iteration to use
+	@return		Next record, NULL at the end of the window
+*/
+vl53l0x_record_struct_t const * vl53l0x_history_next(vl53l0x_historyIterator_struct_t* ps_iterator);
+
+#endif /* VL53L0X_HISTORY_H_ */
@@ -0,0 +1,14 @@
+/**	@file		interrupt.h
+	@brief		Host replacement of the avr-libc interrupt definitions
+	@details	An interrupt service routine becomes a plain function, the benches call it where the hardware would run it. The simulation runs in a single thread, so enabling and disabling the interrupts does nothing.
+*/
+
+#ifndef AVR_INTERRUPT_H_
+#define AVR_INTERRUPT_H_
+
+#define ISR(vector)	void vector(void)
+
+#define sei()
+#define cli()
+
+#endif /* AVR_INTERRUPT_H_ */
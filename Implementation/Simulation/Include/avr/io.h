@@ -0,0 +1,39 @@
+/**	@file		io.h
+	@brief		Host replacement of the avr-libc register definitions
+	@details	The registers are plain variables. The benches write the port registers to drive the input pins, see @link gpio_sim.c @endlink. TWSR holds the status of the last simulated TWI operation, see @link i2c_sim.c @endlink.
+				The registers of TIMER0, TIMER1 and TIMER3 are defined in @link timer_sim.c @endlink. Their interrupt flags are plain bits too: writing a one to clear a flag sets it instead, so the benches clear the flags themselves.
+*/
+
+#ifndef AVR_IO_H_
+#define AVR_IO_H_
+
+#include "types.h"
+
+extern volatile u8 PINA, PINB, PINC, PIND;
+extern volatile u8 PORTA, PORTB, PORTC, PORTD;
+extern volatile u8 TWSR;
+
+extern volatile u8 TCCR0A, TCCR0B, TCNT0, TIFR0, TIMSK0;
+extern volatile u8 TCCR1A, TCCR1B, TIFR1, TIMSK1;
+extern volatile u16 TCNT1;
+extern volatile u8 TCCR3A, TCCR3B, TIFR3, TIMSK3;
+extern volatile u16 TCNT3;
+
+#define CS00	0
+#define CS01	1
+#define CS02	2
+#define CS10	0
+#define CS11	1
+#define CS12	2
+#define CS30	0
+#define CS31	1
+#define CS32	2
+
+#define TOV0	0
+#define TOV1	0
+#define TOV3	0
+#define TOIE0	0
+#define TOIE1	0
+#define TOIE3	0
+
+#endif /* AVR_IO_H_ */
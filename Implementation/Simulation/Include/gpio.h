@@ -0,0 +1,84 @@
+/**	@file		gpio.h
+	@brief		Host replacement of the HAL GPIO
+	@details	Output changes are forwarded to the handlers attached with @link gpio_sim_attach @endlink, so simulated devices can follow their XSHUT pins.
+				Input levels are driven with @link gpio_sim_setInputs @endlink, which calls the enabled pin interrupts of the pins that changed, one after the other as pending interrupts would run.
+*/
+
+#ifndef GPIO_H_
+#define GPIO_H_
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include "types.h"
+
+/************************************************************************/
+/* Defines, enums, structs, types                                       */
+/************************************************************************/
+
+typedef enum gpio_port_enum_t
+{
+	PA, PB, PC, PD
+}gpio_port_enum_t;
+
+typedef enum gpio_direction_enum_t
+{
+	INPUT, OUTPUT
+}gpio_direction_enum_t;
+
+typedef enum gpio_interrupt_enum_t
+{
+	INTERRUPT_TOGGLE, INTERRUPT_RISING, INTERRUPT_FALLING
+}gpio_interrupt_enum_t;
+
+typedef struct gpio_struct_t
+{
+	gpio_port_enum_t port;
+	u8 number;
+	gpio_direction_enum_t direction;
+}gpio_struct_t;
+
+/**	Called with the new level whenever a simulated output pin changes
+*/
+typedef void (*gpio_sim_handler_t)(void* p_context, bool b_level);
+
+/************************************************************************/
+/* Exported functions                                                   */
+/************************************************************************/
+
+void gpio_init(gpio_struct_t s_gpio);
+void gpio_setDirectionOutput(gpio_struct_t* ps_gpio);
+void gpio_out_set(gpio_struct_t s_gpio);
+void gpio_out_reset(gpio_struct_t s_gpio);
+
+void gpio_attachInterrupt(gpio_struct_t s_gpio, gpio_interrupt_enum_t e_interrupt, void (*f_handler)(void));
+void gpio_enableInterrupt(gpio_struct_t s_gpio, gpio_interrupt_enum_t e_interrupt);
+void gpio_disableInterrupt(gpio_struct_t s_gpio, gpio_interrupt_enum_t e_interrupt);
+
+/**	Calls a handler whenever the level of an output pin is set.
+	@param[in]	s_gpio: pin to follow, only port and number are used
+	@param[in]	f_handler: function to call
+	@param[in]	p_context: passed back to the handler
+	@return		Whether there was room for one more handler
+*/
+bool gpio_sim_attach(gpio_struct_t s_gpio, gpio_sim_handler_t f_handler, void* p_context);
+
+/**	Sets the levels of input pins of one port, then runs the enabled interrupts of the pins which changed.
+	@param[in]	e_port: port of the pins
+	@param[in]	u8_mask: pins to set
+	@param[in]	u8_levels: new levels of the pins in the mask
+*/
+void gpio_sim_setInputs(gpio_port_enum_t e_port, u8 u8_mask, u8 u8_levels);
+
+/**	Sets the level of one input pin and runs its interrupt if enabled and the level changed.
+	@param[in]	s_gpio: pin to set, only port and number are used
+	@param[in]	b_level: new level
+*/
+void gpio_sim_setInput(gpio_struct_t s_gpio, bool b_level);
+
+/**	Removes all the handlers and pin interrupts and clears the port registers.
+*/
+void gpio_sim_reset();
+
+#endif /* GPIO_H_ */
@@ -0,0 +1,42 @@
+/**	@file		i2c.h
+	@brief		Host replacement of the HAL I2C master
+	@details	Transfers are routed to the devices attached with @link i2c_sim_attach @endlink. See @link i2c_sim.h @endlink.
+				Like the TWI hardware, every call leaves its status in TWSR (see util/twi.h), which is what the transaction engine checks. The return values of i2c_sendStart, i2c_sendRepStart and i2c_write are that status as well, so code relying on a 0 or 1 convention of the HAL fails here.
+*/
+
+#ifndef I2C_H_
+#define I2C_H_
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include "types.h"
+
+/************************************************************************/
+/* Defines, enums, structs, types                                       */
+/************************************************************************/
+
+#define I2C_WRITE	0
+#define I2C_READ	1
+
+typedef struct i2c_struct_t
+{
+	u32 frequency;
+}i2c_struct_t;
+
+/************************************************************************/
+/* Exported functions                                                   */
+/************************************************************************/
+
+void i2c_init(i2c_struct_t s_i2c);
+void i2c_start();
+void i2c_stop();
+u8 i2c_sendStart(u8 u8_address);
+u8 i2c_sendRepStart(u8 u8_address);
+void i2c_sendStop();
+u8 i2c_write(u8 u8_data);
+u8 i2c_readAck();
+u8 i2c_readNak();
+
+#endif /* I2C_H_ */
@@ -0,0 +1,90 @@
+/**	@file		i2c_sim.h
+	@brief		Simulated I2C bus
+	@details	Implements the HAL I2C master API of @link i2c.h @endlink on the host. Each byte moves the simulated clock by 9 bit times at the frequency given to i2c_init, start and stop conditions by one bit time each.
+				Every transfer is counted, so driver changes can be compared by their bus usage without hardware.
+				A transaction lasts from i2c_sendStart to i2c_sendStop. Repeated starts are part of the same transaction.
+*/
+
+#ifndef I2C_SIM_H_
+#define I2C_SIM_H_
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include "i2c.h"
+
+/************************************************************************/
+/* Defines, enums, structs, types                                       */
+/************************************************************************/
+
+/**	Maximum number of devices on the simulated bus
+*/
+#define I2C_SIM_MAX_DEVICES	8
+
+/**	Device attached to the simulated bus
+*/
+typedef struct i2c_sim_device_struct_t
+{
+/**	Called on (repeated) start conditions. Returns whether the device acknowledges the address.
+*/
+	bool (*start)(void* p_context, u8 u8_address, bool b_read);
+/**	Called for each byte written to the device once it acknowledged its address. Returns whether the device acknowledges the byte.
+*/
+	bool (*write)(void* p_context, u8 u8_data);
+/**	Called for each byte read from the device once it acknowledged its address.
+*/
+	u8 (*read)(void* p_context);
+/**	Called on stop conditions.
+*/
+	void (*stop)(void* p_context);
+/**	Passed back to all the functions above
+*/
+	void* p_context;
+}i2c_sim_device_struct_t;
+
+/**	Bus usage since the last @link i2c_sim_resetStatistics @endlink
+*/
+typedef struct i2c_sim_statistics_struct_t
+{
+/**	Start conditions, not counting repeated starts
+*/
+	u32 transactions;
+/**	Bytes on the bus, including the address bytes
+*/
+	u32 bytes;
+/**	Address or data bytes which weren't acknowledged
+*/
+	u32 nacks;
+/**	Address bytes acknowledged by more than one device
+*/
+	u32 collisions;
+/**	Time the bus was busy in nanoseconds
+*/
+	u64 busTime;
+}i2c_sim_statistics_struct_t;
+
+/************************************************************************/
+/* Exported functions                                                   */
+/************************************************************************/
+
+/**	Adds a device to the bus.
+	@param[in]	ps_device: device to add, must stay valid until @link i2c_sim_reset @endlink
+	@return		Whether there was room for one more device
+*/
+bool i2c_sim_attach(i2c_sim_device_struct_t* ps_device);
+
+/**	Removes all the devices and clears the statistics.
+*/
+void i2c_sim_reset();
+
+/**	Clears the statistics.
+*/
+void i2c_sim_resetStatistics();
+
+/**	Returns the bus usage.
+	@return		Statistics since the last reset
+*/
+i2c_sim_statistics_struct_t i2c_sim_getStatistics();
+
+#endif /* I2C_SIM_H_ */
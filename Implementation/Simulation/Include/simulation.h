@@ -0,0 +1,44 @@
+/**	@file		simulation.h
+	@brief		Simulated clock for running the drivers on the host
+	@details	The simulation replaces the HAL and avr-libc headers with the ones in Simulation/Include, so the driver sources build unchanged with the host compiler.
+				Time only moves forward when the bus transfers bytes or a busy wait is called, which makes every run deterministic.
+				Basic flow:
+				1. Call @link simulation_reset @endlink.
+				2. Register the millisecond timer interrupt of the driver with @link simulation_setTickHandler @endlink.
+				3. Create the simulated devices (e.g. @link vl53l0x_sim_init @endlink) and run the driver code.
+				4. Read the elapsed time with @link simulation_getTime @endlink and the bus usage with @link i2c_sim_getStatistics @endlink.
+*/
+
+#ifndef SIMULATION_H_
+#define SIMULATION_H_
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include "types.h"
+
+/************************************************************************/
+/* Exported functions                                                   */
+/************************************************************************/
+
+/**	Resets the clock to 0, the bus and the GPIO handlers.
+*/
+void simulation_reset();
+
+/**	Sets the function called every simulated millisecond, as the timer interrupt would on the target.
+	@param[in]	f_tick: function to call, NULL to disable
+*/
+void simulation_setTickHandler(void (*f_tick)(void));
+
+/**	Moves the clock forward.
+	@param[in]	u64_nanoseconds: time to add
+*/
+void simulation_advance(u64 u64_nanoseconds);
+
+/**	Returns the simulated time.
+	@return		Nanoseconds since @link simulation_reset @endlink
+*/
+u64 simulation_getTime();
+
+#endif /* SIMULATION_H_ */
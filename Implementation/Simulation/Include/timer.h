@@ -0,0 +1,24 @@
+/**	@file		timer.h
+	@brief		Host replacement of the HAL timer
+	@details	Only the peripheral names are needed by the simulated modules. The timer registers are plain variables defined in @link timer_sim.c @endlink, the benches step them and call the overflow interrupt routines themselves.
+*/
+
+#ifndef TIMER_H_
+#define TIMER_H_
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include "types.h"
+
+/************************************************************************/
+/* Defines, enums, structs, types                                       */
+/************************************************************************/
+
+typedef enum timer_peripheral_enum_t
+{
+	TIMER0, TIMER1, TIMER2, TIMER3
+}timer_peripheral_enum_t;
+
+#endif /* TIMER_H_ */
@@ -0,0 +1,28 @@
+/**	@file		types.h
+	@brief		Host replacement of the HAL basic types
+	@details	Only used when building the drivers on the host against the simulation, see @link simulation.h @endlink.
+*/
+
+#ifndef TYPES_H_
+#define TYPES_H_
+
+#include <stdint.h>
+
+typedef uint8_t		u8;
+typedef uint16_t	u16;
+typedef uint32_t	u32;
+typedef uint64_t	u64;
+typedef int8_t		s8;
+typedef int16_t		s16;
+typedef int32_t		s32;
+typedef int64_t		s64;
+
+/* Fixed point with 24 integer bits and 8 fraction bits */
+typedef s32			f24;
+
+typedef u8 bool;
+
+#define FALSE	0
+#define TRUE	1
+
+#endif /* TYPES_H_ */
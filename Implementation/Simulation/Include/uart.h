@@ -0,0 +1,11 @@
+/**	@file		uart.h
+	@brief		Host replacement of the HAL UART
+	@details	Only included by modules which don't call it in the simulated code paths, so it declares nothing.
+*/
+
+#ifndef UART_H_
+#define UART_H_
+
+#include "types.h"
+
+#endif /* UART_H_ */
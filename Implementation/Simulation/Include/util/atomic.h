@@ -0,0 +1,14 @@
+/**	@file		atomic.h
+	@brief		Host replacement of the avr-libc atomic blocks
+	@details	The simulation runs in a single thread, so the block only has to execute its body once.
+*/
+
+#ifndef UTIL_ATOMIC_H_
+#define UTIL_ATOMIC_H_
+
+#define ATOMIC_RESTORESTATE
+#define ATOMIC_FORCEON
+
+#define ATOMIC_BLOCK(type)	for (u8 __atomicOnce = 1; __atomicOnce; __atomicOnce = 0)
+
+#endif /* UTIL_ATOMIC_H_ */
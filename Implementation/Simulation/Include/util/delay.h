@@ -0,0 +1,12 @@
+/**	@file		delay.h
+	@brief		Host replacement of the avr-libc busy waits
+	@details	Delays advance the simulated clock instead of spinning, see @link simulation.h @endlink.
+*/
+
+#ifndef UTIL_DELAY_H_
+#define UTIL_DELAY_H_
+
+void _delay_ms(double d_ms);
+void _delay_us(double d_us);
+
+#endif /* UTIL_DELAY_H_ */
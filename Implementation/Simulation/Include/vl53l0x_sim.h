@@ -0,0 +1,112 @@
+/**	@file		vl53l0x_sim.h
+	@brief		Register level model of the VL53L0X distance sensor
+	@details	Answers on the simulated I2C bus like the real sensor does for the registers used by @link vl53l0x.h @endlink:
+				- register pages, auto increment, address change, XSHUT reset
+				- single shot, back-to-back and timed continuous ranging, with the measurement time derived from the programmed timeouts
+				- interrupt status for new samples and for the threshold modes
+				- result registers (range status, effective SPAD count, signal rate, ambient rate, range) fed from a script
+				- range offset and cover glass crosstalk, with the offset and crosstalk compensation registers
+				Faults can be injected to exercise the error paths of the driver: NACKed transfers and measurements which never finish.
+				Basic flow:
+				1. Initialize a @link vl53l0x_sim_struct_t @endlink. Set the XSHUT pin the driver uses and optionally a script of samples.
+				2. Pass it to @link vl53l0x_sim_init @endlink.
+				3. Run the driver. The model is powered while its XSHUT pin is high.
+*/
+
+#ifndef VL53L0X_SIM_H_
+#define VL53L0X_SIM_H_
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include "gpio.h"
+#include "i2c_sim.h"
+
+/************************************************************************/
+/* Defines, enums, structs, types                                       */
+/************************************************************************/
+
+/**	Range status reported with valid samples
+*/
+#define VL53L0X_SIM_RANGE_VALID	11
+
+/**	One sample of a range script
+*/
+typedef struct vl53l0x_sim_sample_struct_t
+{
+/**	Range in millimeters
+*/
+	u16 range;
+/**	Range status, @link VL53L0X_SIM_RANGE_VALID @endlink for a valid measurement
+*/
+	u8 rangeStatus;
+/**	Return signal rate in MCPS, Q9.7
+*/
+	u16 signalRate;
+}vl53l0x_sim_sample_struct_t;
+
+/**	Simulated sensor
+*/
+typedef struct vl53l0x_sim_struct_t
+{
+/**	XSHUT pin, same as in the @link vl53l0x_struct_t @endlink driving this sensor. Only port and number are used.
+*/
+	gpio_struct_t xshutPin;
+/**	Duration of a measurement in microseconds. 0 to derive it from the timeouts programmed by the driver.
+*/
+	u32 measurementTime;
+/**	Samples returned by consecutive measurements. The script restarts when its end is reached. NULL for a constant valid range of 500mm.
+*/
+	vl53l0x_sim_sample_struct_t const * ps_script;
+/**	Number of samples in ps_script
+*/
+	u16 scriptLength;
+/**	Error in millimeters added to every range before the offset register is applied
+*/
+	s16 partOffset;
+/**	Cover glass crosstalk in MCPS, Q9.7. It adds to the signal rate and pulls the range towards zero in proportion to its share of the signal.
+*/
+	u16 crosstalkRate;
+/**	Number of address bytes to NACK, decremented on each one. Use it to simulate a sensor which doesn't answer.
+*/
+	u16 nackCount;
+/**	Number of address bytes to acknowledge before nackCount applies. Use it to make a frame fail after its first messages reached the sensor.
+*/
+	u16 nackDelay;
+/**	If TRUE, measurements never finish and the start bit never clears.
+*/
+	bool stuckBusy;
+/**	Number of completed measurements
+	@remark	Do not modify!
+*/
+	u32 samples;
+/**	Internal state
+	@remark	Do not modify!
+*/
+	i2c_sim_device_struct_t s_device;
+	bool powered;
+	u8 address;
+	u8 au8_registers[8][256];
+	u8 page;
+	u8 index;
+	bool indexReceived;
+	u8 rangingMode;
+	bool startPending;
+	u64 startClearTime;
+	u64 sampleTime;
+	u16 scriptPosition;
+}vl53l0x_sim_struct_t;
+
+/************************************************************************/
+/* Exported functions                                                   */
+/************************************************************************/
+
+/**	Attaches the model to the simulated bus and to its XSHUT pin. The sensor starts held in reset.
+	@pre		The simulation was reset (with @link simulation_reset @endlink).
+	@param[in]	ps_sim: simulated sensor
+	@return		Whether the bus and the GPIO had room for one more device
+*/
+bool vl53l0x_sim_init(vl53l0x_sim_struct_t* ps_sim);
+
+#endif /* VL53L0X_SIM_H_ */
@@ -0,0 +1,63 @@
+/**	@file		debug_sim.c
+	@brief		Host replacement of the debug logging functions
+	@details	Writes to the standard output instead of the UART. See @link debug.h @endlink for details.
+*/
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include <stdio.h>
+
+#include "debug.h"
+
+/************************************************************************/
+/* Exported functions                                                   */
+/************************************************************************/
+
+void debug_init()
+{
+}
+
+void debug_start()
+{
+}
+
+void debug_stop()
+{
+}
+
+void debug_writeChar(u8 u8_char)
+{
+	putchar(u8_char);
+}
+
+void debug_writeString(char* pc8_string)
+{
+	fputs(pc8_string, stdout);
+}
+
+void debug_writeDecimal(u16 u16_data)
+{
+	printf("%u", u16_data);
+}
+
+void debug_writeHex(u8 u8_data)
+{
+	printf("%02X", u8_data);
+}
+
+void debug_writeHexWord(u16 u16_data)
+{
+	printf("%04X", u16_data);
+}
+
+void debug_writeHexDWord(u32 u32_data)
+{
+	printf("%08X", u32_data);
+}
+
+void debug_writeNewLine()
+{
+	putchar('\n');
+}
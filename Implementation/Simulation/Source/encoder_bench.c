@@ -0,0 +1,592 @@
+/**	@file		encoder_bench.c
+	@brief		Edge driven checks of the encoder drivers
+	@details	Runs the unchanged velocity estimator against a simulated encoder: rising edges of output A are captured from a 2 MHz, 16 bit timer derived from the simulated clock and output B is driven through the simulated PIND register.
+				The scenarios cover steady speeds in both directions, captures latched just before an update but handled after it, the bound while no edge comes, the stop and the restart after it.
+				The quadrature decoder of encoder.c is driven through the simulated pin interrupts, one output changing per step, and through steps where both outputs change at once.
+				The registration checks fill every encoder slot, initialize encoders again and check that each pin interrupt only counts its own encoder.
+				The delta checks use a clock counting the edges driven so far, which also drives edges while it is read, so a paired delta has as many counts as clock ticks.
+				The timer counter checks step TCNT0 and run the overflow interrupt of encoderCounter.c where the hardware would, also leaving an overflow pending across an update.
+				Build and run from the Implementation directory:
+				gcc -std=gnu99 -Wall -DENCODERCOUNTER_USING_TIMER0 -ISimulation/Include -IInclude -IExample/Config Simulation/Source/simulation.c Simulation/Source/i2c_sim.c Simulation/Source/gpio_sim.c Simulation/Source/timer_sim.c Simulation/Source/encoder_bench.c Source/gpioFast.c Source/encoder.c Source/encoderCounter.c Source/encoderVelocity.c -o encoder_bench && ./encoder_bench
+				The exit code is the number of failed checks.
+*/
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include <stdio.h>
+#include <avr/io.h>
+
+#include "encoder.h"
+#include "encoderCounter.h"
+#include "encoderVelocity.h"
+#include "simulation.h"
+
+/************************************************************************/
+/* Defines, enums, structs, types                                       */
+/************************************************************************/
+
+/* Capture timer of 2 MHz, as timer 1 with a prescaler of 8 at 16 MHz */
+#define BENCH_TIMER_FREQUENCY	2000000UL
+#define BENCH_TICK_NS			500
+
+#define BENCH_UPDATE_NS			10000000ULL
+
+#ifndef ENCODERCOUNTER_USING_TIMER0
+#error The timer counter checks use TIMER0, build with -DENCODERCOUNTER_USING_TIMER0
+#endif
+
+/************************************************************************/
+/* Internal variables                                                   */
+/************************************************************************/
+
+u8 u8_failures;
+
+/* Simulated encoder: time of the next rising edge of A, cycle period and direction. A period of 0 means stopped. */
+u64 u64_nextEdge;
+u64 u64_period;
+bool b_forward;
+
+/* Edges latched less than this before an update are handled after it, as a pending capture interrupt would be */
+u64 u64_captureDelay;
+
+/* Time of the next update, of the last captured edge and of the last edge used by an update */
+u64 u64_nextUpdate;
+u64 u64_lastEdge;
+u64 u64_usedEdge;
+bool b_edgeSinceUpdate;
+
+/* Latency in microseconds expected for the last update which saw edges */
+u32 u32_expectedLatency;
+
+/* Encoders of the decoder checks, one more than can be registered. They stay registered in encoder.c between the checks. */
+encoder_struct_t as_encoders[ENCODER_MAX_ENCODERS + 1];
+
+/* Encoder moved by the edge clock, edges it drives during its next reads and edges driven so far */
+encoder_struct_t* ps_clockEncoder;
+u8 u8_clockEdges;
+u32 u32_clockSteps;
+
+/* Direction returned to the timer counter */
+s8 s8_commandedDirection;
+
+/* Next quadrature state, (A << 1) | B, with A leading B and with B leading A */
+const u8 au8_forwardState[4] = {2, 0, 3, 1};
+const u8 au8_reverseState[4] = {1, 3, 0, 2};
+
+/************************************************************************/
+/* Internal functions                                                   */
+/************************************************************************/
+
+/* Overflow interrupt routine of encoderCounter.c */
+void TIMER0_OVF_vect(void);
+
+void check(bool b_condition, char const * pc_description)
+{
+	if (!b_condition)
+	{
+		printf("FAILED: %s\n", pc_description);
+		u8_failures++;
+	}
+}
+
+u16 benchTimer()
+{
+	return simulation_getTime() / BENCH_TICK_NS;
+}
+
+void benchAdvanceTo(u64 u64_time)
+{
+	if (u64_time > simulation_getTime())
+		simulation_advance(u64_time - simulation_getTime());
+}
+
+void benchCapture(encoderVelocity_struct_t* ps_velocity, u64 u64_edge)
+{
+	/* On a rising edge of A, B is still low when A leads */
+	PIND = b_forward ? 0x00 : 0x02;
+	encoderVelocity_capture(ps_velocity, u64_edge / BENCH_TICK_NS);
+	u64_lastEdge = u64_edge;
+	b_edgeSinceUpdate = TRUE;
+}
+
+void benchSetSpeed(s32 s32_countsPerSecond)
+{
+	if (s32_countsPerSecond == 0)
+	{
+		u64_period = 0;
+		return;
+	}
+
+	b_forward = s32_countsPerSecond > 0;
+	u64_period = 4000000000ULL / (s32_countsPerSecond < 0 ? -s32_countsPerSecond : s32_countsPerSecond);
+	u64_nextEdge = simulation_getTime() + u64_period;
+}
+
+void benchRun(encoderVelocity_struct_t* ps_velocity, u16 u16_updates)
+{
+	u64 latched;
+	bool b_latched;
+
+	while (u16_updates--)
+	{
+		b_latched = FALSE;
+
+		while (u64_period != 0 && u64_nextEdge < u64_nextUpdate)
+		{
+			benchAdvanceTo(u64_nextEdge);
+			if (u64_nextEdge + u64_captureDelay >= u64_nextUpdate)
+			{
+				latched = u64_nextEdge;
+				b_latched = TRUE;
+			}
+			else
+				benchCapture(ps_velocity, u64_nextEdge);
+			u64_nextEdge += u64_period;
+		}
+
+		benchAdvanceTo(u64_nextUpdate);
+		if (b_edgeSinceUpdate)
+		{
+			/* Time from the middle of the measured edges to the update */
+			u32_expectedLatency = (u64_nextUpdate - (u64_usedEdge + u64_lastEdge) / 2) / 1000;
+			u64_usedEdge = u64_lastEdge;
+			b_edgeSinceUpdate = FALSE;
+		}
+		encoderVelocity_update(ps_velocity);
+		u64_nextUpdate += BENCH_UPDATE_NS;
+
+		if (b_latched)
+			benchCapture(ps_velocity, latched);
+	}
+}
+
+void benchInit(encoderVelocity_struct_t* ps_velocity)
+{
+	simulation_reset();
+
+	ps_velocity->B.port = PD;
+	ps_velocity->B.number = 1;
+	ps_velocity->B.direction = INPUT;
+	ps_velocity->timerFrequency = BENCH_TIMER_FREQUENCY;
+	ps_velocity->f_timer = benchTimer;
+	encoderVelocity_init(ps_velocity);
+
+	u64_period = 0;
+	u64_captureDelay = 0;
+	u64_nextUpdate = BENCH_UPDATE_NS;
+	u64_lastEdge = 0;
+	u64_usedEdge = 0;
+	b_edgeSinceUpdate = FALSE;
+}
+
+bool benchClose(s32 s32_velocity, s32 s32_countsPerSecond)
+{
+	s32 expected = s32_countsPerSecond << ENCODERVELOCITY_FRACTION_BITS;
+	s32 error = s32_velocity - expected;
+
+	/* Within 0.5 percent */
+	return (error < 0 ? -error : error) <= (expected < 0 ? -expected : expected) / 200;
+}
+
+bool benchLatencyClose(encoderVelocity_struct_t* ps_velocity)
+{
+	s32 error = (s32)encoderVelocity_getLatencyUs(ps_velocity) - (s32)u32_expectedLatency;
+
+	/* Captures are quantized to timer ticks */
+	return error >= -2 && error <= 2;
+}
+
+void benchSteady(s32 s32_countsPerSecond, u16 u16_updates)
+{
+	encoderVelocity_struct_t s_velocity;
+	char ac_description[64];
+
+	benchInit(&s_velocity);
+	benchSetSpeed(s32_countsPerSecond);
+	benchRun(&s_velocity, u16_updates);
+
+	printf("%6ld counts/s: velocity %9.2f, latency %6lu us\n", (long)s32_countsPerSecond, (double)s_velocity.velocity / (1 << ENCODERVELOCITY_FRACTION_BITS), (unsigned long)encoderVelocity_getLatencyUs(&s_velocity));
+	snprintf(ac_description, sizeof(ac_description), "velocity at %ld counts/s", (long)s32_countsPerSecond);
+	check(benchClose(s_velocity.velocity, s32_countsPerSecond), ac_description);
+	snprintf(ac_description, sizeof(ac_description), "latency at %ld counts/s", (long)s32_countsPerSecond);
+	check(benchLatencyClose(&s_velocity), ac_description);
+}
+
+void benchLateCapture()
+{
+	encoderVelocity_struct_t s_velocity;
+	u16 i;
+
+	/* One edge per update period, each lands 2.5 us before an update and its capture is handled after it. The last capture is then older than the previous update. */
+	benchInit(&s_velocity);
+	benchSetSpeed(400);
+	u64_nextEdge = u64_nextUpdate - 2500;
+	u64_captureDelay = 5000;
+
+	benchRun(&s_velocity, 2);
+	for (i = 0; i < 20; i++)
+	{
+		benchRun(&s_velocity, 1);
+		check(benchClose(s_velocity.velocity, 400), "velocity with captures handled after the update");
+		check(benchLatencyClose(&s_velocity), "latency with captures handled after the update");
+	}
+}
+
+void benchStop()
+{
+	encoderVelocity_struct_t s_velocity;
+	u32 sinceEdge;
+	s32 bound;
+	u16 i;
+
+	/* 50 counts/s is one edge every 80 ms, so most updates see none */
+	benchInit(&s_velocity);
+	benchSetSpeed(50);
+	benchRun(&s_velocity, 32);
+	check(benchClose(s_velocity.velocity, 50), "velocity between the edges at 50 counts/s");
+
+	benchSetSpeed(0);
+	for (i = 0; i < 30; i++)
+	{
+		benchRun(&s_velocity, 1);
+		sinceEdge = (u64_nextUpdate - BENCH_UPDATE_NS - u64_lastEdge) / BENCH_TICK_NS;
+		if (sinceEdge >= BENCH_TIMER_FREQUENCY / 1000 * ENCODERVELOCITY_STOP_TIME_MS)
+			break;
+
+		/* The velocity can't be more than one cycle over the time since the last edge */
+		bound = ((u64)ENCODERVELOCITY_COUNTS_PER_EDGE * BENCH_TIMER_FREQUENCY << ENCODERVELOCITY_FRACTION_BITS) / sinceEdge;
+		if (bound < (50 << ENCODERVELOCITY_FRACTION_BITS))
+		{
+			check(s_velocity.velocity >= bound - 1 && s_velocity.velocity <= bound, "velocity is held to the bound after the last edge");
+			check(s_velocity.latency == sinceEdge / 2, "latency of the bound is half the time since the last edge");
+		}
+		else
+			check(benchClose(s_velocity.velocity, 50), "velocity is kept while under the bound");
+	}
+	printf("stopped after %lu ms without edge\n", (unsigned long)(sinceEdge / (BENCH_TIMER_FREQUENCY / 1000)));
+	check(s_velocity.velocity == 0 && s_velocity.latency == 0, "velocity is 0 after the stop time");
+
+	/* The first update with edges after the stop has no measured start, the next one measures */
+	benchRun(&s_velocity, 5);
+	benchSetSpeed(2000);
+	benchRun(&s_velocity, 1);
+	check(s_velocity.velocity == 0, "the first edges after a stop only restart the measurement");
+	benchRun(&s_velocity, 1);
+	check(benchClose(s_velocity.velocity, 2000), "velocity after the restart");
+	check(benchLatencyClose(&s_velocity), "latency after the restart");
+}
+
+u8 benchQuadratureState(encoder_struct_t* ps_encoder)
+{
+	return (gpioFast_read(&ps_encoder->s_fastA) ? 2 : 0) | (gpioFast_read(&ps_encoder->s_fastB) ? 1 : 0);
+}
+
+/* Changes one output, the one of the next state in the given direction */
+void benchQuadratureStep(encoder_struct_t* ps_encoder, bool b_forward)
+{
+	u8 state = benchQuadratureState(ps_encoder);
+	u8 next = b_forward ? au8_forwardState[state] : au8_reverseState[state];
+
+	if ((state ^ next) & 2)
+		gpio_sim_setInput(ps_encoder->A, next & 2);
+	else
+		gpio_sim_setInput(ps_encoder->B, next & 1);
+}
+
+/* Changes both outputs at once, skipping a state. Both pins must be on the same port. */
+void benchQuadratureDoubleStep(encoder_struct_t* ps_encoder)
+{
+	u8 next = au8_forwardState[au8_forwardState[benchQuadratureState(ps_encoder)]];
+	u8 maskA = 1 << ps_encoder->A.number;
+	u8 maskB = 1 << ps_encoder->B.number;
+
+	gpio_sim_setInputs(ps_encoder->A.port, maskA | maskB, ((next & 2) ? maskA : 0) | ((next & 1) ? maskB : 0));
+}
+
+void benchClockedSteps(u16 u16_steps)
+{
+	while (u16_steps--)
+	{
+		benchQuadratureStep(ps_clockEncoder, TRUE);
+		u32_clockSteps++;
+	}
+}
+
+/* An edge coming while the clock is read, after its value was taken */
+u32 benchEdgeClock()
+{
+	u32 time = u32_clockSteps;
+
+	if (u8_clockEdges != 0)
+	{
+		u8_clockEdges--;
+		benchClockedSteps(1);
+	}
+
+	return time;
+}
+
+void benchEncoderPins(encoder_struct_t* ps_encoder, gpio_port_enum_t e_port, u8 u8_number)
+{
+	ps_encoder->A.port = e_port;
+	ps_encoder->A.number = u8_number;
+	ps_encoder->A.direction = INPUT;
+	ps_encoder->B.port = e_port;
+	ps_encoder->B.number = u8_number + 1;
+	ps_encoder->B.direction = INPUT;
+	ps_encoder->f_clock = NULL;
+
+	/* The bench drives the pins through these, also for an encoder which is rejected */
+	gpioFast_init(&ps_encoder->s_fastA, ps_encoder->A);
+	gpioFast_init(&ps_encoder->s_fastB, ps_encoder->B);
+}
+
+void benchQuadrature()
+{
+	encoder_struct_t* ps_encoder = &as_encoders[0];
+	s32 expected = 0;
+	bool b_stepped = TRUE;
+	u16 i;
+
+	simulation_reset();
+	benchEncoderPins(ps_encoder, PA, 0);
+	check(encoder_init(ps_encoder), "encoder is registered");
+	encoder_start(ps_encoder);
+
+	/* 10 cycles with A leading, then 15 with B leading, each edge counting one */
+	for (i = 0; i < 40; i++)
+	{
+		benchQuadratureStep(ps_encoder, TRUE);
+		b_stepped = b_stepped && encoder_getCounter(ps_encoder) == ++expected;
+	}
+	check(b_stepped, "every edge with A leading counts up");
+	check(expected == 40, "4 counts per cycle with A leading");
+	for (i = 0; i < 60; i++)
+	{
+		benchQuadratureStep(ps_encoder, FALSE);
+		b_stepped = b_stepped && encoder_getCounter(ps_encoder) == --expected;
+	}
+	check(b_stepped, "every edge with B leading counts down");
+	check(encoder_getCounter(ps_encoder) == -20, "4 counts per cycle with B leading");
+	check(encoder_getIllegalTransitions(ps_encoder) == 0, "no illegal transition with one output changing per edge");
+
+	/* Both outputs changing at once, from each of the 4 states */
+	for (i = 0; i < 4; i++)
+	{
+		benchQuadratureDoubleStep(ps_encoder);
+		check(encoder_getCounter(ps_encoder) == expected, "a double step doesn't count");
+		check(encoder_getIllegalTransitions(ps_encoder) == i + 1, "a double step is an illegal transition");
+		benchQuadratureStep(ps_encoder, TRUE);
+		check(encoder_getCounter(ps_encoder) == ++expected, "decoding goes on from the state after a double step");
+	}
+
+	encoder_stop(ps_encoder);
+	benchQuadratureStep(ps_encoder, TRUE);
+	check(encoder_getCounter(ps_encoder) == expected, "no count while stopped");
+	encoder_start(ps_encoder);
+	benchQuadratureStep(ps_encoder, FALSE);
+	check(encoder_getCounter(ps_encoder) == expected - 1, "counting resumes from the state at the start");
+
+	encoder_resetCounter(ps_encoder);
+	check(encoder_getCounter(ps_encoder) == 0 && encoder_getIllegalTransitions(ps_encoder) == 0, "reset clears both counters");
+}
+
+void benchRegistration()
+{
+	encoder_struct_t* ps_extra = &as_encoders[ENCODER_MAX_ENCODERS];
+	bool b_routed = TRUE;
+	u8 i, j;
+
+	/* The first encoder is still registered by the decoder checks, initializing it again must keep its slot */
+	simulation_reset();
+	for (i = 0; i < ENCODER_MAX_ENCODERS; i++)
+	{
+		benchEncoderPins(&as_encoders[i], i < 4 ? PA : PB, (i % 4) * 2);
+		check(encoder_init(&as_encoders[i]), "encoders up to ENCODER_MAX_ENCODERS are registered");
+	}
+	benchEncoderPins(ps_extra, PC, 0);
+	check(!encoder_init(ps_extra), "one encoder more than ENCODER_MAX_ENCODERS is rejected");
+	check(encoder_init(&as_encoders[3]), "an encoder initialized again keeps its slot when all are taken");
+
+	for (i = 0; i < ENCODER_MAX_ENCODERS; i++)
+		encoder_start(&as_encoders[i]);
+
+	/* Encoder i moves i + 1 edges, forward for the even ones */
+	for (i = 0; i < ENCODER_MAX_ENCODERS; i++)
+		for (j = 0; j <= i; j++)
+			benchQuadratureStep(&as_encoders[i], !(i & 1));
+	benchQuadratureStep(ps_extra, TRUE);
+
+	for (i = 0; i < ENCODER_MAX_ENCODERS; i++)
+		b_routed = b_routed && encoder_getCounter(&as_encoders[i]) == ((i & 1) ? -(i + 1) : i + 1) && encoder_getIllegalTransitions(&as_encoders[i]) == 0;
+	check(b_routed, "each pin interrupt counts its own encoder only");
+	check(encoder_getCounter(ps_extra) == 0, "the rejected encoder doesn't count");
+}
+
+void benchDelta()
+{
+	encoder_delta_struct_t s_delta;
+	s32 counts = 0;
+	u32 elapsed = 0;
+	bool b_paired = TRUE;
+	u8 i;
+
+	simulation_reset();
+	ps_clockEncoder = &as_encoders[0];
+	benchEncoderPins(ps_clockEncoder, PA, 0);
+	ps_clockEncoder->f_clock = benchEdgeClock;
+	u8_clockEdges = 0;
+	u32_clockSteps = 0;
+	check(encoder_init(ps_clockEncoder), "encoder with a clock is registered");
+	encoder_start(ps_clockEncoder);
+
+	/* Up to 3 edges during the clock reads of a delta, the sampling tries again until a read sees none */
+	for (i = 0; i < 20; i++)
+	{
+		benchClockedSteps(i % 5);
+		u8_clockEdges = i % 4;
+		encoder_getDelta(ps_clockEncoder, &s_delta);
+		b_paired = b_paired && s_delta.counts == (s32)s_delta.elapsed;
+		counts += s_delta.counts;
+		elapsed += s_delta.elapsed;
+	}
+	check(b_paired, "counts and elapsed are paired with edges during the clock reads");
+	check(counts == encoder_getCounter(ps_clockEncoder) && counts == (s32)u32_clockSteps, "the deltas add up to the counter");
+
+	/* Edges during every read: the delta may be off by the edges of one read, the next one makes up for it */
+	u8_clockEdges = 10;
+	encoder_getDelta(ps_clockEncoder, &s_delta);
+	counts += s_delta.counts;
+	elapsed += s_delta.elapsed;
+	u8_clockEdges = 0;
+	encoder_getDelta(ps_clockEncoder, &s_delta);
+	counts += s_delta.counts;
+	elapsed += s_delta.elapsed;
+	check(counts == encoder_getCounter(ps_clockEncoder) && counts == (s32)elapsed, "no count is lost with edges during every clock read");
+
+	/* The reference taken by the reset is paired too */
+	u8_clockEdges = 1;
+	encoder_resetCounter(ps_clockEncoder);
+	encoder_getDelta(ps_clockEncoder, &s_delta);
+	check(s_delta.counts == 0 && s_delta.elapsed == 0, "the reset reference includes an edge during its clock read");
+	benchClockedSteps(3);
+	encoder_getDelta(ps_clockEncoder, &s_delta);
+	check(s_delta.counts == 3 && s_delta.elapsed == 3 && encoder_getCounter(ps_clockEncoder) == 4, "deltas after the reset");
+}
+
+s8 benchDirection()
+{
+	return s8_commandedDirection;
+}
+
+/* Runs the overflow interrupt if it is pending and enabled, the hardware clears the flag when entering it */
+void benchTimerInterrupt()
+{
+	if ((TIFR0 & (1 << TOV0)) && (TIMSK0 & (1 << TOIE0)))
+	{
+		TIFR0 &= ~(1 << TOV0);
+		TIMER0_OVF_vect();
+	}
+}
+
+/* Edges on T0, the overflow interrupt runs right away or stays pending */
+void benchTimerEdges(u16 u16_edges, bool b_interrupts)
+{
+	while (u16_edges--)
+	{
+		if (++TCNT0 == 0)
+			TIFR0 |= (1 << TOV0);
+		if (b_interrupts)
+			benchTimerInterrupt();
+	}
+}
+
+/* Runs updates with a changing number of edges between them, up to several overflows, and checks the counter follows in the commanded direction */
+void benchTimerRun(encoderCounter_struct_t* ps_counter, s32* ps32_expected, char const * pc_description)
+{
+	s32 previous = encoderCounter_getCounter(ps_counter);
+	bool b_exact = TRUE;
+	bool b_monotonic = TRUE;
+	u16 edges;
+	u8 i;
+
+	for (i = 0; i < 50; i++)
+	{
+		edges = (i * 37) % 700;
+		benchTimerEdges(edges, TRUE);
+		*ps32_expected += s8_commandedDirection < 0 ? -edges : edges;
+		encoderCounter_update(ps_counter);
+		b_exact = b_exact && encoderCounter_getCounter(ps_counter) == *ps32_expected;
+		b_monotonic = b_monotonic && (s8_commandedDirection < 0 ? encoderCounter_getCounter(ps_counter) <= previous : encoderCounter_getCounter(ps_counter) >= previous);
+		previous = encoderCounter_getCounter(ps_counter);
+	}
+	check(b_exact, pc_description);
+	check(b_monotonic, "the counter only moves in the commanded direction");
+}
+
+void benchTimerCounter()
+{
+	encoderCounter_struct_t s_counter;
+	s32 expected = 0;
+
+	TCCR0A = TCCR0B = TIFR0 = TIMSK0 = 0;
+	TCNT0 = 0xF0;
+	s8_commandedDirection = 1;
+	s_counter.peripheral = TIMER0;
+	s_counter.f_direction = benchDirection;
+	check(encoderCounter_init(&s_counter), "TIMER0 counts encoder edges");
+	check(TCCR0B == ((1 << CS02) | (1 << CS01) | (1 << CS00)) && (TIMSK0 & (1 << TOIE0)), "TIMER0 is clocked by T0 with its overflow interrupt");
+
+	/* The init cleared the stale flag by writing a one, which sets it here */
+	TIFR0 = 0;
+	encoderCounter_resetCounter(&s_counter);
+
+	benchTimerRun(&s_counter, &expected, "counting up across overflows");
+
+	/* The timer wraps but its interrupt is held off past the update */
+	while (TCNT0 != 0xFE)
+	{
+		benchTimerEdges(1, TRUE);
+		expected++;
+	}
+	benchTimerEdges(5, FALSE);
+	expected += 5;
+	encoderCounter_update(&s_counter);
+	check(encoderCounter_getCounter(&s_counter) == expected, "an update with the overflow pending counts the wrap");
+	benchTimerInterrupt();
+	encoderCounter_update(&s_counter);
+	check(encoderCounter_getCounter(&s_counter) == expected, "the delayed overflow interrupt doesn't count the wrap again");
+
+	s8_commandedDirection = -1;
+	benchTimerRun(&s_counter, &expected, "counting down across overflows");
+
+	/* No commanded direction keeps the last one */
+	s8_commandedDirection = 0;
+	benchTimerEdges(300, TRUE);
+	encoderCounter_update(&s_counter);
+	check(encoderCounter_getCounter(&s_counter) == expected - 300, "the direction is kept without a command");
+}
+
+/************************************************************************/
+/* Exported functions                                                   */
+/************************************************************************/
+
+int main()
+{
+	benchSteady(2000, 20);
+	benchSteady(50, 40);
+	benchSteady(-700, 20);
+	benchSteady(120000, 5);
+	benchLateCapture();
+	benchStop();
+	benchQuadrature();
+	benchRegistration();
+	benchDelta();
+	benchTimerCounter();
+
+	printf("%u failed checks\n", u8_failures);
+
+	return u8_failures;
+}
@@ -0,0 +1,195 @@
+/**	@file		gpio_sim.c
+	@brief		Host replacement of the HAL GPIO
+	@details	See @link gpio.h @endlink for details.
+*/
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include <avr/io.h>
+#include <stddef.h>
+
+#include "gpio.h"
+
+/************************************************************************/
+/* Defines, enums, structs, types                                       */
+/************************************************************************/
+
+#define GPIO_SIM_MAX_HANDLERS	8
+#define GPIO_SIM_MAX_INTERRUPTS	32
+
+typedef struct gpio_sim_attachment_struct_t
+{
+	gpio_struct_t s_gpio;
+	gpio_sim_handler_t f_handler;
+	void* p_context;
+}gpio_sim_attachment_struct_t;
+
+typedef struct gpio_sim_interrupt_struct_t
+{
+	gpio_struct_t s_gpio;
+	gpio_interrupt_enum_t e_interrupt;
+	void (*f_handler)(void);
+	bool b_enabled;
+}gpio_sim_interrupt_struct_t;
+
+/************************************************************************/
+/* Internal variables                                                   */
+/************************************************************************/
+
+gpio_sim_attachment_struct_t as_attachments[GPIO_SIM_MAX_HANDLERS];
+u8 u8_attachmentCount;
+
+gpio_sim_interrupt_struct_t as_interrupts[GPIO_SIM_MAX_INTERRUPTS];
+u8 u8_interruptCount;
+
+volatile u8 PINA, PINB, PINC, PIND;
+volatile u8 PORTA, PORTB, PORTC, PORTD;
+
+/************************************************************************/
+/* Internal functions                                                   */
+/************************************************************************/
+
+void notify(gpio_struct_t s_gpio, bool b_level)
+{
+	u8 i;
+
+	for (i = 0; i < u8_attachmentCount; i++)
+		if (as_attachments[i].s_gpio.port == s_gpio.port && as_attachments[i].s_gpio.number == s_gpio.number)
+			as_attachments[i].f_handler(as_attachments[i].p_context, b_level);
+}
+
+volatile u8* pinRegister(gpio_port_enum_t e_port)
+{
+	switch (e_port)
+	{
+		case PA:
+			return &PINA;
+		case PB:
+			return &PINB;
+		case PC:
+			return &PINC;
+		default:
+			return &PIND;
+	}
+}
+
+gpio_sim_interrupt_struct_t* findInterrupt(gpio_struct_t s_gpio)
+{
+	u8 i;
+
+	for (i = 0; i < u8_interruptCount; i++)
+		if (as_interrupts[i].s_gpio.port == s_gpio.port && as_interrupts[i].s_gpio.number == s_gpio.number)
+			return &as_interrupts[i];
+
+	return NULL;
+}
+
+void raise(gpio_struct_t s_gpio, bool b_level)
+{
+	gpio_sim_interrupt_struct_t* ps_interrupt = findInterrupt(s_gpio);
+
+	if (ps_interrupt == NULL || !ps_interrupt->b_enabled)
+		return;
+	if ((ps_interrupt->e_interrupt == INTERRUPT_RISING && !b_level) || (ps_interrupt->e_interrupt == INTERRUPT_FALLING && b_level))
+		return;
+
+	ps_interrupt->f_handler();
+}
+
+/************************************************************************/
+/* Exported functions                                                   */
+/************************************************************************/
+
+void gpio_init(gpio_struct_t s_gpio)
+{
+}
+
+void gpio_setDirectionOutput(gpio_struct_t* ps_gpio)
+{
+	ps_gpio->direction = OUTPUT;
+}
+
+void gpio_out_set(gpio_struct_t s_gpio)
+{
+	notify(s_gpio, TRUE);
+}
+
+void gpio_out_reset(gpio_struct_t s_gpio)
+{
+	notify(s_gpio, FALSE);
+}
+
+void gpio_attachInterrupt(gpio_struct_t s_gpio, gpio_interrupt_enum_t e_interrupt, void (*f_handler)(void))
+{
+	gpio_sim_interrupt_struct_t* ps_interrupt = findInterrupt(s_gpio);
+
+	/* Attaching again replaces the handler, as the pin has a single interrupt vector entry */
+	if (ps_interrupt == NULL)
+	{
+		if (u8_interruptCount == GPIO_SIM_MAX_INTERRUPTS)
+			return;
+		ps_interrupt = &as_interrupts[u8_interruptCount++];
+		ps_interrupt->b_enabled = FALSE;
+	}
+
+	ps_interrupt->s_gpio = s_gpio;
+	ps_interrupt->e_interrupt = e_interrupt;
+	ps_interrupt->f_handler = f_handler;
+}
+
+void gpio_enableInterrupt(gpio_struct_t s_gpio, gpio_interrupt_enum_t e_interrupt)
+{
+	gpio_sim_interrupt_struct_t* ps_interrupt = findInterrupt(s_gpio);
+
+	if (ps_interrupt != NULL)
+		ps_interrupt->b_enabled = TRUE;
+}
+
+void gpio_disableInterrupt(gpio_struct_t s_gpio, gpio_interrupt_enum_t e_interrupt)
+{
+	gpio_sim_interrupt_struct_t* ps_interrupt = findInterrupt(s_gpio);
+
+	if (ps_interrupt != NULL)
+		ps_interrupt->b_enabled = FALSE;
+}
+
+bool gpio_sim_attach(gpio_struct_t s_gpio, gpio_sim_handler_t f_handler, void* p_context)
+{
+	if (u8_attachmentCount == GPIO_SIM_MAX_HANDLERS)
+		return FALSE;
+
+	as_attachments[u8_attachmentCount].s_gpio = s_gpio;
+	as_attachments[u8_attachmentCount].f_handler = f_handler;
+	as_attachments[u8_attachmentCount].p_context = p_context;
+	u8_attachmentCount++;
+
+	return TRUE;
+}
+
+void gpio_sim_setInputs(gpio_port_enum_t e_port, u8 u8_mask, u8 u8_levels)
+{
+	volatile u8* pu8_pin = pinRegister(e_port);
+	u8 changed = (*pu8_pin ^ u8_levels) & u8_mask;
+	gpio_struct_t s_gpio = {e_port, 0, INPUT};
+
+	*pu8_pin = (*pu8_pin & ~u8_mask) | (u8_levels & u8_mask);
+
+	for (s_gpio.number = 0; s_gpio.number < 8; s_gpio.number++)
+		if (changed & (1 << s_gpio.number))
+			raise(s_gpio, (*pu8_pin >> s_gpio.number) & 1);
+}
+
+void gpio_sim_setInput(gpio_struct_t s_gpio, bool b_level)
+{
+	gpio_sim_setInputs(s_gpio.port, 1 << s_gpio.number, b_level ? 0xFF : 0x00);
+}
+
+void gpio_sim_reset()
+{
+	u8_attachmentCount = 0;
+	u8_interruptCount = 0;
+	PINA = PINB = PINC = PIND = 0;
+	PORTA = PORTB = PORTC = PORTD = 0;
+}
@@ -0,0 +1,181 @@
+/**	@file		i2c_sim.c
+	@brief		Simulated I2C bus
+	@details	See @link i2c_sim.h @endlink for details.
+*/
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include <stddef.h>
+#include <avr/io.h>
+#include <util/twi.h>
+
+#include "i2c_sim.h"
+#include "simulation.h"
+
+/************************************************************************/
+/* Internal variables                                                   */
+/************************************************************************/
+
+i2c_sim_device_struct_t* aps_devices[I2C_SIM_MAX_DEVICES];
+u8 u8_deviceCount;
+i2c_sim_device_struct_t* ps_selected;
+i2c_sim_statistics_struct_t s_statistics;
+u32 u32_frequency = 100000;
+
+volatile u8 TWSR;
+
+/************************************************************************/
+/* Internal functions                                                   */
+/************************************************************************/
+
+void busyFor(u8 u8_bits)
+{
+	u64 duration = ((u64)u8_bits * 1000000000ULL) / u32_frequency;
+
+	s_statistics.busTime += duration;
+	simulation_advance(duration);
+}
+
+u8 addressDevice(u8 u8_address)
+{
+	u8 i;
+
+	busyFor(1 + 9);
+	s_statistics.bytes++;
+	ps_selected = NULL;
+
+	for (i = 0; i < u8_deviceCount; i++)
+	{
+		if (!aps_devices[i]->start(aps_devices[i]->p_context, u8_address >> 1, u8_address & I2C_READ))
+			continue;
+
+		if (ps_selected == NULL)
+			ps_selected = aps_devices[i];
+		else
+			s_statistics.collisions++;
+	}
+
+	if (ps_selected == NULL)
+	{
+		s_statistics.nacks++;
+		TWSR = (u8_address & I2C_READ) ? TW_MR_SLA_NACK : TW_MT_SLA_NACK;
+	}
+	else
+		TWSR = (u8_address & I2C_READ) ? TW_MR_SLA_ACK : TW_MT_SLA_ACK;
+
+	return TW_STATUS;
+}
+
+u8 readByte(bool b_ack)
+{
+	TWSR = b_ack ? TW_MR_DATA_ACK : TW_MR_DATA_NACK;
+	busyFor(9);
+	s_statistics.bytes++;
+
+	/* Nobody drives the bus, the pull-ups read as ones */
+	if (ps_selected == NULL)
+		return 0xFF;
+
+	return ps_selected->read(ps_selected->p_context);
+}
+
+/************************************************************************/
+/* Exported functions                                                   */
+/************************************************************************/
+
+void i2c_init(i2c_struct_t s_i2c)
+{
+	if (s_i2c.frequency != 0)
+		u32_frequency = s_i2c.frequency;
+}
+
+void i2c_start()
+{
+}
+
+void i2c_stop()
+{
+}
+
+u8 i2c_sendStart(u8 u8_address)
+{
+	s_statistics.transactions++;
+	return addressDevice(u8_address);
+}
+
+u8 i2c_sendRepStart(u8 u8_address)
+{
+	return addressDevice(u8_address);
+}
+
+void i2c_sendStop()
+{
+	u8 i;
+
+	busyFor(1);
+
+	for (i = 0; i < u8_deviceCount; i++)
+		aps_devices[i]->stop(aps_devices[i]->p_context);
+
+	ps_selected = NULL;
+	TWSR = TW_NO_INFO;
+}
+
+u8 i2c_write(u8 u8_data)
+{
+	busyFor(9);
+	s_statistics.bytes++;
+
+	if (ps_selected == NULL || !ps_selected->write(ps_selected->p_context, u8_data))
+	{
+		s_statistics.nacks++;
+		TWSR = TW_MT_DATA_NACK;
+	}
+	else
+		TWSR = TW_MT_DATA_ACK;
+
+	return TW_STATUS;
+}
+
+u8 i2c_readAck()
+{
+	return readByte(TRUE);
+}
+
+u8 i2c_readNak()
+{
+	return readByte(FALSE);
+}
+
+bool i2c_sim_attach(i2c_sim_device_struct_t* ps_device)
+{
+	if (u8_deviceCount == I2C_SIM_MAX_DEVICES)
+		return FALSE;
+
+	aps_devices[u8_deviceCount++] = ps_device;
+
+	return TRUE;
+}
+
+void i2c_sim_reset()
+{
+	u8_deviceCount = 0;
+	ps_selected = NULL;
+	i2c_sim_resetStatistics();
+}
+
+void i2c_sim_resetStatistics()
+{
+	s_statistics.transactions = 0;
+	s_statistics.bytes = 0;
+	s_statistics.nacks = 0;
+	s_statistics.collisions = 0;
+	s_statistics.busTime = 0;
+}
+
+i2c_sim_statistics_struct_t i2c_sim_getStatistics()
+{
+	return s_statistics;
+}
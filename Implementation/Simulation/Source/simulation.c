@@ -0,0 +1,66 @@
+/**	@file		simulation.c
+	@brief		Simulated clock for running the drivers on the host
+	@details	See @link simulation.h @endlink for details.
+*/
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include <stddef.h>
+#include <util/delay.h>
+
+#include "gpio.h"
+#include "i2c_sim.h"
+#include "simulation.h"
+
+/************************************************************************/
+/* Internal variables                                                   */
+/************************************************************************/
+
+u64 u64_time;
+void (*f_tickHandler)(void);
+
+/************************************************************************/
+/* Exported functions                                                   */
+/************************************************************************/
+
+void simulation_reset()
+{
+	u64_time = 0;
+	f_tickHandler = NULL;
+	i2c_sim_reset();
+	gpio_sim_reset();
+}
+
+void simulation_setTickHandler(void (*f_tick)(void))
+{
+	f_tickHandler = f_tick;
+}
+
+void simulation_advance(u64 u64_nanoseconds)
+{
+	u64 previousMilliseconds = u64_time / 1000000;
+
+	u64_time += u64_nanoseconds;
+
+	/* Deliver every timer interrupt which would have happened meanwhile */
+	if (f_tickHandler != NULL)
+		for (; previousMilliseconds < u64_time / 1000000; previousMilliseconds++)
+			f_tickHandler();
+}
+
+u64 simulation_getTime()
+{
+	return u64_time;
+}
+
+void _delay_ms(double d_ms)
+{
+	simulation_advance((u64)(d_ms * 1000000.0));
+}
+
+void _delay_us(double d_us)
+{
+	simulation_advance((u64)(d_us * 1000.0));
+}
@@ -0,0 +1,22 @@
+/**	@file		timer_sim.c
+	@brief		Host replacement of the timer registers
+	@details	See @link timer.h @endlink for details.
+*/
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include <avr/io.h>
+
+#include "timer.h"
+
+/************************************************************************/
+/* Internal variables                                                   */
+/************************************************************************/
+
+volatile u8 TCCR0A, TCCR0B, TCNT0, TIFR0, TIMSK0;
+volatile u8 TCCR1A, TCCR1B, TIFR1, TIMSK1;
+volatile u16 TCNT1;
+volatile u8 TCCR3A, TCCR3B, TIFR3, TIMSK3;
+volatile u16 TCNT3;
@@ -0,0 +1,1039 @@
+/**	@file		vl53l0x_bench.c
+	@brief		Bus usage benchmark and fault scenarios for the VL53L0X driver
+	@details	Runs the unchanged driver sources against simulated sensors and prints the I2C transactions, bytes and bus time of each operation.
+				The fault scenarios check that the driver recovers from sensors which stop answering or never finish a measurement.
+				Build and run from the Implementation directory:
+				gcc -std=gnu99 -Wall -DVL53L0X_STATISTICS -ISimulation/Include -IInclude -IExample/Config Simulation/Source/simulation.c Simulation/Source/i2c_sim.c Simulation/Source/gpio_sim.c Simulation/Source/debug_sim.c Simulation/Source/vl53l0x_sim.c Simulation/Source/vl53l0x_bench.c Source/i2cBus.c Source/regmap.c Source/vl53l0x.c Source/vl53l0x_array.c Source/vl53l0x_filter.c Source/vl53l0x_adaptive.c Source/vl53l0x_history.c -o vl53l0x_bench && ./vl53l0x_bench
+				Without -DVL53L0X_STATISTICS the driver counters aren't printed nor checked against the bus. With -DI2CBUS_TRACE the bus trace is checked and dumped, pipe the output to Tools/i2c_trace.py to decode it.
+				The exit code is the number of failed checks.
+*/
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include <stdio.h>
+
+#include "i2cBus.h"
+#include "regmap.h"
+#include "i2c_sim.h"
+#include "simulation.h"
+#include "vl53l0x.h"
+#include "vl53l0x_adaptive.h"
+#include "vl53l0x_array.h"
+#include "vl53l0x_filter.h"
+#include "vl53l0x_history.h"
+#include "vl53l0x_sim.h"
+
+/************************************************************************/
+/* Defines, enums, structs, types                                       */
+/************************************************************************/
+
+#define BENCH_SAMPLES	100
+#define BENCH_APPROACH	120
+
+/************************************************************************/
+/* Internal variables                                                   */
+/************************************************************************/
+
+u8 u8_failures;
+
+vl53l0x_sim_sample_struct_t const as_rampScript[] =
+{
+	{ 120, VL53L0X_SIM_RANGE_VALID, 0x1400 },
+	{ 240, VL53L0X_SIM_RANGE_VALID, 0x0A00 },
+	{ 480, VL53L0X_SIM_RANGE_VALID, 0x0500 },
+	{ 960, VL53L0X_SIM_RANGE_VALID, 0x0280 }
+};
+
+vl53l0x_sim_sample_struct_t const as_obstacleScript[] =
+{
+	{ 300, VL53L0X_SIM_RANGE_VALID, 0x0A00 },
+	{ 300, VL53L0X_SIM_RANGE_VALID, 0x0A00 },
+	{  80, VL53L0X_SIM_RANGE_VALID, 0x2800 },
+	{ 300, VL53L0X_SIM_RANGE_VALID, 0x0A00 }
+};
+
+/* A wall at 500mm with a failed measurement, a phase wrap-around spike and a weak return */
+vl53l0x_sim_sample_struct_t const as_noisyScript[] =
+{
+	{  500, VL53L0X_SIM_RANGE_VALID, 0x0A00 },
+	{  504, VL53L0X_SIM_RANGE_VALID, 0x0A00 },
+	{ 8190, 4,                       0x0010 },
+	{  496, VL53L0X_SIM_RANGE_VALID, 0x0A00 },
+	{ 1650, VL53L0X_SIM_RANGE_VALID, 0x0A00 },
+	{  502, VL53L0X_SIM_RANGE_VALID, 0x0A00 },
+	{   20, VL53L0X_SIM_RANGE_VALID, 0x0008 },
+	{  498, VL53L0X_SIM_RANGE_VALID, 0x0A00 }
+};
+
+vl53l0x_sim_sample_struct_t as_approachScript[BENCH_APPROACH];
+
+/* Calibration targets: white at 100mm, grey at 600mm */
+vl53l0x_sim_sample_struct_t const as_nearTargetScript[] =
+{
+	{ 100, VL53L0X_SIM_RANGE_VALID, 0x0A00 },
+};
+
+vl53l0x_sim_sample_struct_t const as_farTargetScript[] =
+{
+	{ 600, VL53L0X_SIM_RANGE_VALID, 0x0080 },
+};
+
+/************************************************************************/
+/* Internal functions                                                   */
+/************************************************************************/
+
+void check(bool b_condition, char const * pc_description)
+{
+	if (!b_condition)
+	{
+		printf("FAILED: %s\n", pc_description);
+		u8_failures++;
+	}
+}
+
+void printUsage(char const * pc_operation, u32 u32_count)
+{
+	i2c_sim_statistics_struct_t s_statistics = i2c_sim_getStatistics();
+
+	if (u32_count == 0)
+		u32_count = 1;
+
+	printf("%-34s %10.1f %10.1f %12.1f\n", pc_operation,
+		(double)s_statistics.transactions / u32_count,
+		(double)s_statistics.bytes / u32_count,
+		(double)s_statistics.busTime / 1000.0 / u32_count);
+}
+
+void setupSensor(vl53l0x_struct_t* ps_sensor, vl53l0x_sim_struct_t* ps_sim, u8 u8_pin)
+{
+	ps_sim->xshutPin.port = PC;
+	ps_sim->xshutPin.number = u8_pin;
+	ps_sim->measurementTime = 0;
+	ps_sim->ps_script = as_rampScript;
+	ps_sim->scriptLength = sizeof(as_rampScript) / sizeof(as_rampScript[0]);
+	ps_sim->nackCount = 0;
+	ps_sim->nackDelay = 0;
+	ps_sim->stuckBusy = FALSE;
+	ps_sim->partOffset = 0;
+	ps_sim->crosstalkRate = 0;
+	vl53l0x_sim_init(ps_sim);
+
+	ps_sensor->address = VL53L0X_ADDRESS_DEFAULT;
+	ps_sensor->xshutPin = ps_sim->xshutPin;
+	vl53l0x_init(ps_sensor);
+	ps_sensor->i2cTimeout = 100;
+}
+
+void resetSimulation()
+{
+	simulation_reset();
+	simulation_setTickHandler(vl53l0x_incrementTimeoutCounter);
+}
+
+/* Ten cached registers for a cache of eight */
+regmap_register_struct_t const as_oversizedRegisters[] =
+{
+	{ 0, 0xD0, 1, REGMAP_CACHED }, { 0, 0xD1, 1, REGMAP_CACHED }, { 0, 0xD2, 1, REGMAP_CACHED }, { 0, 0xD3, 1, REGMAP_CACHED }, { 0, 0xD4, 1, REGMAP_CACHED },
+	{ 0, 0xD5, 1, REGMAP_CACHED }, { 0, 0xD6, 1, REGMAP_CACHED }, { 0, 0xD7, 1, REGMAP_CACHED }, { 0, 0xD8, 1, REGMAP_CACHED }, { 0, 0xD9, 1, REGMAP_CACHED }
+};
+
+regmap_map_struct_t const s_oversizedMap = { as_oversizedRegisters, sizeof(as_oversizedRegisters) / sizeof(as_oversizedRegisters[0]), FALSE, 0 };
+
+regmap_struct_t s_oversized;
+
+u8 au8_callbackOrder[4];
+u8 u8_callbacks;
+
+void busCallback(i2cBus_transaction_struct_t* ps_transaction)
+{
+	au8_callbackOrder[u8_callbacks++] = *(u8*)ps_transaction->p_context;
+}
+
+void benchBus()
+{
+	vl53l0x_struct_t s_sensor;
+	vl53l0x_sim_struct_t s_sim;
+	i2cBus_transaction_struct_t as_transactions[3];
+	u8 au8_ids[3] = { 0, 1, 2 };
+	i2cBus_transaction_struct_t s_chain;
+	u8 modelIdRegister = 0xC0;
+	u8 revisionIdRegister = 0xC2;
+	u8 au8_values[3] = { 0, 0, 0 };
+	u8 au8_ids2[2] = { 0, 0 };
+	i2cBus_speed_struct_t s_speed;
+	u64 fastTime, slowTime;
+	u8 i;
+
+	resetSimulation();
+	setupSensor(&s_sensor, &s_sim, 0);
+	check(vl53l0x_start(&s_sensor), "sensor starts");
+
+	/* Two reads of the model ID and one to an address nobody answers */
+	for (i = 0; i < 3; i++)
+	{
+		i2cBus_begin(&as_transactions[i], (i == 1) ? 0x30 : VL53L0X_ADDRESS_DEFAULT, NULL);
+		i2cBus_addWrite(&as_transactions[i], &modelIdRegister, 1);
+		i2cBus_addRead(&as_transactions[i], &au8_values[i], 1);
+		as_transactions[i].f_callback = busCallback;
+		as_transactions[i].p_context = &au8_ids[i];
+	}
+
+	u8_callbacks = 0;
+	for (i = 0; i < 3; i++)
+		i2cBus_submit(&as_transactions[i]);
+
+	check(!i2cBus_isBusy() && u8_callbacks == 3, "queue runs to completion");
+	check(au8_callbackOrder[0] == 0 && au8_callbackOrder[1] == 1 && au8_callbackOrder[2] == 2, "transactions complete in submission order");
+	check(as_transactions[0].e_status == I2CBUS_DONE && au8_values[0] == 0xEE && au8_values[2] == 0xEE, "reads return the model ID");
+	check(as_transactions[1].e_status == I2CBUS_NACK, "missing device is reported as NACK");
+
+	/* Both identification registers in a single frame */
+	i2cBus_begin(&s_chain, VL53L0X_ADDRESS_DEFAULT, NULL);
+	i2cBus_addWrite(&s_chain, &modelIdRegister, 1);
+	i2cBus_addRead(&s_chain, &au8_ids2[0], 1);
+	i2cBus_addWrite(&s_chain, &revisionIdRegister, 1);
+	i2cBus_addRead(&s_chain, &au8_ids2[1], 1);
+	i2c_sim_resetStatistics();
+	check(i2cBus_transfer(&s_chain) == I2CBUS_DONE && au8_ids2[0] == 0xEE && au8_ids2[1] == 0x10, "chained frame reads both registers");
+	check(i2c_sim_getStatistics().transactions == 1 && i2c_sim_getStatistics().bytes == i2cBus_getFrameBytes(&s_chain), "chained frame uses one start and repeated starts");
+
+	/* The sensor has a fast mode profile, transactions without one run at the standard mode default */
+	i2cBus_begin(&s_chain, VL53L0X_ADDRESS_DEFAULT, &s_sensor.s_regmap.s_busSpeed);
+	i2cBus_addWrite(&s_chain, NULL, 0);
+	i2c_sim_resetStatistics();
+	i2cBus_transfer(&s_chain);
+	fastTime = i2c_sim_getStatistics().busTime;
+	i2cBus_begin(&s_chain, VL53L0X_ADDRESS_DEFAULT, NULL);
+	i2cBus_addWrite(&s_chain, NULL, 0);
+	i2c_sim_resetStatistics();
+	i2cBus_transfer(&s_chain);
+	slowTime = i2c_sim_getStatistics().busTime;
+	printf("  address probe: %.1f us at the sensor rate, %.1f us at the default rate\n", fastTime / 1000.0, slowTime / 1000.0);
+	check(s_sensor.s_regmap.s_busSpeed.frequency == 400000 && slowTime == 4 * fastTime, "sensor runs in fast mode next to standard mode transactions");
+
+	/* A device which keeps failing steps down to standard mode */
+	i2cBus_initSpeed(&s_speed, 400000);
+	for (i = 0; i < 3 * I2CBUS_FALLBACK_FAILURES; i++)
+	{
+		i2cBus_begin(&s_chain, 0x30, &s_speed);
+		i2cBus_addWrite(&s_chain, NULL, 0);
+		i2cBus_transfer(&s_chain);
+		if (i == I2CBUS_FALLBACK_FAILURES - 1)
+			check(s_speed.frequency == 200000, "device falls back after repeated NACKs");
+	}
+	check(s_speed.frequency == I2CBUS_MIN_FREQUENCY, "fallback stops at standard mode");
+	i2cBus_initSpeed(&s_speed, s_speed.maxFrequency);
+	check(s_speed.frequency == 400000, "speed profile can be restored");
+
+	/* A map flagging more registers as cached than the cache holds is reported and its extra registers stay volatile */
+	check(!regmap_init(&s_oversized, &s_oversizedMap, VL53L0X_ADDRESS_DEFAULT, 400000), "oversized map is reported");
+	for (i = 0; i < 2 * sizeof(as_oversizedRegisters) / sizeof(as_oversizedRegisters[0]); i++)
+		regmap_write(&s_oversized, as_oversizedRegisters[i % (sizeof(as_oversizedRegisters) / sizeof(as_oversizedRegisters[0]))].address, 0x11);
+	check(s_oversized.transactions == 12 && s_oversized.cacheValid == 0xFF, "only the first REGMAP_CACHE_SIZE registers are cached");
+
+	vl53l0x_stop(&s_sensor);
+}
+
+#ifdef I2CBUS_TRACE
+u32 benchClock()
+{
+	return simulation_getTime() / 1000;
+}
+
+void benchTrace()
+{
+	vl53l0x_struct_t s_sensor;
+	vl53l0x_sim_struct_t s_sim;
+	i2cBus_traceRecord_struct_t s_record;
+	u32 records = 0, bytes = 0, busTime = 0, lastEnd = 0;
+	bool b_ordered = TRUE;
+	u8 i;
+
+	resetSimulation();
+	setupSensor(&s_sensor, &s_sim, 0);
+	check(vl53l0x_start(&s_sensor), "sensor starts");
+
+	i2cBus_setTraceClock(benchClock);
+	while (i2cBus_popTrace(&s_record));
+
+	i2c_sim_resetStatistics();
+	check(vl53l0x_setMode(&s_sensor, VL53L0X_MAX_RANGE), "long range mode applies");
+
+	while (i2cBus_popTrace(&s_record))
+	{
+		if (s_record.start < lastEnd || s_record.end < s_record.start)
+			b_ordered = FALSE;
+		lastEnd = s_record.end;
+		records++;
+		bytes += s_record.bytes;
+		busTime += s_record.end - s_record.start;
+	}
+	printf("  trace: %u records, %u bytes, %u us on the bus\n", records, bytes, busTime);
+	check(records == i2c_sim_getStatistics().transactions && bytes == i2c_sim_getStatistics().bytes, "trace records every transaction");
+	check(b_ordered, "trace timestamps are ordered");
+
+	/* More transactions than the trace holds, for Tools/i2c_trace.py */
+	for (i = 0; i < 3; i++)
+		vl53l0x_readRangeSingle(&s_sensor);
+	i2cBus_dumpTrace();
+
+	i2cBus_setTraceClock(NULL);
+	vl53l0x_stop(&s_sensor);
+}
+#endif
+
+void benchSingleSensor()
+{
+	vl53l0x_struct_t s_sensor;
+	vl53l0x_sim_struct_t s_sim;
+	u16 range, i;
+	u32 samples;
+	u64 start;
+#ifdef VL53L0X_STATISTICS
+	u32 transactions, bytes;
+#endif
+
+	resetSimulation();
+	setupSensor(&s_sensor, &s_sim, 0);
+
+	check(vl53l0x_start(&s_sensor), "sensor starts");
+	printUsage("vl53l0x_start", 1);
+
+	i2c_sim_resetStatistics();
+	check(vl53l0x_setMode(&s_sensor, VL53L0X_DEFAULT), "default mode applies");
+	printUsage("vl53l0x_setMode (same periods)", 1);
+
+	i2c_sim_resetStatistics();
+#ifdef VL53L0X_STATISTICS
+	transactions = vl53l0x_getStatistics(&s_sensor)->transactions;
+	bytes = vl53l0x_getStatistics(&s_sensor)->bytes;
+	samples = vl53l0x_getStatistics(&s_sensor)->samples;
+#endif
+	for (i = 0; i < BENCH_SAMPLES; i++)
+	{
+		range = vl53l0x_readRangeSingle(&s_sensor);
+		check(range == as_rampScript[i % 4].range, "single shot returns the scripted range");
+	}
+	printUsage("single shot measurement", BENCH_SAMPLES);
+#ifdef VL53L0X_STATISTICS
+	check(vl53l0x_getStatistics(&s_sensor)->transactions - transactions == i2c_sim_getStatistics().transactions, "driver counts every transaction");
+	check(vl53l0x_getStatistics(&s_sensor)->bytes - bytes == i2c_sim_getStatistics().bytes, "driver counts every byte");
+	check(vl53l0x_getStatistics(&s_sensor)->samples - samples == BENCH_SAMPLES, "driver counts every sample");
+#endif
+
+	i2c_sim_resetStatistics();
+	samples = 0;
+	vl53l0x_startContinuous(&s_sensor, 0);
+	while (samples < BENCH_SAMPLES)
+		if (vl53l0x_readRangeContinuous(&s_sensor) != 0xFFFF)
+			samples++;
+	vl53l0x_stopContinuous(&s_sensor);
+	printUsage("continuous sample, busy polling", BENCH_SAMPLES);
+
+	i2c_sim_resetStatistics();
+	check(vl53l0x_setMode(&s_sensor, VL53L0X_MAX_RANGE), "long range mode applies");
+	printUsage("vl53l0x_setMode (period change)", 1);
+
+	start = simulation_getTime();
+	vl53l0x_readRangeSingle(&s_sensor);
+	printf("  long range measurement time: %.1f ms\n", (double)(simulation_getTime() - start) / 1000000.0);
+
+	check(vl53l0x_setMode(&s_sensor, VL53L0X_MAX_SPEED), "high speed mode applies");
+	start = simulation_getTime();
+	vl53l0x_readRangeSingle(&s_sensor);
+	printf("  high speed measurement time: %.1f ms\n", (double)(simulation_getTime() - start) / 1000000.0);
+
+	check(!s_sensor.timedOut, "no timeout in normal operation");
+
+#ifdef VL53L0X_STATISTICS
+	vl53l0x_printStatistics(&s_sensor);
+#endif
+}
+
+u16 benchRegister16(vl53l0x_sim_struct_t* ps_sim, u8 u8_register)
+{
+	return ((u16)ps_sim->au8_registers[0][u8_register] << 8) | ps_sim->au8_registers[0][u8_register + 1];
+}
+
+void benchVcselPeriod()
+{
+	vl53l0x_struct_t s_sensor;
+	vl53l0x_sim_struct_t s_sim;
+	u8 au8_tableRegisters[2][256];
+	u64 start, tableTime, computedTime;
+	bool b_same = TRUE;
+	u16 i;
+
+	/* Reference: the precomputed long range settings */
+	resetSimulation();
+	setupSensor(&s_sensor, &s_sim, 0);
+	check(vl53l0x_start(&s_sensor), "sensor starts");
+	check(vl53l0x_setMode(&s_sensor, VL53L0X_MAX_RANGE), "long range mode applies");
+	for (i = 0; i < 256; i++)
+	{
+		au8_tableRegisters[0][i] = s_sim.au8_registers[0][i];
+		au8_tableRegisters[1][i] = s_sim.au8_registers[1][i];
+	}
+	start = simulation_getTime();
+	vl53l0x_readRangeSingle(&s_sensor);
+	tableTime = simulation_getTime() - start;
+	vl53l0x_stop(&s_sensor);
+
+	/* The same periods computed from the default mode */
+	resetSimulation();
+	setupSensor(&s_sensor, &s_sim, 0);
+	check(vl53l0x_start(&s_sensor), "sensor starts");
+	check(vl53l0x_setVcselPulsePeriod(&s_sensor, VL53L0X_VCSEL_PRE_RANGE, 18), "pre-range period 18 applies");
+	check(vl53l0x_setVcselPulsePeriod(&s_sensor, VL53L0X_VCSEL_FINAL_RANGE, 14), "final range period 14 applies");
+	check(vl53l0x_setTimingBudget(&s_sensor, 33000), "long range budget applies");
+
+	check(s_sim.au8_registers[0][0x50] == (18 >> 1) - 1 && s_sim.au8_registers[0][0x70] == (14 >> 1) - 1, "period registers hold the new periods");
+	check(s_sim.au8_registers[0][0x57] == 0x50 && s_sim.au8_registers[0][0x56] == 0x08, "pre-range phase limits for 18 PCLKs");
+	check(s_sim.au8_registers[0][0x48] == 0x48 && s_sim.au8_registers[0][0x47] == 0x08, "final range phase limits for 14 PCLKs");
+	check(s_sim.au8_registers[0][0x32] == 0x03 && s_sim.au8_registers[0][0x30] == 0x07 && s_sim.au8_registers[1][0x30] == 0x20, "VCSEL width and phase calibration limits for 14 PCLKs");
+	check(s_sim.au8_registers[0][0x46] == 0x1D, "MSRC timeout matches the long range mode");
+	check(benchRegister16(&s_sim, 0x51) == 0x0075, "pre-range timeout matches the long range mode");
+	check(benchRegister16(&s_sim, 0x71) == 0x01CE, "final range timeout matches the long range mode");
+	check(s_sim.au8_registers[0][0x01] == 0xE8, "sequence steps are restored after the phase calibration");
+
+	/* The timing registers, apart from the signal rate limit the mode also sets */
+	for (i = 0x30; i < 0x80; i++)
+		if (s_sim.au8_registers[0][i] != au8_tableRegisters[0][i] && i != 0x44 && i != 0x45)
+			b_same = FALSE;
+	if (s_sim.au8_registers[1][0x30] != au8_tableRegisters[1][0x30])
+		b_same = FALSE;
+	check(b_same, "computed settings equal the precomputed long range table");
+
+	start = simulation_getTime();
+	vl53l0x_readRangeSingle(&s_sensor);
+	computedTime = simulation_getTime() - start;
+	printf("  computed long range measurement time: %.1f ms, table %.1f ms (budget %.1f ms)\n", computedTime / 1000000.0, tableTime / 1000000.0, s_sensor.timingBudget / 1000.0);
+	check(computedTime == tableTime, "computed settings measure as long as the table ones");
+	check(computedTime > (u64)s_sensor.timingBudget * 900 && computedTime < (u64)s_sensor.timingBudget * 1100, "measurement time matches the budget");
+
+	/* Steps disabled by the caller stay disabled */
+	regmap_write(&s_sensor.s_regmap, 0x01, 0xC8);
+	check(vl53l0x_setVcselPulsePeriod(&s_sensor, VL53L0X_VCSEL_FINAL_RANGE, 10), "final range period 10 applies");
+	check(s_sim.au8_registers[0][0x01] == 0xC8, "period change keeps the caller's sequence steps");
+
+	vl53l0x_stop(&s_sensor);
+}
+
+u16 u16_asyncRange;
+u8 u8_asyncCalls;
+
+void asyncRangeCallback(vl53l0x_struct_t* ps_sensor, u16 u16_range)
+{
+	u16_asyncRange = u16_range;
+	u8_asyncCalls++;
+}
+
+void benchAsync()
+{
+	vl53l0x_struct_t s_sensor;
+	vl53l0x_sim_struct_t s_sim;
+	u32 samples = 0, polls = 0;
+	bool b_ranges = TRUE;
+	u8 value;
+	/* Page 1 access framing of the stop variable load, without the write itself */
+	u8 const au8_pageOneSequence[][2] =
+	{
+		{ 0x80, 0x01 },
+		{ 0xFF, 0x01 },
+		{ 0x00, 0x00 },
+		{ 0x00, 0x01 },
+		{ 0xFF, 0x00 },
+		{ 0x80, 0x00 }
+	};
+#ifdef VL53L0X_STATISTICS
+	u32 transactions;
+#endif
+
+	resetSimulation();
+	setupSensor(&s_sensor, &s_sim, 0);
+	check(vl53l0x_start(&s_sensor), "sensor starts");
+	vl53l0x_startContinuous(&s_sensor, 0);
+
+	i2c_sim_resetStatistics();
+#ifdef VL53L0X_STATISTICS
+	transactions = vl53l0x_getStatistics(&s_sensor)->transactions;
+#endif
+	while (samples < BENCH_SAMPLES)
+	{
+		u8_asyncCalls = 0;
+		check(vl53l0x_requestRange(&s_sensor, asyncRangeCallback), "request is accepted");
+		/* With the interrupt mode engine the main loop would run here */
+		while (vl53l0x_isRequestPending(&s_sensor));
+		check(u8_asyncCalls == 1, "callback runs once per request");
+		polls++;
+
+		if (u16_asyncRange != 0xFFFF)
+		{
+			if (u16_asyncRange != as_rampScript[samples % 4].range)
+				b_ranges = FALSE;
+			samples++;
+		}
+	}
+	printUsage("requested sample, callback", BENCH_SAMPLES);
+
+	check(b_ranges, "requests deliver every scripted range in order");
+	check(i2c_sim_getStatistics().transactions == polls + samples, "one frame per poll and one interrupt clear per sample");
+#ifdef VL53L0X_STATISTICS
+	check(vl53l0x_getStatistics(&s_sensor)->transactions - transactions == polls + samples, "driver counts the requested frames");
+#endif
+
+	/* A blocking page 1 sequence fails after the sensor went to page 1, the request must select page 0 again instead of clearing register 0x0B of page 1 */
+	s_sim.au8_registers[1][0x0B] = 0x5A;
+	s_sim.nackDelay = 2;
+	s_sim.nackCount = 1;
+	regmap_writeSequence(&s_sensor.s_regmap, au8_pageOneSequence, sizeof(au8_pageOneSequence) / sizeof(au8_pageOneSequence[0]));
+	check(s_sim.page == 1, "failed sequence leaves the sensor on page 1");
+	u16_asyncRange = 0xFFFF;
+	for (polls = 0; polls < 1000 && u16_asyncRange == 0xFFFF; polls++)
+	{
+		vl53l0x_requestRange(&s_sensor, asyncRangeCallback);
+		while (vl53l0x_isRequestPending(&s_sensor));
+	}
+	check(u16_asyncRange != 0xFFFF, "request delivers a range after a failed page 1 sequence");
+	check(s_sim.page == 0 && s_sim.au8_registers[1][0x0B] == 0x5A, "request selects page 0 before its first access");
+
+	/* A failed request forgets the cache like a failed blocking transfer */
+	regmap_read(&s_sensor.s_regmap, 0x84);
+	s_sim.nackCount = 1;
+	vl53l0x_requestRange(&s_sensor, asyncRangeCallback);
+	while (vl53l0x_isRequestPending(&s_sensor));
+	check(u16_asyncRange == 0xFFFF && !regmap_getCached(&s_sensor.s_regmap, 0, 0x84, &value), "failed request forgets the cached registers");
+
+	vl53l0x_stopContinuous(&s_sensor);
+
+	vl53l0x_stop(&s_sensor);
+}
+
+void benchThreshold()
+{
+	vl53l0x_struct_t s_sensor;
+	vl53l0x_sim_struct_t s_sim;
+	u16 range;
+	u32 reported = 0;
+	u64 end;
+
+	resetSimulation();
+	setupSensor(&s_sensor, &s_sim, 0);
+	s_sim.ps_script = as_obstacleScript;
+	s_sim.scriptLength = sizeof(as_obstacleScript) / sizeof(as_obstacleScript[0]);
+
+	check(vl53l0x_start(&s_sensor), "sensor starts");
+	check(vl53l0x_setInterruptMode(&s_sensor, VL53L0X_INTERRUPT_LEVEL_LOW, 100, 0), "level low interrupt arms");
+	vl53l0x_startContinuous(&s_sensor, 0);
+
+	end = simulation_getTime() + 1000000000ULL;
+	while (simulation_getTime() < end)
+	{
+		range = vl53l0x_readRangeContinuous(&s_sensor);
+		if (range != 0xFFFF)
+		{
+			check(range < 100, "only samples below the threshold are reported");
+			reported++;
+		}
+	}
+	vl53l0x_stopContinuous(&s_sensor);
+
+	printf("  threshold mode: %u of %u samples reported\n", reported, s_sim.samples);
+	check(reported > 0 && reported * 3 <= s_sim.samples, "a quarter of the samples are below the threshold");
+}
+
+void benchFilter()
+{
+	vl53l0x_struct_t s_sensor;
+	vl53l0x_sim_struct_t s_sim;
+	vl53l0x_filter_struct_t s_filter;
+	vl53l0x_filterFlag_enum_t e_flag;
+	u32 filtered = 0;
+	u16 minimum = 0xFFFF, maximum = 0;
+
+	resetSimulation();
+	setupSensor(&s_sensor, &s_sim, 0);
+	s_sim.ps_script = as_noisyScript;
+	s_sim.scriptLength = sizeof(as_noisyScript) / sizeof(as_noisyScript[0]);
+
+	check(vl53l0x_start(&s_sensor), "sensor starts");
+	vl53l0x_startContinuous(&s_sensor, 0);
+
+	s_filter.ps_sensor = &s_sensor;
+	s_filter.minSignalRate = 32;
+	s_filter.maxRange = 2000;
+	s_filter.emaShift = 2;
+	vl53l0x_filter_init(&s_filter);
+
+	i2c_sim_resetStatistics();
+	while (s_sim.samples < BENCH_SAMPLES)
+	{
+		e_flag = vl53l0x_filter_update(&s_filter);
+		if (e_flag == VL53L0X_FILTER_FILTERED)
+		{
+			filtered++;
+			if (s_filter.range < minimum)
+				minimum = s_filter.range;
+			if (s_filter.range > maximum)
+				maximum = s_filter.range;
+		}
+	}
+	vl53l0x_stopContinuous(&s_sensor);
+	printUsage("filtered sample, busy polling", filtered);
+
+	printf("  filter: %u filtered, %u rejected, output %u..%u mm\n", filtered, s_filter.rejected, minimum, maximum);
+	check(s_filter.rejected == BENCH_SAMPLES / 4, "invalid and weak samples are rejected");
+	check(minimum >= 496 && maximum <= 504, "spikes don't reach the output");
+}
+
+void benchHistory()
+{
+	vl53l0x_struct_t s_sensor;
+	vl53l0x_sim_struct_t s_sim;
+	vl53l0x_history_struct_t s_history;
+	vl53l0x_historyIterator_struct_t s_iterator;
+	vl53l0x_record_struct_t const * ps_record;
+	vl53l0x_record_struct_t const * ps_previous = NULL;
+	u32 from, to, seen;
+	u8 i, expected = 0, windowCount = 0;
+	bool b_ordered = TRUE;
+
+	resetSimulation();
+	setupSensor(&s_sensor, &s_sim, 0);
+	s_sim.ps_script = as_rampScript;
+	s_sim.scriptLength = sizeof(as_rampScript) / sizeof(as_rampScript[0]);
+
+	check(vl53l0x_start(&s_sensor), "sensor starts");
+	vl53l0x_startContinuous(&s_sensor, 0);
+
+	s_history.ps_sensor = &s_sensor;
+	vl53l0x_history_init(&s_history);
+	check(vl53l0x_history_getLatest(&s_history) == NULL, "empty history has no latest record");
+
+	while (s_history.pushCount < 3 * VL53L0X_HISTORY_SIZE / 2)
+		vl53l0x_history_update(&s_history);
+	seen = s_history.pushCount;
+	while (s_history.pushCount < 2 * VL53L0X_HISTORY_SIZE)
+		vl53l0x_history_update(&s_history);
+	vl53l0x_stopContinuous(&s_sensor);
+
+	check(s_history.count == VL53L0X_HISTORY_SIZE, "history keeps the last samples");
+	check(vl53l0x_history_countSince(&s_history, seen) == VL53L0X_HISTORY_SIZE / 2, "consumer sees the samples pushed since it last looked");
+	check(vl53l0x_history_get(&s_history, VL53L0X_HISTORY_SIZE) == NULL, "history doesn't go further back than its size");
+
+	/* Any time between two records must give the older one */
+	for (i = 1; i < VL53L0X_HISTORY_SIZE; i++)
+		if (vl53l0x_history_getAt(&s_history, vl53l0x_history_get(&s_history, i - 1)->timestamp - 1) != vl53l0x_history_get(&s_history, i))
+			b_ordered = FALSE;
+	check(b_ordered, "lookup by time returns the record read at or before");
+	check(vl53l0x_history_getAt(&s_history, vl53l0x_history_get(&s_history, VL53L0X_HISTORY_SIZE - 1)->timestamp - 1) == NULL, "lookup before the oldest record fails");
+
+	/* Middle half of the covered time */
+	from = vl53l0x_history_get(&s_history, VL53L0X_HISTORY_SIZE - 1)->timestamp;
+	to = vl53l0x_history_getLatest(&s_history)->timestamp;
+	from += (to - from) / 4;
+	to -= (to - from) / 3;
+	for (i = 0; i < VL53L0X_HISTORY_SIZE; i++)
+		if (vl53l0x_history_get(&s_history, i)->timestamp >= from && vl53l0x_history_get(&s_history, i)->timestamp <= to)
+			expected++;
+
+	b_ordered = TRUE;
+	vl53l0x_history_window(&s_history, &s_iterator, from, to);
+	while ((ps_record = vl53l0x_history_next(&s_iterator)) != NULL)
+	{
+		if (ps_record->timestamp < from || ps_record->timestamp > to || (ps_previous != NULL && ps_record->timestamp <= ps_previous->timestamp))
+			b_ordered = FALSE;
+		ps_previous = ps_record;
+		windowCount++;
+	}
+
+	printf("  history: %u records over %lu ms, window %lu..%lu ms holds %u\n", s_history.count, (unsigned long)(vl53l0x_history_getLatest(&s_history)->timestamp - vl53l0x_history_get(&s_history, VL53L0X_HISTORY_SIZE - 1)->timestamp), (unsigned long)from, (unsigned long)to, windowCount);
+	check(windowCount == expected && expected > 0, "window returns every record in the time range");
+	check(b_ordered, "window returns the records oldest first");
+}
+
+void benchAdaptive()
+{
+	vl53l0x_struct_t s_sensor;
+	vl53l0x_sim_struct_t s_sim;
+	vl53l0x_adaptive_struct_t s_adaptive;
+	u16 range, i;
+	u32 au32_samples[4] = { 0, 0, 0, 0 };
+	vl53l0x_mode_enum_t e_previous;
+
+	/* Driving towards a wall from 1.6 m to 0.1 m, with +-12mm of noise */
+	for (i = 0; i < BENCH_APPROACH; i++)
+	{
+		as_approachScript[i].range = 1600 - (i * 1500) / (BENCH_APPROACH - 1) + ((i * 7) % 5) * 6 - 12;
+		as_approachScript[i].rangeStatus = VL53L0X_SIM_RANGE_VALID;
+		as_approachScript[i].signalRate = 0x0A00;
+	}
+
+	resetSimulation();
+	setupSensor(&s_sensor, &s_sim, 0);
+	s_sim.ps_script = as_approachScript;
+	s_sim.scriptLength = BENCH_APPROACH;
+
+	check(vl53l0x_start(&s_sensor), "sensor starts");
+
+	s_adaptive.ps_sensor = &s_sensor;
+	s_adaptive.continuous = TRUE;
+	s_adaptive.rangingPeriod = 0;
+	s_adaptive.nearRange = 200;
+	s_adaptive.farRange = 1000;
+	s_adaptive.fastVelocity = 500;
+	s_adaptive.noisyVariance = 400;
+	s_adaptive.slowVelocity = 100;
+	s_adaptive.hysteresisShift = 3;
+	s_adaptive.dwell = 4;
+	check(vl53l0x_adaptive_init(&s_adaptive), "adaptive manager starts");
+	vl53l0x_adaptive_setVelocity(&s_adaptive, -300);
+
+	printf("  adaptive modes:");
+	e_previous = s_adaptive.e_mode;
+	printf(" %u", e_previous);
+	while (s_sim.samples < BENCH_APPROACH - 1)
+	{
+		range = vl53l0x_readRangeContinuous(&s_sensor);
+		if (range == 0xFFFF)
+			continue;
+
+		au32_samples[s_adaptive.e_mode]++;
+		vl53l0x_adaptive_update(&s_adaptive, range);
+		if (s_adaptive.e_mode != e_previous)
+		{
+			e_previous = s_adaptive.e_mode;
+			printf(" %u@%umm", e_previous, range);
+		}
+	}
+	printf("\n  samples per mode: %u %u %u %u in %.2f s\n", au32_samples[0], au32_samples[1], au32_samples[2], au32_samples[3], (double)simulation_getTime() / 1000000000.0);
+	check(s_adaptive.e_mode == VL53L0X_MAX_SPEED, "close to the wall in high speed mode");
+	check(s_adaptive.switches <= 3, "no mode thrashing on the approach");
+	check(au32_samples[VL53L0X_MAX_ACCURACY] == 0, "no long measurements while moving");
+
+	vl53l0x_stopContinuous(&s_sensor);
+}
+
+void benchArray()
+{
+	vl53l0x_struct_t as_sensors[3];
+	vl53l0x_sim_struct_t as_sims[3];
+	vl53l0x_array_struct_t s_array;
+	u8 i;
+	u64 end;
+	u32 au32_samples[3] = { 0, 0, 0 };
+	u8 newSamples;
+
+	resetSimulation();
+	for (i = 0; i < 3; i++)
+	{
+		as_sims[i].xshutPin.port = PD;
+		as_sims[i].xshutPin.number = i;
+		as_sims[i].measurementTime = 0;
+		as_sims[i].ps_script = NULL;
+		as_sims[i].nackCount = 0;
+		as_sims[i].nackDelay = 0;
+		as_sims[i].stuckBusy = FALSE;
+		as_sims[i].partOffset = 0;
+		as_sims[i].crosstalkRate = 0;
+		vl53l0x_sim_init(&as_sims[i]);
+
+		as_sensors[i].i2cTimeout = 100;
+		as_sensors[i].xshutPin = as_sims[i].xshutPin;
+		s_array.au8_conflicts[i] = 0;
+	}
+
+	s_array.ps_sensors = as_sensors;
+	s_array.sensorCount = 3;
+	s_array.firstAddress = VL53L0X_ADDRESS_DEFAULT + 1;
+	s_array.mode = VL53L0X_DEFAULT;
+	s_array.rangingPeriod = 0;
+	s_array.singleShot = FALSE;
+	/* The first two sensors face each other, the third one sees neither */
+	s_array.au8_conflicts[1] = 0x01;
+
+	vl53l0x_array_init(&s_array);
+	i2c_sim_resetStatistics();
+	check(vl53l0x_array_start(&s_array), "array starts");
+	printUsage("vl53l0x_array_start (3 sensors)", 1);
+	check(i2c_sim_getStatistics().collisions == 0, "no two sensors answer on the same address");
+	check(s_array.slotCount == 2, "two slots for a conflicting pair");
+
+	i2c_sim_resetStatistics();
+	end = simulation_getTime() + 1000000000ULL;
+	while (simulation_getTime() < end)
+	{
+		newSamples = vl53l0x_array_read(&s_array);
+		for (i = 0; i < 3; i++)
+			if (newSamples & (1 << i))
+				au32_samples[i]++;
+	}
+	printUsage("array sample, busy polling", au32_samples[0] + au32_samples[1] + au32_samples[2]);
+	printf("  array samples in 1 s: %u %u %u\n", au32_samples[0], au32_samples[1], au32_samples[2]);
+	check(au32_samples[2] > au32_samples[0] && au32_samples[2] > au32_samples[1], "the isolated sensor ranges in every slot");
+
+	vl53l0x_array_stop(&s_array);
+}
+
+void benchBatch()
+{
+	vl53l0x_struct_t as_sensors[3];
+	vl53l0x_sim_struct_t as_sims[3];
+	vl53l0x_array_struct_t s_array;
+	u8 i, newSamples;
+	u64 start, serialTime, batchTime;
+
+	resetSimulation();
+	for (i = 0; i < 3; i++)
+	{
+		as_sims[i].xshutPin.port = PD;
+		as_sims[i].xshutPin.number = i;
+		as_sims[i].measurementTime = 0;
+		as_sims[i].ps_script = NULL;
+		as_sims[i].nackCount = 0;
+		as_sims[i].nackDelay = 0;
+		as_sims[i].stuckBusy = FALSE;
+		as_sims[i].partOffset = 0;
+		as_sims[i].crosstalkRate = 0;
+		vl53l0x_sim_init(&as_sims[i]);
+
+		as_sensors[i].i2cTimeout = 100;
+		as_sensors[i].xshutPin = as_sims[i].xshutPin;
+		s_array.au8_conflicts[i] = 0;
+	}
+
+	s_array.ps_sensors = as_sensors;
+	s_array.sensorCount = 3;
+	s_array.firstAddress = VL53L0X_ADDRESS_DEFAULT + 1;
+	s_array.mode = VL53L0X_DEFAULT;
+	s_array.rangingPeriod = 0;
+	s_array.singleShot = TRUE;
+
+	vl53l0x_array_init(&s_array);
+	check(vl53l0x_array_start(&s_array), "single shot array starts");
+
+	/* Reference: one sensor after the other */
+	start = simulation_getTime();
+	for (i = 0; i < 3; i++)
+		vl53l0x_readRangeSingle(&as_sensors[i]);
+	serialTime = simulation_getTime() - start;
+
+	i2c_sim_resetStatistics();
+	start = simulation_getTime();
+	newSamples = vl53l0x_array_measure(&s_array);
+	batchTime = simulation_getTime() - start;
+	printUsage("vl53l0x_array_measure (3 sensors)", 1);
+
+	printf("  3 sensors: serial %.1f ms, batch %.1f ms\n", serialTime / 1000000.0, batchTime / 1000000.0);
+	check(newSamples == 0x07, "batch delivers every sensor");
+	check(batchTime * 2 < serialTime, "batch takes about one timing budget");
+
+	/* Conflicting pair: two slots, the isolated sensor is only measured once */
+	vl53l0x_array_stop(&s_array);
+	s_array.au8_conflicts[1] = 0x01;
+	vl53l0x_array_init(&s_array);
+	vl53l0x_array_start(&s_array);
+	for (i = 0; i < 3; i++)
+		as_sims[i].samples = 0;
+	newSamples = vl53l0x_array_measure(&s_array);
+	check(newSamples == 0x07 && as_sims[2].samples == 1, "each sensor is measured once per batch");
+	check(vl53l0x_array_getSampleRate(&s_array, 2) == vl53l0x_array_getSampleRate(&s_array, 0), "batch rate is the same for all sensors");
+
+	vl53l0x_array_stop(&s_array);
+}
+
+s16 calibrationError(vl53l0x_struct_t* ps_sensor, vl53l0x_sim_struct_t* ps_sim)
+{
+	ps_sim->ps_script = as_farTargetScript;
+	ps_sim->scriptLength = 1;
+
+	return (s16)vl53l0x_readRangeSingle(ps_sensor) - as_farTargetScript[0].range;
+}
+
+void benchCalibration()
+{
+	vl53l0x_struct_t s_sensor;
+	vl53l0x_sim_struct_t s_sim;
+	vl53l0x_calibration_struct_t s_stored;
+	s16 uncalibrated, calibrated, restarted, restored;
+
+	resetSimulation();
+	setupSensor(&s_sensor, &s_sim, 0);
+	/* Cover glass: 0.5 MCPS crosstalk and 12mm offset */
+	s_sim.partOffset = 12;
+	s_sim.crosstalkRate = 0x0040;
+
+	check(vl53l0x_start(&s_sensor), "sensor starts");
+	vl53l0x_setMode(&s_sensor, VL53L0X_MAX_SPEED);
+	uncalibrated = calibrationError(&s_sensor, &s_sim);
+
+	i2c_sim_resetStatistics();
+	s_sim.ps_script = as_nearTargetScript;
+	s_sim.scriptLength = 1;
+	check(vl53l0x_calibrateOffset(&s_sensor, 100, 10), "offset calibration succeeds");
+	s_sim.ps_script = as_farTargetScript;
+	check(vl53l0x_calibrateCrosstalk(&s_sensor, 600, 10), "crosstalk calibration succeeds");
+	s_sim.ps_script = as_nearTargetScript;
+	check(vl53l0x_calibrateOffset(&s_sensor, 100, 10), "offset calibration with compensation succeeds");
+	printUsage("offset, crosstalk, offset (10 each)", 1);
+	calibrated = calibrationError(&s_sensor, &s_sim);
+	s_stored = *vl53l0x_getCalibration(&s_sensor);
+
+	/* The calibration survives a power cycle */
+	vl53l0x_stop(&s_sensor);
+	vl53l0x_start(&s_sensor);
+	vl53l0x_setMode(&s_sensor, VL53L0X_MAX_SPEED);
+	restarted = calibrationError(&s_sensor, &s_sim);
+
+	/* And can be restored from non-volatile memory after a reboot */
+	vl53l0x_stop(&s_sensor);
+	vl53l0x_init(&s_sensor);
+	s_sensor.i2cTimeout = 100;
+	vl53l0x_start(&s_sensor);
+	vl53l0x_setMode(&s_sensor, VL53L0X_MAX_SPEED);
+	vl53l0x_setCalibration(&s_sensor, &s_stored);
+	restored = calibrationError(&s_sensor, &s_sim);
+
+	printf("  600mm error: %d mm uncalibrated, %d calibrated, %d restarted, %d restored (offset %d/4 mm, crosstalk 0x%04X)\n", uncalibrated, calibrated, restarted, restored, s_stored.offset, s_stored.crosstalk);
+	check(uncalibrated < -100, "cover glass pulls the range in");
+	check(calibrated >= -5 && calibrated <= 5, "calibrated range is within 5mm");
+	check(restarted == calibrated && restored == calibrated, "calibration is applied again after restart and restore");
+}
+
+u64 timeToFirstSample(vl53l0x_struct_t* ps_sensor)
+{
+	u64 start = simulation_getTime();
+
+	while (vl53l0x_readRangeContinuous(ps_sensor) == 0xFFFF);
+
+	return simulation_getTime() - start;
+}
+
+void benchStandby()
+{
+	vl53l0x_struct_t s_sensor;
+	vl53l0x_sim_struct_t s_sim;
+	u64 start, restartTime, resumeTime;
+	u32 restartTransactions;
+
+	resetSimulation();
+	setupSensor(&s_sensor, &s_sim, 0);
+	check(vl53l0x_start(&s_sensor), "sensor starts");
+	vl53l0x_setMode(&s_sensor, VL53L0X_MAX_SPEED);
+	vl53l0x_startContinuous(&s_sensor, 0);
+	timeToFirstSample(&s_sensor);
+
+	/* Reference: power down with XSHUT and initialize again */
+	vl53l0x_stop(&s_sensor);
+	simulation_advance(100000000ULL);
+	i2c_sim_resetStatistics();
+	start = simulation_getTime();
+	vl53l0x_start(&s_sensor);
+	vl53l0x_setMode(&s_sensor, VL53L0X_MAX_SPEED);
+	vl53l0x_startContinuous(&s_sensor, 0);
+	printUsage("stop, then start", 1);
+	restartTransactions = i2c_sim_getStatistics().transactions;
+	timeToFirstSample(&s_sensor);
+	restartTime = simulation_getTime() - start;
+
+	vl53l0x_standby(&s_sensor);
+	simulation_advance(100000000ULL);
+	check(vl53l0x_readRangeContinuous(&s_sensor) == 0xFFFF, "no sample during standby");
+	i2c_sim_resetStatistics();
+	start = simulation_getTime();
+	vl53l0x_resume(&s_sensor);
+	printUsage("standby, then resume", 1);
+	check(i2c_sim_getStatistics().transactions * 10 < restartTransactions, "resuming is much cheaper than restarting");
+	timeToFirstSample(&s_sensor);
+	resumeTime = simulation_getTime() - start;
+
+	printf("  first sample after %.1f ms from reset, %.1f ms from standby (budget %.1f ms)\n", restartTime / 1000000.0, resumeTime / 1000000.0, s_sensor.timingBudget / 1000.0);
+	check(resumeTime < (u64)s_sensor.timingBudget * 1100, "first sample within one timing budget after resuming");
+
+	vl53l0x_stop(&s_sensor);
+}
+
+void benchFaults()
+{
+	vl53l0x_struct_t s_sensor;
+	vl53l0x_sim_struct_t s_sim;
+	u64 start;
+	u8 value;
+
+	resetSimulation();
+	setupSensor(&s_sensor, &s_sim, 0);
+	check(vl53l0x_start(&s_sensor), "sensor starts");
+
+	s_sim.stuckBusy = TRUE;
+	start = simulation_getTime();
+	check(vl53l0x_readRangeSingle(&s_sensor) == 0xFFFF, "stuck measurement returns no range");
+	check(vl53l0x_timeoutOccurred(&s_sensor), "stuck measurement reports a timeout");
+	printf("  stuck busy gave up after %.1f ms\n", (double)(simulation_getTime() - start) / 1000000.0);
+	s_sim.stuckBusy = FALSE;
+
+	s_sim.nackCount = 0xFFFF;
+	start = simulation_getTime();
+	check(vl53l0x_readRangeSingle(&s_sensor) == 0xFFFF, "silent sensor returns no range");
+	check(vl53l0x_timeoutOccurred(&s_sensor), "silent sensor reports a timeout");
+	printf("  NACKing sensor gave up after %.1f ms\n", (double)(simulation_getTime() - start) / 1000000.0);
+#ifdef VL53L0X_STATISTICS
+	check(vl53l0x_getStatistics(&s_sensor)->timeouts == 2, "driver counts both timeouts");
+#endif
+	s_sim.nackCount = 0;
+
+	/* Timeouts must keep working after the millisecond counter passes 16 bits */
+	simulation_advance(70000000000ULL);
+	check(vl53l0x_readRangeSingle(&s_sensor) != 0xFFFF, "single shot after 70 s of uptime");
+	check(!vl53l0x_timeoutOccurred(&s_sensor), "no spurious timeout after 70 s of uptime");
+
+	/* Halting clears the stop variable, so the next single shot loads it again in a page 1 sequence. Its third message is NACKed after the sensor went to page 1. */
+	vl53l0x_startContinuous(&s_sensor, 0);
+	vl53l0x_stopContinuous(&s_sensor);
+	s_sim.nackDelay = 2;
+	s_sim.nackCount = 1;
+	check(vl53l0x_readRangeSingle(&s_sensor) != 0xFFFF, "single shot after a NACK in a page 1 sequence");
+	check(!vl53l0x_timeoutOccurred(&s_sensor), "no timeout after a NACK in a page 1 sequence");
+	check(s_sim.page == 0, "sensor is back on page 0");
+	check(vl53l0x_readRangeSingle(&s_sensor) != 0xFFFF && s_sim.au8_registers[1][0x91] == s_sensor.stopVariable, "stop variable is loaded again");
+
+	/* A failed read of a cached register (GPIO_HV_MUX_ACTIVE_HIGH) must not leave the idle bus filler in the cache */
+	regmap_invalidate(&s_sensor.s_regmap);
+	s_sim.nackCount = 1;
+	regmap_read(&s_sensor.s_regmap, 0x84);
+	check(!regmap_getCached(&s_sensor.s_regmap, 0, 0x84, &value), "failed read leaves the register uncached");
+	check(regmap_read(&s_sensor.s_regmap, 0x84) == s_sim.au8_registers[0][0x84], "next read returns the sensor value");
+	regmap_write(&s_sensor.s_regmap, 0x84, 0xFF);
+	check(s_sim.au8_registers[0][0x84] == 0xFF, "write of the filler value reaches the sensor");
+}
+
+/************************************************************************/
+/* Exported functions                                                   */
+/************************************************************************/
+
+int main()
+{
+	printf("%-34s %10s %10s %12s\n", "operation", "trans.", "bytes", "bus us");
+
+	benchBus();
+#ifdef I2CBUS_TRACE
+	benchTrace();
+#endif
+	benchSingleSensor();
+	benchVcselPeriod();
+	benchAsync();
+	benchThreshold();
+	benchFilter();
+	benchHistory();
+	benchAdaptive();
+	benchArray();
+	benchBatch();
+	benchCalibration();
+	benchStandby();
+	benchFaults();
+
+	printf("%u failed checks\n", u8_failures);
+
+	return u8_failures;
+}
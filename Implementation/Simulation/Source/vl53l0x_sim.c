@@ -0,0 +1,418 @@
+/**	@file		vl53l0x_sim.c
+	@brief		Register level model of the VL53L0X distance sensor
+	@details	See @link vl53l0x_sim.h @endlink for details.
+*/
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include <stddef.h>
+#include <string.h>
+
+#include "simulation.h"
+#include "vl53l0x_sim.h"
+
+/************************************************************************/
+/* Defines, enums, structs, types                                       */
+/************************************************************************/
+
+#define SIM_SYSRANGE_START					0x00
+#define SIM_SYSTEM_SEQUENCE_CONFIG			0x01
+#define SIM_SYSTEM_INTERMEASUREMENT_PERIOD	0x04
+#define SIM_SYSTEM_INTERRUPT_CONFIG_GPIO	0x0A
+#define SIM_SYSTEM_INTERRUPT_CLEAR			0x0B
+#define SIM_SYSTEM_THRESH_HIGH				0x0C
+#define SIM_SYSTEM_THRESH_LOW				0x0E
+#define SIM_CROSSTALK_COMPENSATION			0x20
+#define SIM_RANGE_OFFSET					0x28
+#define SIM_RESULT_INTERRUPT_STATUS			0x13
+#define SIM_RESULT_RANGE_STATUS				0x14
+#define SIM_MSRC_CONFIG_TIMEOUT_MACROP		0x46
+#define SIM_PRE_RANGE_CONFIG_VCSEL_PERIOD	0x50
+#define SIM_PRE_RANGE_CONFIG_TIMEOUT		0x51
+#define SIM_FINAL_RANGE_CONFIG_VCSEL_PERIOD	0x70
+#define SIM_FINAL_RANGE_CONFIG_TIMEOUT		0x71
+#define SIM_GPIO_HV_MUX_ACTIVE_HIGH			0x84
+#define SIM_I2C_SLAVE_DEVICE_ADDRESS		0x8A
+#define SIM_IDENTIFICATION_MODEL_ID			0xC0
+#define SIM_IDENTIFICATION_REVISION_ID		0xC2
+#define SIM_OSC_CALIBRATE_VAL				0xF8
+#define SIM_PAGE_SELECT						0xFF
+
+#define SIM_DEFAULT_ADDRESS					0x29
+#define SIM_OSC_CALIBRATE					0x0400
+#define SIM_EFFECTIVE_SPADS					0x0A00
+#define SIM_START_CLEAR_TIME				100000ULL		/* Nanoseconds until the start bit clears */
+#define SIM_CALIBRATION_TIME				1000000ULL		/* Nanoseconds for a reference calibration */
+
+typedef enum simRanging_enum_t
+{
+	SIM_IDLE, SIM_SINGLE, SIM_CALIBRATION, SIM_BACK_TO_BACK, SIM_TIMED
+}simRanging_enum_t;
+
+/************************************************************************/
+/* Internal functions                                                   */
+/************************************************************************/
+
+u16 simRegister16(vl53l0x_sim_struct_t* ps_sim, u8 u8_register)
+{
+	return ((u16)ps_sim->au8_registers[0][u8_register] << 8) | ps_sim->au8_registers[0][u8_register + 1];
+}
+
+u32 simTimeoutToMicroseconds(u16 u16_mclks, u8 u8_vcselRegister)
+{
+	u32 vcselPeriod = ((u32)u8_vcselRegister + 1) << 1;
+	u32 macroPeriod = ((2304UL * vcselPeriod * 1655) + 500) / 1000;
+
+	return ((u16_mclks * macroPeriod) + 500) / 1000;
+}
+
+u16 simDecodeTimeout(u16 u16_value)
+{
+	return (u16)((u16_value & 0x00FF) << ((u16_value & 0xFF00) >> 8)) + 1;
+}
+
+u64 simMeasurementTime(vl53l0x_sim_struct_t* ps_sim)
+{
+	u8 sequence = ps_sim->au8_registers[0][SIM_SYSTEM_SEQUENCE_CONFIG];
+	u8 preVcsel = ps_sim->au8_registers[0][SIM_PRE_RANGE_CONFIG_VCSEL_PERIOD];
+	u8 finalVcsel = ps_sim->au8_registers[0][SIM_FINAL_RANGE_CONFIG_VCSEL_PERIOD];
+	u16 preRangeMclks = simDecodeTimeout(simRegister16(ps_sim, SIM_PRE_RANGE_CONFIG_TIMEOUT));
+	u16 finalRangeMclks = simDecodeTimeout(simRegister16(ps_sim, SIM_FINAL_RANGE_CONFIG_TIMEOUT));
+	u32 msrcUs = simTimeoutToMicroseconds(ps_sim->au8_registers[0][SIM_MSRC_CONFIG_TIMEOUT_MACROP] + 1, preVcsel);
+	u32 total = 1910 + 960;
+
+	if (ps_sim->measurementTime != 0)
+		return (u64)ps_sim->measurementTime * 1000;
+
+	/* Same overheads as the timing budget computation of the driver */
+	if (sequence & 0x10)
+		total += msrcUs + 590;
+	if (sequence & 0x08)
+		total += 2 * (msrcUs + 690);
+	else if (sequence & 0x04)
+		total += msrcUs + 660;
+	if (sequence & 0x40)
+	{
+		total += simTimeoutToMicroseconds(preRangeMclks, preVcsel) + 660;
+		finalRangeMclks -= preRangeMclks;
+	}
+	if (sequence & 0x80)
+		total += simTimeoutToMicroseconds(finalRangeMclks, finalVcsel) + 550;
+
+	return (u64)total * 1000;
+}
+
+void simPowerOn(vl53l0x_sim_struct_t* ps_sim)
+{
+	memset(ps_sim->au8_registers, 0, sizeof(ps_sim->au8_registers));
+
+	ps_sim->address = SIM_DEFAULT_ADDRESS;
+	ps_sim->page = 0;
+	ps_sim->indexReceived = FALSE;
+	ps_sim->rangingMode = SIM_IDLE;
+	ps_sim->startPending = FALSE;
+	ps_sim->scriptPosition = 0;
+
+	/* Power on values of the registers the driver reads back */
+	ps_sim->au8_registers[0][SIM_SYSTEM_SEQUENCE_CONFIG] = 0xFF;
+	ps_sim->au8_registers[0][SIM_SYSTEM_INTERRUPT_CONFIG_GPIO] = 0x04;
+	ps_sim->au8_registers[0][SIM_MSRC_CONFIG_TIMEOUT_MACROP] = 0x25;
+	ps_sim->au8_registers[0][SIM_PRE_RANGE_CONFIG_VCSEL_PERIOD] = 0x06;
+	ps_sim->au8_registers[0][SIM_PRE_RANGE_CONFIG_TIMEOUT] = 0x00;
+	ps_sim->au8_registers[0][SIM_PRE_RANGE_CONFIG_TIMEOUT + 1] = 0x96;
+	ps_sim->au8_registers[0][SIM_FINAL_RANGE_CONFIG_VCSEL_PERIOD] = 0x04;
+	ps_sim->au8_registers[0][SIM_FINAL_RANGE_CONFIG_TIMEOUT] = 0x01;
+	ps_sim->au8_registers[0][SIM_FINAL_RANGE_CONFIG_TIMEOUT + 1] = 0xF4;
+	ps_sim->au8_registers[0][SIM_GPIO_HV_MUX_ACTIVE_HIGH] = 0x11;
+	ps_sim->au8_registers[0][SIM_I2C_SLAVE_DEVICE_ADDRESS] = SIM_DEFAULT_ADDRESS;
+	ps_sim->au8_registers[0][0xB0] = 0xFF;
+	ps_sim->au8_registers[0][0xB1] = 0xFF;
+	ps_sim->au8_registers[0][0xB2] = 0xFF;
+	ps_sim->au8_registers[0][0xB3] = 0xFF;
+	ps_sim->au8_registers[0][0xB4] = 0xFF;
+	ps_sim->au8_registers[0][0xB5] = 0x0F;
+	ps_sim->au8_registers[0][SIM_IDENTIFICATION_MODEL_ID] = 0xEE;
+	ps_sim->au8_registers[0][SIM_IDENTIFICATION_REVISION_ID] = 0x10;
+	ps_sim->au8_registers[0][SIM_OSC_CALIBRATE_VAL] = SIM_OSC_CALIBRATE >> 8;
+	ps_sim->au8_registers[0][SIM_OSC_CALIBRATE_VAL + 1] = SIM_OSC_CALIBRATE & 0xFF;
+	ps_sim->au8_registers[1][0x91] = 0x3C;
+	/* Reference SPAD info: 5 aperture SPADs */
+	ps_sim->au8_registers[7][0x92] = 0x85;
+}
+
+void simXshut(void* p_context, bool b_level)
+{
+	vl53l0x_sim_struct_t* ps_sim = (vl53l0x_sim_struct_t*)p_context;
+
+	if (b_level && !ps_sim->powered)
+		simPowerOn(ps_sim);
+
+	ps_sim->powered = b_level;
+}
+
+bool simInterruptCondition(vl53l0x_sim_struct_t* ps_sim, u16 u16_range)
+{
+	u32 low = (u32)(simRegister16(ps_sim, SIM_SYSTEM_THRESH_LOW) & 0x0FFF) << 1;
+	u32 high = (u32)(simRegister16(ps_sim, SIM_SYSTEM_THRESH_HIGH) & 0x0FFF) << 1;
+
+	switch (ps_sim->au8_registers[0][SIM_SYSTEM_INTERRUPT_CONFIG_GPIO] & 0x07)
+	{
+		case 1:
+			return u16_range < low;
+
+		case 2:
+			return u16_range > high;
+
+		case 3:
+			return u16_range < low || u16_range > high;
+
+		case 4:
+			return TRUE;
+
+		default:
+			return FALSE;
+	}
+}
+
+void simCompleteSample(vl53l0x_sim_struct_t* ps_sim)
+{
+	vl53l0x_sim_sample_struct_t s_sample = { 500, VL53L0X_SIM_RANGE_VALID, 0x0A00 };
+	u8* result = &ps_sim->au8_registers[0][SIM_RESULT_RANGE_STATUS];
+	u32 totalRate;
+	u32 compensation;
+	s32 range;
+
+	if (ps_sim->ps_script != NULL && ps_sim->scriptLength != 0)
+	{
+		s_sample = ps_sim->ps_script[ps_sim->scriptPosition];
+		ps_sim->scriptPosition = (ps_sim->scriptPosition + 1) % ps_sim->scriptLength;
+	}
+
+	/* Crosstalk returns at zero distance. The compensation, per SPAD in Q3.13 times the SPAD count, removes its share again. */
+	totalRate = (u32)s_sample.signalRate + ps_sim->crosstalkRate;
+	compensation = ((u32)simRegister16(ps_sim, SIM_CROSSTALK_COMPENSATION) * SIM_EFFECTIVE_SPADS + (1UL << 13)) >> 14;
+	range = totalRate ? (s32)s_sample.range * s_sample.signalRate / totalRate : s_sample.range;
+	if (compensation < totalRate)
+		range = range * (s32)totalRate / (s32)(totalRate - compensation);
+	/* Offset register: 12 bit two's complement in quarter millimeters */
+	range += ps_sim->partOffset + (((s16)(simRegister16(ps_sim, SIM_RANGE_OFFSET) << 4) >> 4) / 4);
+	s_sample.range = (range < 0) ? 0 : range;
+	s_sample.signalRate = (totalRate > 0xFFFF) ? 0xFFFF : totalRate;
+
+	result[0] = s_sample.rangeStatus << 3;
+	/* Effective SPAD count, Q8.8 */
+	result[2] = SIM_EFFECTIVE_SPADS >> 8;
+	result[3] = SIM_EFFECTIVE_SPADS & 0xFF;
+	result[6] = s_sample.signalRate >> 8;
+	result[7] = s_sample.signalRate & 0xFF;
+	/* Ambient rate, Q9.7 */
+	result[8] = 0x00;
+	result[9] = 0x20;
+	result[10] = s_sample.range >> 8;
+	result[11] = s_sample.range & 0xFF;
+
+	if (simInterruptCondition(ps_sim, s_sample.range))
+		ps_sim->au8_registers[0][SIM_RESULT_INTERRUPT_STATUS] = ps_sim->au8_registers[0][SIM_SYSTEM_INTERRUPT_CONFIG_GPIO] & 0x07;
+
+	ps_sim->samples++;
+}
+
+void simUpdate(vl53l0x_sim_struct_t* ps_sim)
+{
+	u64 now = simulation_getTime();
+	u64 period;
+
+	if (ps_sim->startPending && !ps_sim->stuckBusy && now >= ps_sim->startClearTime)
+		ps_sim->startPending = FALSE;
+
+	if (ps_sim->stuckBusy)
+		return;
+
+	while (ps_sim->rangingMode != SIM_IDLE && now >= ps_sim->sampleTime)
+	{
+		switch (ps_sim->rangingMode)
+		{
+			case SIM_CALIBRATION:
+				ps_sim->au8_registers[0][SIM_RESULT_INTERRUPT_STATUS] = 0x04;
+				ps_sim->rangingMode = SIM_IDLE;
+				break;
+
+			case SIM_SINGLE:
+				simCompleteSample(ps_sim);
+				ps_sim->rangingMode = SIM_IDLE;
+				break;
+
+			case SIM_BACK_TO_BACK:
+				simCompleteSample(ps_sim);
+				ps_sim->sampleTime += simMeasurementTime(ps_sim);
+				break;
+
+			case SIM_TIMED:
+				simCompleteSample(ps_sim);
+				period = ((u64)(((u32)simRegister16(ps_sim, SIM_SYSTEM_INTERMEASUREMENT_PERIOD) << 16) | simRegister16(ps_sim, SIM_SYSTEM_INTERMEASUREMENT_PERIOD + 2)) * 1000000) / SIM_OSC_CALIBRATE;
+				ps_sim->sampleTime += (period > simMeasurementTime(ps_sim)) ? period : simMeasurementTime(ps_sim);
+				break;
+		}
+	}
+}
+
+void simStartRanging(vl53l0x_sim_struct_t* ps_sim, u8 u8_value)
+{
+	u64 now = simulation_getTime();
+
+	if (ps_sim->rangingMode == SIM_BACK_TO_BACK || ps_sim->rangingMode == SIM_TIMED)
+	{
+		/* Writing the start bit during continuous ranging stops it */
+		if (u8_value & 0x01)
+			ps_sim->rangingMode = SIM_IDLE;
+		return;
+	}
+
+	if (u8_value & 0x01)
+	{
+		ps_sim->startPending = TRUE;
+		ps_sim->startClearTime = now + SIM_START_CLEAR_TIME;
+
+		/* Reference calibrations run with only the VHV or phase step enabled */
+		if ((u8_value & 0x40) || !(ps_sim->au8_registers[0][SIM_SYSTEM_SEQUENCE_CONFIG] & 0x80))
+		{
+			ps_sim->rangingMode = SIM_CALIBRATION;
+			ps_sim->sampleTime = now + SIM_CALIBRATION_TIME;
+		}
+		else
+		{
+			ps_sim->rangingMode = SIM_SINGLE;
+			ps_sim->sampleTime = now + simMeasurementTime(ps_sim);
+		}
+	}
+	else if (u8_value & 0x02)
+	{
+		ps_sim->rangingMode = SIM_BACK_TO_BACK;
+		ps_sim->sampleTime = now + simMeasurementTime(ps_sim);
+	}
+	else if (u8_value & 0x04)
+	{
+		ps_sim->rangingMode = SIM_TIMED;
+		ps_sim->sampleTime = now + simMeasurementTime(ps_sim);
+	}
+}
+
+void simWriteRegister(vl53l0x_sim_struct_t* ps_sim, u8 u8_register, u8 u8_value)
+{
+	if (u8_register == SIM_PAGE_SELECT)
+	{
+		ps_sim->page = u8_value & 0x07;
+		return;
+	}
+
+	ps_sim->au8_registers[ps_sim->page][u8_register] = u8_value;
+
+	if (ps_sim->page == 0)
+	{
+		switch (u8_register)
+		{
+			case SIM_SYSRANGE_START:
+				simStartRanging(ps_sim, u8_value);
+				break;
+
+			case SIM_SYSTEM_INTERRUPT_CLEAR:
+				if (u8_value & 0x01)
+					ps_sim->au8_registers[0][SIM_RESULT_INTERRUPT_STATUS] = 0;
+				break;
+
+			case SIM_I2C_SLAVE_DEVICE_ADDRESS:
+				ps_sim->address = u8_value & 0x7F;
+				break;
+		}
+	}
+	/* Reference SPAD info read: the strobe completes immediately */
+	else if (ps_sim->page == 7 && u8_register == 0x83 && u8_value == 0x00)
+		ps_sim->au8_registers[7][0x83] = 0x10;
+}
+
+u8 simReadRegister(vl53l0x_sim_struct_t* ps_sim, u8 u8_register)
+{
+	if (u8_register == SIM_PAGE_SELECT)
+		return ps_sim->page;
+
+	if (ps_sim->page == 0 && u8_register == SIM_SYSRANGE_START)
+		return ps_sim->startPending ? (ps_sim->au8_registers[0][SIM_SYSRANGE_START] | 0x01) : (ps_sim->au8_registers[0][SIM_SYSRANGE_START] & ~0x01);
+
+	return ps_sim->au8_registers[ps_sim->page][u8_register];
+}
+
+bool simStart(void* p_context, u8 u8_address, bool b_read)
+{
+	vl53l0x_sim_struct_t* ps_sim = (vl53l0x_sim_struct_t*)p_context;
+
+	if (!ps_sim->powered || u8_address != ps_sim->address)
+		return FALSE;
+
+	if (ps_sim->nackDelay > 0)
+		ps_sim->nackDelay--;
+	else if (ps_sim->nackCount > 0)
+	{
+		ps_sim->nackCount--;
+		return FALSE;
+	}
+
+	simUpdate(ps_sim);
+
+	if (!b_read)
+		ps_sim->indexReceived = FALSE;
+
+	return TRUE;
+}
+
+bool simWrite(void* p_context, u8 u8_data)
+{
+	vl53l0x_sim_struct_t* ps_sim = (vl53l0x_sim_struct_t*)p_context;
+
+	simUpdate(ps_sim);
+
+	if (!ps_sim->indexReceived)
+	{
+		ps_sim->index = u8_data;
+		ps_sim->indexReceived = TRUE;
+	}
+	else
+		simWriteRegister(ps_sim, ps_sim->index++, u8_data);
+
+	return TRUE;
+}
+
+u8 simRead(void* p_context)
+{
+	vl53l0x_sim_struct_t* ps_sim = (vl53l0x_sim_struct_t*)p_context;
+
+	simUpdate(ps_sim);
+
+	return simReadRegister(ps_sim, ps_sim->index++);
+}
+
+void simStop(void* p_context)
+{
+}
+
+/************************************************************************/
+/* Exported functions                                                   */
+/************************************************************************/
+
+bool vl53l0x_sim_init(vl53l0x_sim_struct_t* ps_sim)
+{
+	ps_sim->samples = 0;
+	ps_sim->powered = FALSE;
+
+	ps_sim->s_device.start = simStart;
+	ps_sim->s_device.write = simWrite;
+	ps_sim->s_device.read = simRead;
+	ps_sim->s_device.stop = simStop;
+	ps_sim->s_device.p_context = ps_sim;
+
+	if (!gpio_sim_attach(ps_sim->xshutPin, simXshut, ps_sim))
+		return FALSE;
+
+	return i2c_sim_attach(&ps_sim->s_device);
+}
@@ -12,6 +12,8 @@
 
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <stddef.h>
 
 /************************************************************************/
 /* Project specific includes                                            */
@@ -22,101 +24,181 @@
 #include "math.h"
 #include "debug.h"
 
+/************************************************************************/
+/* Internal defines, enums, structs, types                              */
+/************************************************************************/
+
+/* Marks the transitions where both outputs changed, the direction is lost */
+#define ENCODER_ILLEGAL	2
+
+/* Clock reads tried before an encoder moving on every read is sampled anyway */
+#define ENCODER_SAMPLE_TRIES	4
+
+#if ENCODER_MAX_ENCODERS > 8
+#error ENCODER_MAX_ENCODERS must not be greater than 8, the number of encoder handlers
+#endif
+
 /************************************************************************/
 /* Internal variables                                                   */
 /************************************************************************/
 
-extern encoder_struct_t s_leftEncoder;
-extern encoder_struct_t s_rightEncoder;
+/* Registered encoders, each slot having its own pin change handler */
+encoder_struct_t* aps_encoders[ENCODER_MAX_ENCODERS];
+
+/* Count change indexed by (previous state << 2) | current state, each state being (A << 1) | B. A leading B counts up. */
+const s8 as8_quadratureTable[16] =
+{
+	0,	-1,	1,	ENCODER_ILLEGAL,
+	1,	0,	ENCODER_ILLEGAL,	-1,
+	-1,	ENCODER_ILLEGAL,	0,	1,
+	ENCODER_ILLEGAL,	1,	-1,	0
+};
 
 /************************************************************************/
 /* Internal functions                                                   */
 /************************************************************************/
 
-void encoder_increment()
+/* The pin registers are resolved by encoder_init, each output is one load and mask */
+u8 encoder_readState(encoder_struct_t *s_encoder){
+	return (gpioFast_read(&s_encoder->s_fastA) ? 2 : 0) | (gpioFast_read(&s_encoder->s_fastB) ? 1 : 0);
+}
+
+void encoder_decode(encoder_struct_t *s_encoder){
+	u8 state = encoder_readState(s_encoder);
+	s8 step = as8_quadratureTable[(s_encoder->lastState << 2) | state];
+
+	s_encoder->lastState = state;
+	if(step == ENCODER_ILLEGAL)
+		s_encoder->illegalTransitions++;
+	else
+		s_encoder->counter += step;
+}
+
+/* The HAL handlers take no argument, so every slot gets its own handler. An edge only decodes the encoder owning the pin. */
+#define ENCODER_HANDLER(n)	void encoder_handler##n(){ encoder_decode(aps_encoders[n]); }
+
+ENCODER_HANDLER(0)
+ENCODER_HANDLER(1)
+ENCODER_HANDLER(2)
+ENCODER_HANDLER(3)
+ENCODER_HANDLER(4)
+ENCODER_HANDLER(5)
+ENCODER_HANDLER(6)
+ENCODER_HANDLER(7)
+
+void (* const af_encoderHandlers[8])(void) =
 {
-	switch(s_leftEncoder.A.port){
-		case PA:
-			s_leftEncoder.currentState = ((checkBit(PINA, s_leftEncoder.A.number)) << s_leftEncoder.A.number) | ((checkBit(PINA, s_leftEncoder.B.number)) << s_leftEncoder.B.number);
-			break;
-		case PB:
-			s_leftEncoder.currentState = ((checkBit(PINB, s_leftEncoder.A.number)) << s_leftEncoder.A.number) | ((checkBit(PINB, s_leftEncoder.B.number)) << s_leftEncoder.B.number);
-			break;
-		case PC:
-			s_leftEncoder.currentState = ((checkBit(PINC, s_leftEncoder.A.number)) << s_leftEncoder.A.number) | ((checkBit(PINC, s_leftEncoder.B.number)) << s_leftEncoder.B.number);
-			break;
-		case PD:
-			s_leftEncoder.currentState = ((checkBit(PIND, s_leftEncoder.A.number)) << s_leftEncoder.A.number) | ((checkBit(PIND, s_leftEncoder.B.number)) << s_leftEncoder.B.number);
-			break;
-		default:
-			break;
-	}
-	switch(s_rightEncoder.A.port){
-		case PA:
-			s_rightEncoder.currentState = ((checkBit(PINA, s_rightEncoder.A.number)) << s_rightEncoder.A.number) | ((checkBit(PINA, s_rightEncoder.B.number)) << s_rightEncoder.B.number);
-			break;
-		case PB:
-			s_rightEncoder.currentState = ((checkBit(PINB, s_rightEncoder.A.number)) << s_rightEncoder.A.number) | ((checkBit(PINB, s_rightEncoder.B.number)) << s_rightEncoder.B.number);
-			break;
-		case PC:
-			s_rightEncoder.currentState = ((checkBit(PINC, s_rightEncoder.A.number)) << s_rightEncoder.A.number) | ((checkBit(PINC, s_rightEncoder.B.number)) << s_rightEncoder.B.number);
-			break;
-		case PD:
-			s_rightEncoder.currentState = ((checkBit(PIND, s_rightEncoder.A.number)) << s_rightEncoder.A.number) | ((checkBit(PIND, s_rightEncoder.B.number)) << s_rightEncoder.B.number);
-			break;
-		default:
-			break;
-	}
-	if(((s_leftEncoder.lastState | s_rightEncoder.lastState) ^ (s_leftEncoder.currentState | s_rightEncoder.currentState)) == (1 << s_leftEncoder.A.number)){
-		s_leftEncoder.counter++;
-	}
-	else if(((s_leftEncoder.lastState | s_rightEncoder.lastState) ^ (s_leftEncoder.currentState | s_rightEncoder.currentState)) == (1 << s_leftEncoder.B.number)){
-		s_leftEncoder.counter++;
-	}
-	else if(((s_leftEncoder.lastState | s_rightEncoder.lastState) ^ (s_leftEncoder.currentState | s_rightEncoder.currentState)) == (1 << s_rightEncoder.A.number)){
-		s_rightEncoder.counter++;
+	encoder_handler0, encoder_handler1, encoder_handler2, encoder_handler3,
+	encoder_handler4, encoder_handler5, encoder_handler6, encoder_handler7
+};
+
+s32 encoder_copyCounter(encoder_struct_t *s_encoder){
+	s32 counter;
+
+	/* A 32 bit copy takes several instructions, an edge in between would tear it */
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		counter = s_encoder->counter;
 	}
-	else if(((s_leftEncoder.lastState | s_rightEncoder.lastState) ^ (s_leftEncoder.currentState | s_rightEncoder.currentState)) == (1 << s_rightEncoder.B.number)){
-		s_rightEncoder.counter++;
+
+	return counter;
+}
+
+/* The clock runs with the interrupts enabled. It is paired with the counter if no edge came while it was read, checked by copying the counter before and after. */
+void encoder_sample(encoder_struct_t *s_encoder, s32 *ps32_counter, u32 *pu32_time){
+	s32 before;
+	u8 tries = ENCODER_SAMPLE_TRIES;
+
+	*ps32_counter = encoder_copyCounter(s_encoder);
+	if(s_encoder->f_clock == NULL){
+		*pu32_time = 0;
+		return;
 	}
-	s_leftEncoder.lastState = s_leftEncoder.currentState;
-	s_rightEncoder.lastState = s_rightEncoder.currentState;
+
+	do{
+		before = *ps32_counter;
+		*pu32_time = s_encoder->f_clock();
+		*ps32_counter = encoder_copyCounter(s_encoder);
+	}while(*ps32_counter != before && --tries != 0);
 }
 
 /************************************************************************/
 /* Exported functions                                                   */
 /************************************************************************/
 
-void encoder_init(encoder_struct_t *s_encoder){
+bool encoder_init(encoder_struct_t *s_encoder){
+	u8 slot;
+
+	/* Reuse the slot of an encoder initialized again, otherwise take the first free one */
+	for(slot = 0; slot < ENCODER_MAX_ENCODERS && aps_encoders[slot] != s_encoder; slot++);
+	if(slot == ENCODER_MAX_ENCODERS)
+		for(slot = 0; slot < ENCODER_MAX_ENCODERS && aps_encoders[slot] != NULL; slot++);
+	if(slot == ENCODER_MAX_ENCODERS)
+		return FALSE;
+
+	aps_encoders[slot] = s_encoder;
 	gpio_init(s_encoder->A);
 	gpio_init(s_encoder->B);
+	gpioFast_init(&s_encoder->s_fastA, s_encoder->A);
+	gpioFast_init(&s_encoder->s_fastB, s_encoder->B);
 	s_encoder->counter = 0;
-	s_encoder->lastState = 0;
-	s_encoder->currentState = 0;
-	gpio_attachInterrupt(s_encoder->A, INTERRUPT_TOGGLE, encoder_increment);
-	gpio_attachInterrupt(s_encoder->B, INTERRUPT_TOGGLE, encoder_increment);
+	s_encoder->illegalTransitions = 0;
+	s_encoder->deltaCounter = 0;
+	s_encoder->deltaTime = s_encoder->f_clock != NULL ? s_encoder->f_clock() : 0;
+	s_encoder->lastState = encoder_readState(s_encoder);
+	gpio_attachInterrupt(s_encoder->A, INTERRUPT_TOGGLE, af_encoderHandlers[slot]);
+	gpio_attachInterrupt(s_encoder->B, INTERRUPT_TOGGLE, af_encoderHandlers[slot]);
+
+	return TRUE;
+}
+
+void encoder_start(encoder_struct_t *s_encoder){
+	/* The wheel may have moved while stopped */
+	s_encoder->lastState = encoder_readState(s_encoder);
+	gpio_enableInterrupt(s_encoder->A, INTERRUPT_TOGGLE);
+	gpio_enableInterrupt(s_encoder->B, INTERRUPT_TOGGLE);
 }
 
-void encoder_start(encoder_struct_t s_encoder){
-	gpio_enableInterrupt(s_encoder.A, INTERRUPT_TOGGLE);
-	gpio_enableInterrupt(s_encoder.B, INTERRUPT_TOGGLE);
+void encoder_stop(encoder_struct_t *s_encoder){
+	gpio_disableInterrupt(s_encoder->A, INTERRUPT_TOGGLE);
+	gpio_disableInterrupt(s_encoder->B, INTERRUPT_TOGGLE);
 }
 
-void encoder_stop(encoder_struct_t s_encoder){
-	gpio_disableInterrupt(s_encoder.A, INTERRUPT_TOGGLE);
-	gpio_disableInterrupt(s_encoder.B, INTERRUPT_TOGGLE);
+s32 encoder_getCounter(encoder_struct_t *s_encoder){
+	return encoder_copyCounter(s_encoder);
 }
 
-u32 encoder_getCounter(encoder_struct_t s_encoder){
-	return s_encoder.counter;
+u32 encoder_getIllegalTransitions(encoder_struct_t *s_encoder){
+	u32 illegalTransitions;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		illegalTransitions = s_encoder->illegalTransitions;
+	}
+
+	return illegalTransitions;
 }
 
 void encoder_resetCounter(encoder_struct_t *s_encoder){
-	s_encoder->counter = 0;
-	s_encoder->currentState = 0;
-	s_encoder->lastState = 0;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		s_encoder->counter = 0;
+		s_encoder->illegalTransitions = 0;
+	}
+
+	/* Edges after the reset belong to the first delta, so the reference is sampled rather than set to 0 */
+	encoder_sample(s_encoder, &s_encoder->deltaCounter, &s_encoder->deltaTime);
+}
+
+void encoder_getDelta(encoder_struct_t *s_encoder, encoder_delta_struct_t *ps_delta){
+	s32 counter;
+	u32 time;
+
+	encoder_sample(s_encoder, &counter, &time);
+
+	ps_delta->counts = counter - s_encoder->deltaCounter;
+	ps_delta->elapsed = time - s_encoder->deltaTime;
+	s_encoder->deltaCounter = counter;
+	s_encoder->deltaTime = time;
 }
 
-double encoder_getDistanceCm(encoder_struct_t s_encoder){
-	return ((double) s_encoder.counter /(double)(GEAR_RATIO * 12)) * (double)(3.141592 * WHEEL_DIAMETER);
+double encoder_getDistanceCm(encoder_struct_t *s_encoder){
+	return ((double) encoder_getCounter(s_encoder) /(double)(GEAR_RATIO * 12)) * (double)(3.141592 * WHEEL_DIAMETER);
 }
\ No newline at end of file
@@ -0,0 +1,189 @@
+/**	@file		encoderCounter.c
+	@brief		Encoder counting in a hardware timer
+	@details	See @link encoderCounter.h @endlink for details.
+*/
+
+/************************************************************************/
+/* AVR includes                                                         */
+/************************************************************************/
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <stddef.h>
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include "encoderCounter.h"
+#include "timer_config.h"
+
+/************************************************************************/
+/* Internal defines, enums, structs, types                              */
+/************************************************************************/
+
+#if defined(ENCODERCOUNTER_USING_TIMER0) && defined(TIMER0_INTERRUPT_MODE)
+#error TIMER0 counts encoder edges, its interrupts must not be enabled in the timer configuration
+#endif
+#if defined(ENCODERCOUNTER_USING_TIMER1) && defined(TIMER1_INTERRUPT_MODE)
+#error TIMER1 counts encoder edges, its interrupts must not be enabled in the timer configuration
+#endif
+#if defined(ENCODERCOUNTER_USING_TIMER3) && defined(TIMER3_INTERRUPT_MODE)
+#error TIMER3 counts encoder edges, its interrupts must not be enabled in the timer configuration
+#endif
+
+/************************************************************************/
+/* Internal variables                                                   */
+/************************************************************************/
+
+/* Software high parts of TIMER0, TIMER1 and TIMER3, advanced by their overflow interrupts */
+volatile u32 au32_encoderCounterHigh[3];
+
+/************************************************************************/
+/* Internal functions                                                   */
+/************************************************************************/
+
+#ifdef ENCODERCOUNTER_USING_TIMER0
+ISR(TIMER0_OVF_vect)
+{
+	au32_encoderCounterHigh[0] += 0x100;
+}
+#endif
+
+#ifdef ENCODERCOUNTER_USING_TIMER1
+ISR(TIMER1_OVF_vect)
+{
+	au32_encoderCounterHigh[1] += 0x10000;
+}
+#endif
+
+#ifdef ENCODERCOUNTER_USING_TIMER3
+ISR(TIMER3_OVF_vect)
+{
+	au32_encoderCounterHigh[2] += 0x10000;
+}
+#endif
+
+u32 encoderCounterRead(timer_peripheral_enum_t e_peripheral)
+{
+	u16 count = 0;
+	u32 high = 0;
+
+	/* The timer, the high part and the pending overflow are read together. 16 bit timer registers go through a shared temporary register. */
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		switch (e_peripheral)
+		{
+			case TIMER0:
+				count = TCNT0;
+				high = au32_encoderCounterHigh[0];
+				/* A pending overflow with a low count wrapped before the read, its interrupt hasn't run yet */
+				if ((TIFR0 & (1 << TOV0)) && count < 0x80)
+					high += 0x100;
+				break;
+			case TIMER1:
+				count = TCNT1;
+				high = au32_encoderCounterHigh[1];
+				if ((TIFR1 & (1 << TOV1)) && count < 0x8000)
+					high += 0x10000;
+				break;
+			case TIMER3:
+				count = TCNT3;
+				high = au32_encoderCounterHigh[2];
+				if ((TIFR3 & (1 << TOV3)) && count < 0x8000)
+					high += 0x10000;
+				break;
+			default:
+				break;
+		}
+	}
+
+	return high + count;
+}
+
+s8 encoderCounterDirection(encoderCounter_struct_t* ps_encoder)
+{
+	s8 direction;
+
+	if (ps_encoder->f_direction == NULL)
+		return gpioFast_read(&ps_encoder->s_fastDirection) ? 1 : -1;
+
+	direction = ps_encoder->f_direction();
+	if (direction == 0)
+		return ps_encoder->sign;
+
+	return direction > 0 ? 1 : -1;
+}
+
+/************************************************************************/
+/* Exported functions                                                   */
+/************************************************************************/
+
+bool encoderCounter_init(encoderCounter_struct_t* ps_encoder)
+{
+	/* Normal mode, clocked by the rising edges of Tn. A stale overflow flag is cleared by writing it. */
+	switch (ps_encoder->peripheral)
+	{
+#ifdef ENCODERCOUNTER_USING_TIMER0
+		case TIMER0:
+			TCCR0A = 0;
+			TCCR0B = (1 << CS02) | (1 << CS01) | (1 << CS00);
+			TIFR0 = (1 << TOV0);
+			TIMSK0 |= (1 << TOIE0);
+			break;
+#endif
+#ifdef ENCODERCOUNTER_USING_TIMER1
+		case TIMER1:
+			TCCR1A = 0;
+			TCCR1B = (1 << CS12) | (1 << CS11) | (1 << CS10);
+			TIFR1 = (1 << TOV1);
+			TIMSK1 |= (1 << TOIE1);
+			break;
+#endif
+#ifdef ENCODERCOUNTER_USING_TIMER3
+		case TIMER3:
+			TCCR3A = 0;
+			TCCR3B = (1 << CS32) | (1 << CS31) | (1 << CS30);
+			TIFR3 = (1 << TOV3);
+			TIMSK3 |= (1 << TOIE3);
+			break;
+#endif
+		default:
+			return FALSE;
+	}
+
+	if (ps_encoder->f_direction == NULL)
+	{
+		gpio_init(ps_encoder->direction);
+		gpioFast_init(&ps_encoder->s_fastDirection, ps_encoder->direction);
+	}
+
+	ps_encoder->sign = 1;
+	encoderCounter_resetCounter(ps_encoder);
+
+	return TRUE;
+}
+
+s32 encoderCounter_update(encoderCounter_struct_t* ps_encoder)
+{
+	u32 count = encoderCounterRead(ps_encoder->peripheral);
+	u32 edges = count - ps_encoder->lastCount;
+
+	ps_encoder->sign = encoderCounterDirection(ps_encoder);
+	ps_encoder->counter += ps_encoder->sign < 0 ? -(s32)edges : (s32)edges;
+	ps_encoder->lastCount = count;
+
+	return ps_encoder->counter;
+}
+
+s32 encoderCounter_getCounter(encoderCounter_struct_t* ps_encoder)
+{
+	return ps_encoder->counter;
+}
+
+void encoderCounter_resetCounter(encoderCounter_struct_t* ps_encoder)
+{
+	ps_encoder->lastCount = encoderCounterRead(ps_encoder->peripheral);
+	ps_encoder->counter = 0;
+}
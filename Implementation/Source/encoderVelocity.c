@@ -0,0 +1,150 @@
+/**	@file		encoderVelocity.c
+	@brief		Wheel velocity from timestamped encoder edges
+	@details	See @link encoderVelocity.h @endlink for details.
+*/
+
+/************************************************************************/
+/* AVR includes                                                         */
+/************************************************************************/
+
+#include <util/atomic.h>
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include "encoderVelocity.h"
+
+/************************************************************************/
+/* Internal functions                                                   */
+/************************************************************************/
+
+s32 encoderVelocityScale(encoderVelocity_struct_t* ps_velocity, s16 s16_edges, u32 u32_span)
+{
+	u32 counts = (u32)(s16_edges < 0 ? -s16_edges : s16_edges) * ENCODERVELOCITY_COUNTS_PER_EDGE;
+	u32 quotient, remainder, magnitude;
+
+	/* Counts times span and the shifted remainder must fit in 32 bits. Only spans of seconds with a fast timer lose low bits. */
+	while (u32_span >= ((u32)1 << (32 - ENCODERVELOCITY_FRACTION_BITS)) || counts > 0xFFFFFFFFUL / u32_span)
+	{
+		counts >>= 1;
+		u32_span >>= 1;
+	}
+
+	/* counts * timerFrequency / span without a 64 bit product: the frequency is split into whole spans and a remainder */
+	quotient = ps_velocity->timerFrequency / u32_span;
+	remainder = ps_velocity->timerFrequency % u32_span;
+	magnitude = counts * quotient + counts * remainder / u32_span;
+	remainder = counts * remainder % u32_span;
+
+	/* The fraction comes from what is left of the division by the span */
+	magnitude = (magnitude << ENCODERVELOCITY_FRACTION_BITS) + (remainder << ENCODERVELOCITY_FRACTION_BITS) / u32_span;
+
+	return s16_edges < 0 ? -(s32)magnitude : (s32)magnitude;
+}
+
+/************************************************************************/
+/* Exported functions                                                   */
+/************************************************************************/
+
+void encoderVelocity_init(encoderVelocity_struct_t* ps_velocity)
+{
+	gpio_init(ps_velocity->B);
+	gpioFast_init(&ps_velocity->s_fastB, ps_velocity->B);
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		ps_velocity->edges = 0;
+		ps_velocity->captures = 0;
+		ps_velocity->lastUpdate = ps_velocity->f_timer();
+	}
+
+	ps_velocity->velocity = 0;
+	ps_velocity->latency = 0;
+	ps_velocity->sinceEdge = 0;
+	ps_velocity->edgeSeen = FALSE;
+}
+
+void encoderVelocity_capture(encoderVelocity_struct_t* ps_velocity, u16 u16_timestamp)
+{
+	/* On a rising edge of A, B is still low when A leads */
+	if (gpioFast_read(&ps_velocity->s_fastB))
+		ps_velocity->edges--;
+	else
+		ps_velocity->edges++;
+
+	ps_velocity->captures++;
+	ps_velocity->lastCapture = u16_timestamp;
+}
+
+s32 encoderVelocity_update(encoderVelocity_struct_t* ps_velocity)
+{
+	s16 edges;
+	u16 captures;
+	u16 capture;
+	u16 now;
+	u32 span;
+	u32 stopTicks = ps_velocity->timerFrequency / 1000 * ENCODERVELOCITY_STOP_TIME_MS;
+	s32 bound;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		now = ps_velocity->f_timer();
+		edges = ps_velocity->edges;
+		captures = ps_velocity->captures;
+		capture = ps_velocity->lastCapture;
+		ps_velocity->edges = 0;
+		ps_velocity->captures = 0;
+	}
+
+	if (captures != 0)
+	{
+		/* A capture latched just before the previous update may be handled after it, so the offset can be negative */
+		span = ps_velocity->sinceEdge + (s16)(capture - ps_velocity->lastUpdate);
+
+		/* The first edge only starts the measurement */
+		if (ps_velocity->edgeSeen && span != 0)
+		{
+			ps_velocity->velocity = encoderVelocityScale(ps_velocity, edges, span);
+			ps_velocity->latency = (u16)(now - capture) + span / 2;
+		}
+
+		ps_velocity->sinceEdge = (u16)(now - capture);
+		ps_velocity->edgeSeen = TRUE;
+	}
+	else
+	{
+		ps_velocity->sinceEdge += (u16)(now - ps_velocity->lastUpdate);
+
+		/* The time since the last edge is lost once saturated, so the first edge after a stop only starts the measurement again */
+		if (ps_velocity->sinceEdge >= stopTicks)
+		{
+			ps_velocity->sinceEdge = stopTicks;
+			ps_velocity->velocity = 0;
+			ps_velocity->latency = 0;
+			ps_velocity->edgeSeen = FALSE;
+		}
+		else if (ps_velocity->edgeSeen)
+		{
+			/* No edge yet means at most one cycle over the time since the last one */
+			bound = encoderVelocityScale(ps_velocity, 1, ps_velocity->sinceEdge);
+			if (ps_velocity->velocity > bound || ps_velocity->velocity < -bound)
+			{
+				ps_velocity->velocity = ps_velocity->velocity < 0 ? -bound : bound;
+				ps_velocity->latency = ps_velocity->sinceEdge / 2;
+			}
+		}
+	}
+
+	ps_velocity->lastUpdate = now;
+
+	return ps_velocity->velocity;
+}
+
+u32 encoderVelocity_getLatencyUs(encoderVelocity_struct_t* ps_velocity)
+{
+	/* Whole milliseconds first, so the product stays within 32 bits */
+	u32 ticksPerMs = ps_velocity->timerFrequency / 1000;
+
+	return ps_velocity->latency / ticksPerMs * 1000 + ps_velocity->latency % ticksPerMs * 1000 / ticksPerMs;
+}
@@ -0,0 +1,57 @@
+/**	@file		gpioFast.c
+	@brief		Fast access to GPIO pins from interrupt handlers
+	@details	See @link gpioFast.h @endlink for details.
+*/
+
+/************************************************************************/
+/* AVR includes                                                         */
+/************************************************************************/
+
+#include <avr/io.h>
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include "gpioFast.h"
+
+/************************************************************************/
+/* Internal variables                                                   */
+/************************************************************************/
+
+/* Stands for the registers of an unknown port, it reads as low */
+volatile u8 u8_gpioFastNone;
+
+/************************************************************************/
+/* Exported functions                                                   */
+/************************************************************************/
+
+void gpioFast_init(gpioFast_struct_t* ps_fast, gpio_struct_t s_gpio)
+{
+	switch (s_gpio.port)
+	{
+		case PA:
+			ps_fast->pu8_pin = &PINA;
+			ps_fast->pu8_port = &PORTA;
+			break;
+		case PB:
+			ps_fast->pu8_pin = &PINB;
+			ps_fast->pu8_port = &PORTB;
+			break;
+		case PC:
+			ps_fast->pu8_pin = &PINC;
+			ps_fast->pu8_port = &PORTC;
+			break;
+		case PD:
+			ps_fast->pu8_pin = &PIND;
+			ps_fast->pu8_port = &PORTD;
+			break;
+		default:
+			ps_fast->pu8_pin = &u8_gpioFastNone;
+			ps_fast->pu8_port = &u8_gpioFastNone;
+			ps_fast->mask = 0;
+			return;
+	}
+
+	ps_fast->mask = 1 << s_gpio.number;
+}
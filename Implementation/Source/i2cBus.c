@@ -0,0 +1,619 @@
+/**	@file		i2cBus.c
+	@brief		Queued I2C transaction engine shared by all the devices of the bus
+	@details	See @link i2cBus.h @endlink for details.
+*/
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include <stddef.h>
+#include <util/atomic.h>
+
+#include <avr/io.h>
+#include <util/twi.h>
+
+#include "i2cBus.h"
+
+#ifdef I2CBUS_INTERRUPT_MODE
+#include <avr/interrupt.h>
+#else
+#include "i2c.h"
+#endif
+
+#ifdef I2CBUS_TRACE
+#include "debug.h"
+#endif
+
+/************************************************************************/
+/* Internal defines, enums, structs, types                              */
+/************************************************************************/
+
+#ifndef I2CBUS_TRACE
+	#define busTraceStart()									((void)0)
+	#define busTraceRecord(ps_transaction, e_status)		((void)0)
+#endif
+
+/************************************************************************/
+/* Internal variables                                                   */
+/************************************************************************/
+
+bool b_busInitialized = FALSE;
+/* Frequency given to i2cBus_init and the one the bus currently runs at */
+u32 u32_busDefaultFrequency;
+u32 u32_busFrequency;
+#ifdef I2CBUS_INTERRUPT_MODE
+u8 u8_busDefaultBitRate;
+#endif
+/* Transaction on the bus is the head of the queue */
+i2cBus_transaction_struct_t* volatile ps_busHead = NULL;
+i2cBus_transaction_struct_t* volatile ps_busTail = NULL;
+
+#ifdef I2CBUS_INTERRUPT_MODE
+/* Position in the segments of the running transaction */
+volatile u8 u8_busSegment;
+volatile u8 u8_busIndex;
+#else
+bool b_busRunning = FALSE;
+#endif
+
+#ifdef I2CBUS_TRACE
+i2cBus_clock_t f_busTraceClock = NULL;
+i2cBus_traceRecord_struct_t as_busTrace[I2CBUS_TRACE_SIZE];
+/* Slot of the next record and number of records not dumped yet */
+u8 u8_busTraceNext = 0;
+u8 u8_busTraceCount = 0;
+u32 u32_busTraceDropped = 0;
+u32 u32_busTraceStart;
+#endif
+
+/************************************************************************/
+/* Internal functions                                                   */
+/************************************************************************/
+
+#ifdef I2CBUS_TRACE
+void busTraceStart()
+{
+	if (f_busTraceClock != NULL)
+		u32_busTraceStart = f_busTraceClock();
+}
+
+void busTraceRecord(i2cBus_transaction_struct_t* ps_transaction, i2cBus_status_enum_t e_status)
+{
+	u8 i;
+	i2cBus_traceRecord_struct_t* ps_record;
+	i2cBus_segment_struct_t* ps_first = &ps_transaction->as_segments[0];
+
+	if (f_busTraceClock == NULL)
+		return;
+
+	ps_record = &as_busTrace[u8_busTraceNext];
+	ps_record->start = u32_busTraceStart;
+	ps_record->end = f_busTraceClock();
+	ps_record->bytes = i2cBus_getFrameBytes(ps_transaction);
+	ps_record->address = ps_transaction->address;
+	ps_record->status = e_status;
+	ps_record->flags = 0;
+
+	for (i = 0; i < ps_transaction->segmentCount; i++)
+		if (ps_transaction->as_segments[i].length != 0)
+			ps_record->flags |= (ps_transaction->as_segments[i].flags & I2CBUS_SEGMENT_READ) ? I2CBUS_TRACE_READ : I2CBUS_TRACE_WRITE;
+
+	if (ps_transaction->segmentCount != 0 && !(ps_first->flags & I2CBUS_SEGMENT_READ) && ps_first->length != 0)
+	{
+		ps_record->reg = ps_first->pu8_data[0];
+		ps_record->flags |= I2CBUS_TRACE_REGISTER;
+	}
+	else
+		ps_record->reg = 0;
+
+	u8_busTraceNext = (u8_busTraceNext + 1) % I2CBUS_TRACE_SIZE;
+	if (u8_busTraceCount < I2CBUS_TRACE_SIZE)
+		u8_busTraceCount++;
+	else
+		u32_busTraceDropped++;
+}
+#endif
+
+u8 busBitRate(u32 u32_frequency)
+{
+#ifdef I2CBUS_INTERRUPT_MODE
+	/* Prescaler 1: SCL = F_CPU / (16 + 2 * TWBR) */
+	if (F_CPU / u32_frequency <= 16)
+		return 0;
+
+	return ((F_CPU / u32_frequency) - 16) / 2;
+#else
+	/* The HAL computes the bit rate itself */
+	return 0;
+#endif
+}
+
+void busSetSpeed(i2cBus_transaction_struct_t* ps_transaction)
+{
+#ifndef I2CBUS_INTERRUPT_MODE
+	i2c_struct_t s_i2c;
+#endif
+	u32 frequency = (ps_transaction->ps_speed != NULL) ? ps_transaction->ps_speed->frequency : u32_busDefaultFrequency;
+
+	if (frequency == u32_busFrequency)
+		return;
+	u32_busFrequency = frequency;
+
+	/* Only called with the bus idle, between a stop and the next start */
+#ifdef I2CBUS_INTERRUPT_MODE
+	TWBR = (ps_transaction->ps_speed != NULL) ? ps_transaction->ps_speed->bitRate : u8_busDefaultBitRate;
+#else
+	s_i2c.frequency = frequency;
+	i2c_init(s_i2c);
+#endif
+}
+
+void busUpdateSpeed(i2cBus_speed_struct_t* ps_speed, i2cBus_status_enum_t e_status)
+{
+	if (e_status == I2CBUS_DONE)
+	{
+		ps_speed->failures = 0;
+		return;
+	}
+
+	if (++ps_speed->failures < I2CBUS_FALLBACK_FAILURES)
+		return;
+	ps_speed->failures = 0;
+
+	if (ps_speed->frequency > I2CBUS_MIN_FREQUENCY)
+	{
+		ps_speed->frequency /= 2;
+		if (ps_speed->frequency < I2CBUS_MIN_FREQUENCY)
+			ps_speed->frequency = I2CBUS_MIN_FREQUENCY;
+		ps_speed->bitRate = busBitRate(ps_speed->frequency);
+	}
+}
+
+i2cBus_transaction_struct_t* busFinish(i2cBus_status_enum_t e_status)
+{
+	i2cBus_transaction_struct_t* ps_done = ps_busHead;
+
+	if (ps_done->ps_speed != NULL)
+		busUpdateSpeed(ps_done->ps_speed, e_status);
+	busTraceRecord(ps_done, e_status);
+
+	ps_busHead = ps_done->ps_next;
+	if (ps_busHead == NULL)
+		ps_busTail = NULL;
+
+	ps_done->ps_next = NULL;
+	ps_done->e_status = e_status;
+
+	return ps_done;
+}
+
+u16 busMessageRemaining(i2cBus_transaction_struct_t* ps_transaction, u8 u8_segment, u8 u8_index)
+{
+	u16 remaining = ps_transaction->as_segments[u8_segment].length - u8_index;
+
+	while (++u8_segment < ps_transaction->segmentCount && (ps_transaction->as_segments[u8_segment].flags & I2CBUS_SEGMENT_CONTINUE))
+		remaining += ps_transaction->as_segments[u8_segment].length;
+
+	return remaining;
+}
+
+#ifdef I2CBUS_INTERRUPT_MODE
+
+#define TWCR_RUN	((1 << TWINT) | (1 << TWEN) | (1 << TWIE))
+
+void busStart()
+{
+	u8_busSegment = 0;
+	u8_busIndex = 0;
+
+	/* The stop condition of the previous transaction has to be on the bus before the next start */
+	while (TWCR & (1 << TWSTO));
+	busSetSpeed(ps_busHead);
+	busTraceStart();
+	TWCR = TWCR_RUN | (1 << TWSTA);
+}
+
+void busEnd(i2cBus_status_enum_t e_status)
+{
+	i2cBus_transaction_struct_t* ps_done;
+
+	TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWSTO);
+
+	ps_done = busFinish(e_status);
+	if (ps_busHead != NULL)
+		busStart();
+
+	if (ps_done->f_callback != NULL)
+		ps_done->f_callback(ps_done);
+}
+
+void busAdvance(i2cBus_transaction_struct_t* ps_transaction)
+{
+	/* Move to the segments continuing the current message once its buffer is exhausted */
+	while (u8_busIndex >= ps_transaction->as_segments[u8_busSegment].length && u8_busSegment + 1 < ps_transaction->segmentCount && (ps_transaction->as_segments[u8_busSegment + 1].flags & I2CBUS_SEGMENT_CONTINUE))
+	{
+		u8_busSegment++;
+		u8_busIndex = 0;
+	}
+}
+
+void busNextMessage(i2cBus_transaction_struct_t* ps_transaction)
+{
+	if (u8_busSegment + 1 < ps_transaction->segmentCount)
+	{
+		u8_busSegment++;
+		u8_busIndex = 0;
+		TWCR = TWCR_RUN | (1 << TWSTA);
+	}
+	else
+		busEnd(I2CBUS_DONE);
+}
+
+void busReadNext(i2cBus_transaction_struct_t* ps_transaction)
+{
+	/* Acknowledge every byte of the message but the last one */
+	if (busMessageRemaining(ps_transaction, u8_busSegment, u8_busIndex) > 1)
+		TWCR = TWCR_RUN | (1 << TWEA);
+	else
+		TWCR = TWCR_RUN;
+}
+
+ISR(TWI_vect)
+{
+	i2cBus_transaction_struct_t* ps_transaction = ps_busHead;
+	i2cBus_segment_struct_t* ps_segment = &ps_transaction->as_segments[u8_busSegment];
+
+	switch (TW_STATUS)
+	{
+		case TW_START:
+		case TW_REP_START:
+			TWDR = (ps_transaction->address << 1) | ((ps_segment->flags & I2CBUS_SEGMENT_READ) ? TW_READ : TW_WRITE);
+			TWCR = TWCR_RUN;
+			break;
+
+		case TW_MT_SLA_ACK:
+		case TW_MT_DATA_ACK:
+			busAdvance(ps_transaction);
+			ps_segment = &ps_transaction->as_segments[u8_busSegment];
+			if (u8_busIndex < ps_segment->length)
+			{
+				TWDR = ps_segment->pu8_data[u8_busIndex++];
+				TWCR = TWCR_RUN;
+			}
+			else
+				busNextMessage(ps_transaction);
+			break;
+
+		case TW_MR_SLA_ACK:
+			busReadNext(ps_transaction);
+			break;
+
+		case TW_MR_DATA_ACK:
+			busAdvance(ps_transaction);
+			ps_transaction->as_segments[u8_busSegment].pu8_data[u8_busIndex++] = TWDR;
+			busAdvance(ps_transaction);
+			busReadNext(ps_transaction);
+			break;
+
+		case TW_MR_DATA_NACK:
+			busAdvance(ps_transaction);
+			ps_transaction->as_segments[u8_busSegment].pu8_data[u8_busIndex++] = TWDR;
+			busNextMessage(ps_transaction);
+			break;
+
+		case TW_MT_SLA_NACK:
+		case TW_MT_DATA_NACK:
+		case TW_MR_SLA_NACK:
+			busEnd(I2CBUS_NACK);
+			break;
+
+		case TW_MT_ARB_LOST:
+			/* Another master took the bus, start over once it is free */
+			u8_busSegment = 0;
+			u8_busIndex = 0;
+			TWCR = TWCR_RUN | (1 << TWSTA);
+			break;
+
+		default:
+			busEnd(I2CBUS_ERROR);
+			break;
+	}
+}
+
+#else
+
+i2cBus_status_enum_t busRun(i2cBus_transaction_struct_t* ps_transaction)
+{
+	u8 segment = 0;
+	u8 i;
+	u16 remaining;
+	bool b_read;
+	i2cBus_segment_struct_t* ps_segment;
+
+	busSetSpeed(ps_transaction);
+	busTraceStart();
+
+	/* One iteration per message. The acknowledge is taken from the TWI status each HAL call leaves in TWSR, the meaning of their return values isn't relied on. */
+	while (segment < ps_transaction->segmentCount)
+	{
+		b_read = (ps_transaction->as_segments[segment].flags & I2CBUS_SEGMENT_READ) != 0;
+		remaining = busMessageRemaining(ps_transaction, segment, 0);
+
+		if (segment == 0)
+			i2c_sendStart((ps_transaction->address << 1) | (b_read ? I2C_READ : I2C_WRITE));
+		else
+			i2c_sendRepStart((ps_transaction->address << 1) | (b_read ? I2C_READ : I2C_WRITE));
+
+		if (TW_STATUS != (b_read ? TW_MR_SLA_ACK : TW_MT_SLA_ACK))
+		{
+			i2c_sendStop();
+			return I2CBUS_NACK;
+		}
+
+		do
+		{
+			ps_segment = &ps_transaction->as_segments[segment];
+
+			for (i = 0; i < ps_segment->length; i++)
+			{
+				remaining--;
+				if (b_read)
+					ps_segment->pu8_data[i] = (remaining != 0) ? i2c_readAck() : i2c_readNak();
+				else
+				{
+					i2c_write(ps_segment->pu8_data[i]);
+					if (TW_STATUS != TW_MT_DATA_ACK)
+					{
+						i2c_sendStop();
+						return I2CBUS_NACK;
+					}
+				}
+			}
+
+			segment++;
+		}while (segment < ps_transaction->segmentCount && (ps_transaction->as_segments[segment].flags & I2CBUS_SEGMENT_CONTINUE));
+	}
+
+	i2c_sendStop();
+
+	return I2CBUS_DONE;
+}
+
+#endif
+
+bool busAddSegment(i2cBus_transaction_struct_t* ps_transaction, u8* pu8_data, u8 u8_length, u8 u8_flags)
+{
+	i2cBus_segment_struct_t* ps_segment;
+
+	if (ps_transaction->segmentCount == I2CBUS_MAX_SEGMENTS)
+		return FALSE;
+
+	ps_segment = &ps_transaction->as_segments[ps_transaction->segmentCount++];
+	ps_segment->pu8_data = pu8_data;
+	ps_segment->length = u8_length;
+	ps_segment->flags = u8_flags;
+
+	return TRUE;
+}
+
+/************************************************************************/
+/* Exported functions                                                   */
+/************************************************************************/
+
+void i2cBus_init(u32 u32_frequency)
+{
+#ifndef I2CBUS_INTERRUPT_MODE
+	i2c_struct_t s_i2c;
+#endif
+
+	if (b_busInitialized)
+		return;
+	b_busInitialized = TRUE;
+	u32_busDefaultFrequency = u32_frequency;
+	u32_busFrequency = u32_frequency;
+
+#ifdef I2CBUS_INTERRUPT_MODE
+	u8_busDefaultBitRate = busBitRate(u32_frequency);
+	TWSR = 0;
+	TWBR = u8_busDefaultBitRate;
+	TWCR = (1 << TWEN);
+#else
+	s_i2c.frequency = u32_frequency;
+	i2c_init(s_i2c);
+	i2c_start();
+#endif
+}
+
+void i2cBus_initSpeed(i2cBus_speed_struct_t* ps_speed, u32 u32_maxFrequency)
+{
+	ps_speed->maxFrequency = u32_maxFrequency;
+	ps_speed->frequency = u32_maxFrequency;
+	ps_speed->bitRate = busBitRate(u32_maxFrequency);
+	ps_speed->failures = 0;
+}
+
+void i2cBus_begin(i2cBus_transaction_struct_t* ps_transaction, u8 u8_address, i2cBus_speed_struct_t* ps_speed)
+{
+	ps_transaction->address = u8_address;
+	ps_transaction->ps_speed = ps_speed;
+	ps_transaction->segmentCount = 0;
+	ps_transaction->f_callback = NULL;
+	ps_transaction->p_context = NULL;
+}
+
+bool i2cBus_addWrite(i2cBus_transaction_struct_t* ps_transaction, u8 const * pu8_data, u8 u8_length)
+{
+	/* Written segments are only read from */
+	return busAddSegment(ps_transaction, (u8*)pu8_data, u8_length, 0);
+}
+
+bool i2cBus_addRead(i2cBus_transaction_struct_t* ps_transaction, u8* pu8_data, u8 u8_length)
+{
+	if (u8_length == 0)
+		return FALSE;
+
+	return busAddSegment(ps_transaction, pu8_data, u8_length, I2CBUS_SEGMENT_READ);
+}
+
+bool i2cBus_appendData(i2cBus_transaction_struct_t* ps_transaction, u8* pu8_data, u8 u8_length)
+{
+	if (u8_length == 0 || ps_transaction->segmentCount == 0)
+		return FALSE;
+
+	return busAddSegment(ps_transaction, pu8_data, u8_length, (ps_transaction->as_segments[ps_transaction->segmentCount - 1].flags & I2CBUS_SEGMENT_READ) | I2CBUS_SEGMENT_CONTINUE);
+}
+
+u16 i2cBus_getFrameBytes(i2cBus_transaction_struct_t const * ps_transaction)
+{
+	u8 i;
+	u16 bytes = 0;
+
+	for (i = 0; i < ps_transaction->segmentCount; i++)
+	{
+		bytes += ps_transaction->as_segments[i].length;
+		if (!(ps_transaction->as_segments[i].flags & I2CBUS_SEGMENT_CONTINUE))
+			bytes++;
+	}
+
+	return bytes;
+}
+
+bool i2cBus_submit(i2cBus_transaction_struct_t* ps_transaction)
+{
+	bool b_queued = FALSE;
+	i2cBus_transaction_struct_t* ps_queued;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		for (ps_queued = ps_busHead; ps_queued != NULL; ps_queued = ps_queued->ps_next)
+			if (ps_queued == ps_transaction)
+				b_queued = TRUE;
+
+		if (!b_queued)
+		{
+			ps_transaction->e_status = I2CBUS_PENDING;
+			ps_transaction->ps_next = NULL;
+
+			if (ps_busHead == NULL)
+			{
+				ps_busHead = ps_transaction;
+				ps_busTail = ps_transaction;
+#ifdef I2CBUS_INTERRUPT_MODE
+				busStart();
+#endif
+			}
+			else
+			{
+				ps_busTail->ps_next = ps_transaction;
+				ps_busTail = ps_transaction;
+			}
+		}
+	}
+
+	if (b_queued)
+		return FALSE;
+
+#ifndef I2CBUS_INTERRUPT_MODE
+	/* A callback submitting another transaction only queues it, the outer call runs it */
+	if (b_busRunning)
+		return TRUE;
+
+	b_busRunning = TRUE;
+	while (ps_busHead != NULL)
+	{
+		i2cBus_transaction_struct_t* ps_done = busFinish(busRun(ps_busHead));
+
+		if (ps_done->f_callback != NULL)
+			ps_done->f_callback(ps_done);
+	}
+	b_busRunning = FALSE;
+#endif
+
+	return TRUE;
+}
+
+i2cBus_status_enum_t i2cBus_transfer(i2cBus_transaction_struct_t* ps_transaction)
+{
+	if (!i2cBus_submit(ps_transaction))
+		return I2CBUS_ERROR;
+
+	while (ps_transaction->e_status == I2CBUS_PENDING);
+
+	return ps_transaction->e_status;
+}
+
+bool i2cBus_isBusy()
+{
+	return ps_busHead != NULL;
+}
+
+#ifdef I2CBUS_TRACE
+void i2cBus_setTraceClock(i2cBus_clock_t f_clock)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		f_busTraceClock = f_clock;
+	}
+}
+
+bool i2cBus_popTrace(i2cBus_traceRecord_struct_t* ps_record)
+{
+	bool b_found = FALSE;
+
+	/* The interrupt may be writing the next record meanwhile */
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if (u8_busTraceCount != 0)
+		{
+			*ps_record = as_busTrace[(u8_busTraceNext + I2CBUS_TRACE_SIZE - u8_busTraceCount) % I2CBUS_TRACE_SIZE];
+			u8_busTraceCount--;
+			b_found = TRUE;
+		}
+	}
+
+	return b_found;
+}
+
+void i2cBus_dumpTrace()
+{
+	i2cBus_traceRecord_struct_t s_record;
+	u8 count, i;
+	u32 dropped;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		count = u8_busTraceCount;
+		dropped = u32_busTraceDropped;
+		u32_busTraceDropped = 0;
+	}
+
+	debug_writeString("I2CTRACE ");
+	debug_writeHex(count);
+	debug_writeChar(' ');
+	debug_writeHexDWord(dropped);
+	debug_writeNewLine();
+
+	/* Records added during the dump stay for the next one */
+	for (i = 0; i < count && i2cBus_popTrace(&s_record); i++)
+	{
+		debug_writeHex(s_record.address);
+		debug_writeChar(' ');
+		debug_writeHex(s_record.reg);
+		debug_writeChar(' ');
+		debug_writeHexWord(s_record.bytes);
+		debug_writeChar(' ');
+		debug_writeHex(s_record.flags);
+		debug_writeChar(' ');
+		debug_writeHex(s_record.status);
+		debug_writeChar(' ');
+		debug_writeHexDWord(s_record.start);
+		debug_writeChar(' ');
+		debug_writeHexDWord(s_record.end);
+		debug_writeNewLine();
+	}
+
+	debug_writeString("END");
+	debug_writeNewLine();
+}
+#endif
@@ -0,0 +1,307 @@
+/**	@file		regmap.c
+	@brief		Register map access to I2C devices
+	@details	See @link regmap.h @endlink for details.
+*/
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include <stddef.h>
+
+#include "regmap.h"
+
+/************************************************************************/
+/* Internal defines, enums, structs, types                              */
+/************************************************************************/
+
+/* Slot returned for the registers which aren't cached */
+#define REGMAP_NO_SLOT	0xFF
+
+/* Description of the registers missing from the map */
+const regmap_register_struct_t s_regmapDefault = { 0, 0, 1, 0 };
+
+/************************************************************************/
+/* Internal functions                                                   */
+/************************************************************************/
+
+regmap_register_struct_t const * regmapFind(regmap_struct_t* ps_regmap, u8 u8_page, u8 u8_register, u8* pu8_slot)
+{
+	u8 i;
+	u8 slot = 0;
+	regmap_register_struct_t const * ps_register;
+
+	*pu8_slot = REGMAP_NO_SLOT;
+
+	for (i = 0; i < ps_regmap->ps_map->registerCount; i++)
+	{
+		ps_register = &ps_regmap->ps_map->as_registers[i];
+
+		if (ps_register->page == u8_page && ps_register->address == u8_register)
+		{
+			/* Cached registers beyond the cache size are left volatile, see regmap_init */
+			if ((ps_register->flags & REGMAP_CACHED) && slot < REGMAP_CACHE_SIZE)
+				*pu8_slot = slot;
+			return ps_register;
+		}
+
+		if (ps_register->flags & REGMAP_CACHED)
+			slot++;
+	}
+
+	return &s_regmapDefault;
+}
+
+bool regmapIsPageRegister(regmap_struct_t* ps_regmap, u8 u8_register)
+{
+	return ps_regmap->ps_map->paged && u8_register == ps_regmap->ps_map->pageRegister;
+}
+
+bool regmapUpdateCache(regmap_struct_t* ps_regmap, u8 u8_register, u8 u8_value)
+{
+	u8 slot;
+
+	/* The page select goes back to 0 on reset and is only unknown after a failed transfer */
+	if (regmapIsPageRegister(ps_regmap, u8_register))
+	{
+		if (ps_regmap->pageKnown && ps_regmap->page == u8_value)
+			return FALSE;
+
+		ps_regmap->page = u8_value;
+		ps_regmap->pageKnown = TRUE;
+		return TRUE;
+	}
+
+	regmapFind(ps_regmap, ps_regmap->page, u8_register, &slot);
+	if (slot == REGMAP_NO_SLOT)
+		return TRUE;
+
+	if ((ps_regmap->cacheValid & (1 << slot)) && ps_regmap->au8_cache[slot] == u8_value)
+		return FALSE;
+
+	ps_regmap->au8_cache[slot] = u8_value;
+	ps_regmap->cacheValid |= (1 << slot);
+
+	return TRUE;
+}
+
+i2cBus_status_enum_t regmapRun(regmap_struct_t* ps_regmap, i2cBus_transaction_struct_t* ps_transaction)
+{
+	i2cBus_transfer(ps_transaction);
+
+	return regmap_endFrame(ps_regmap, ps_transaction);
+}
+
+/************************************************************************/
+/* Exported functions                                                   */
+/************************************************************************/
+
+bool regmap_init(regmap_struct_t* ps_regmap, regmap_map_struct_t const * ps_map, u8 u8_address, u32 u32_maxFrequency)
+{
+	u8 i;
+	u8 cached = 0;
+
+	/* Standard mode for the devices without a speed profile */
+	i2cBus_init(I2CBUS_MIN_FREQUENCY);
+	i2cBus_initSpeed(&ps_regmap->s_busSpeed, u32_maxFrequency);
+
+	ps_regmap->ps_map = ps_map;
+	ps_regmap->address = u8_address;
+	ps_regmap->transactions = 0;
+	ps_regmap->bytes = 0;
+	regmap_invalidate(ps_regmap);
+
+	for (i = 0; i < ps_map->registerCount; i++)
+		if (ps_map->as_registers[i].flags & REGMAP_CACHED)
+			cached++;
+
+	return cached <= REGMAP_CACHE_SIZE;
+}
+
+void regmap_beginFrame(regmap_struct_t* ps_regmap, i2cBus_transaction_struct_t* ps_transaction)
+{
+	i2cBus_begin(ps_transaction, ps_regmap->address, &ps_regmap->s_busSpeed);
+
+	/* The device may be on any page after a failed transfer, the one the driver selected leads the frame */
+	if (ps_regmap->ps_map->paged && !ps_regmap->pageKnown)
+	{
+		ps_regmap->au8_pageSelect[0] = ps_regmap->ps_map->pageRegister;
+		ps_regmap->au8_pageSelect[1] = ps_regmap->page;
+		i2cBus_addWrite(ps_transaction, ps_regmap->au8_pageSelect, 2);
+		ps_regmap->pageKnown = TRUE;
+	}
+}
+
+i2cBus_status_enum_t regmap_endFrame(regmap_struct_t* ps_regmap, i2cBus_transaction_struct_t* ps_transaction)
+{
+	u8 i, j;
+
+	ps_regmap->transactions++;
+	ps_regmap->bytes += i2cBus_getFrameBytes(ps_transaction);
+
+	if (ps_transaction->e_status == I2CBUS_DONE)
+		return I2CBUS_DONE;
+
+	/* A device which doesn't answer reads as the idle bus */
+	for (i = 0; i < ps_transaction->segmentCount; i++)
+		if (ps_transaction->as_segments[i].flags & I2CBUS_SEGMENT_READ)
+			for (j = 0; j < ps_transaction->as_segments[i].length; j++)
+				ps_transaction->as_segments[i].pu8_data[j] = 0xFF;
+
+	/* Any part of the frame may have been applied. The page is kept as the one to select again. */
+	ps_regmap->cacheValid = 0;
+	ps_regmap->pageKnown = FALSE;
+
+	return ps_transaction->e_status;
+}
+
+void regmap_invalidate(regmap_struct_t* ps_regmap)
+{
+	ps_regmap->page = 0;
+	ps_regmap->pageKnown = TRUE;
+	ps_regmap->cacheValid = 0;
+}
+
+u32 regmap_read(regmap_struct_t* ps_regmap, u8 u8_register)
+{
+	i2cBus_transaction_struct_t s_transaction;
+	regmap_register_struct_t const * ps_register;
+	u8 au8_value[4];
+	u8 slot;
+	u8 i;
+	u32 value = 0;
+
+	if (regmapIsPageRegister(ps_regmap, u8_register))
+		return ps_regmap->page;
+
+	ps_register = regmapFind(ps_regmap, ps_regmap->page, u8_register, &slot);
+	if (slot != REGMAP_NO_SLOT && (ps_regmap->cacheValid & (1 << slot)))
+		return ps_regmap->au8_cache[slot];
+
+	regmap_beginFrame(ps_regmap, &s_transaction);
+	i2cBus_addWrite(&s_transaction, &u8_register, 1);
+	i2cBus_addRead(&s_transaction, au8_value, ps_register->width);
+	/* The filler of a failed read isn't cached */
+	if (regmapRun(ps_regmap, &s_transaction) != I2CBUS_DONE)
+		slot = REGMAP_NO_SLOT;
+
+	for (i = 0; i < ps_register->width; i++)
+	{
+		if (ps_register->flags & REGMAP_LITTLE_ENDIAN)
+			value |= (u32)au8_value[i] << (8 * i);
+		else
+			value = (value << 8) | au8_value[i];
+	}
+
+	if (slot != REGMAP_NO_SLOT)
+	{
+		ps_regmap->au8_cache[slot] = value;
+		ps_regmap->cacheValid |= (1 << slot);
+	}
+
+	return value;
+}
+
+void regmap_write(regmap_struct_t* ps_regmap, u8 u8_register, u32 u32_value)
+{
+	i2cBus_transaction_struct_t s_transaction;
+	regmap_register_struct_t const * ps_register;
+	u8 au8_buffer[5];
+	u8 slot;
+	u8 i;
+
+	ps_register = regmapIsPageRegister(ps_regmap, u8_register) ? &s_regmapDefault : regmapFind(ps_regmap, ps_regmap->page, u8_register, &slot);
+
+	if (ps_register->width == 1 && !regmapUpdateCache(ps_regmap, u8_register, u32_value))
+		return;
+
+	au8_buffer[0] = u8_register;
+	for (i = 0; i < ps_register->width; i++)
+	{
+		if (ps_register->flags & REGMAP_LITTLE_ENDIAN)
+			au8_buffer[1 + i] = u32_value >> (8 * i);
+		else
+			au8_buffer[ps_register->width - i] = u32_value >> (8 * i);
+	}
+
+	regmap_beginFrame(ps_regmap, &s_transaction);
+	i2cBus_addWrite(&s_transaction, au8_buffer, 1 + ps_register->width);
+	regmapRun(ps_regmap, &s_transaction);
+}
+
+bool regmap_getCached(regmap_struct_t* ps_regmap, u8 u8_page, u8 u8_register, u8* pu8_value)
+{
+	u8 slot;
+
+	if (regmapIsPageRegister(ps_regmap, u8_register))
+	{
+		*pu8_value = ps_regmap->page;
+		return ps_regmap->pageKnown;
+	}
+
+	regmapFind(ps_regmap, u8_page, u8_register, &slot);
+	if (slot == REGMAP_NO_SLOT || !(ps_regmap->cacheValid & (1 << slot)))
+		return FALSE;
+
+	*pu8_value = ps_regmap->au8_cache[slot];
+
+	return TRUE;
+}
+
+void regmap_writeSequence(regmap_struct_t* ps_regmap, u8 const (*au8_writes)[2], u8 u8_count)
+{
+	i2cBus_transaction_struct_t s_transaction;
+	u8 i;
+
+	/* Each register write is its own message, chained with repeated starts */
+	regmap_beginFrame(ps_regmap, &s_transaction);
+	for (i = 0; i < u8_count; i++)
+	{
+		if (!regmapUpdateCache(ps_regmap, au8_writes[i][0], au8_writes[i][1]))
+			continue;
+
+		if (s_transaction.segmentCount == I2CBUS_MAX_SEGMENTS)
+		{
+			regmapRun(ps_regmap, &s_transaction);
+			regmap_beginFrame(ps_regmap, &s_transaction);
+		}
+		i2cBus_addWrite(&s_transaction, au8_writes[i], 2);
+	}
+
+	if (s_transaction.segmentCount != 0)
+		regmapRun(ps_regmap, &s_transaction);
+}
+
+void regmap_readBlock(regmap_struct_t* ps_regmap, u8 u8_register, u8* pu8_data, u8 u8_length)
+{
+	i2cBus_transaction_struct_t s_transaction;
+
+	regmap_beginFrame(ps_regmap, &s_transaction);
+	i2cBus_addWrite(&s_transaction, &u8_register, 1);
+	i2cBus_addRead(&s_transaction, pu8_data, u8_length);
+	regmapRun(ps_regmap, &s_transaction);
+}
+
+void regmap_writeBlock(regmap_struct_t* ps_regmap, u8 u8_register, u8 const * pu8_data, u8 u8_length)
+{
+	i2cBus_transaction_struct_t s_transaction;
+
+	/* The register index leads the data in the same message. Written buffers are only read from. */
+	regmap_beginFrame(ps_regmap, &s_transaction);
+	i2cBus_addWrite(&s_transaction, &u8_register, 1);
+	i2cBus_appendData(&s_transaction, (u8*)pu8_data, u8_length);
+	regmapRun(ps_regmap, &s_transaction);
+}
+
+void regmap_readBlockThenWrite(regmap_struct_t* ps_regmap, u8 u8_register, u8* pu8_data, u8 u8_length, u8 u8_writeRegister, u8 u8_value)
+{
+	i2cBus_transaction_struct_t s_transaction;
+	u8 au8_write[2] = { u8_writeRegister, u8_value };
+
+	regmap_beginFrame(ps_regmap, &s_transaction);
+	i2cBus_addWrite(&s_transaction, &u8_register, 1);
+	i2cBus_addRead(&s_transaction, pu8_data, u8_length);
+	if (regmapUpdateCache(ps_regmap, u8_writeRegister, u8_value))
+		i2cBus_addWrite(&s_transaction, au8_write, 2);
+	regmapRun(ps_regmap, &s_transaction);
+}
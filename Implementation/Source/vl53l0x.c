@@ -7,16 +7,21 @@
 /* AVR includes                                                         */
 /************************************************************************/
 
+#include <stddef.h>
 #include <stdint.h>
+#include <util/atomic.h>
 #include <util/delay.h>
 
 /************************************************************************/
 /* Project specific includes                                            */
 /************************************************************************/
 
-#include "i2c.h"
 #include "vl53l0x.h"
 
+#ifdef VL53L0X_STATISTICS
+	#include "debug.h"
+#endif
+
 /************************************************************************/
 /* Internal defines, enums, structs, types                              */
 /************************************************************************/
@@ -93,182 +98,317 @@ typedef struct sequenceStepTimeouts_t
 	u32 msrc_dss_tcc_us,    pre_range_us,    final_range_us;
 }sequenceStepTimeouts_t;
 
-typedef enum vcselPeriodType_enum_t
+typedef struct modeSettings_struct_t
 {
-	VcselPeriodPreRange, VcselPeriodFinalRange
-}vcselPeriodType_enum_t;
+	u16 signalRateLimit;		/* Q9.7 MCPS */
+	u8 preRangeVcselPeriod;		/* PCLKs */
+	u8 finalRangeVcselPeriod;	/* PCLKs */
+	u8 msrcTimeout;				/* MSRC_CONFIG_TIMEOUT_MACROP value */
+	u16 preRangeTimeout;		/* Encoded PRE_RANGE_CONFIG_TIMEOUT_MACROP_HI value */
+	u16 finalRangeTimeout;		/* Encoded FINAL_RANGE_CONFIG_TIMEOUT_MACROP_HI value */
+	u32 timingBudget;			/* Microseconds */
+}modeSettings_struct_t;
+
+#ifndef VL53L0X_STATISTICS
+	#define countMeasurementStart(ps_sensor)		((void)0)
+	#define countPoll(ps_sensor, b_ready)			((void)0)
+	#define countTimeout(ps_sensor)					((void)0)
+#endif
 
 /************************************************************************/
 /* Internal variables                                                   */
 /************************************************************************/
 
-i2c_struct_t s_i2cInterface;
 volatile u32 u32_milliseconds = 0;
 
+/* Settings of each vl53l0x_mode_enum_t, in enum order. The timeouts are precomputed with the formulas of vl53l0x_setVcselPulsePeriod() and vl53l0x_setTimingBudget(), starting from the step timeouts left by the tuning settings of vl53l0x_start(): sequence config 0xE8, MSRC 0x25 and pre-range 0x0096 at 14 PCLKs, final range at 10 PCLKs. */
+const modeSettings_struct_t as_modeSettings[] =
+{
+	/* VL53L0X_DEFAULT */		{ 32, 14, 10, 0x25, 0x0096, 0x01F4,  30000 },
+	/* VL53L0X_MAX_ACCURACY */	{ 32, 14, 10, 0x25, 0x0096, 0x059A, 200000 },
+	/* VL53L0X_MAX_RANGE */		{ 12, 18, 14, 0x1D, 0x0075, 0x01CE,  33000 },
+	/* VL53L0X_MAX_SPEED */		{ 32, 14, 10, 0x25, 0x0096, 0x00E3,  20000 }
+};
+
+/* Default tuning settings written by vl53l0x_start(), as register and value pairs */
+const u8 au8_tuningSettings[][2] =
+{
+	{ 0xFF, 0x01 },
+	{ 0x00, 0x00 },
+
+	{ 0xFF, 0x00 },
+	{ 0x09, 0x00 },
+	{ 0x10, 0x00 },
+	{ 0x11, 0x00 },
+
+	{ 0x24, 0x01 },
+	{ 0x25, 0xFF },
+	{ 0x75, 0x00 },
+
+	{ 0xFF, 0x01 },
+	{ 0x4E, 0x2C },
+	{ 0x48, 0x00 },
+	{ 0x30, 0x20 },
+
+	{ 0xFF, 0x00 },
+	{ 0x30, 0x09 },
+	{ 0x54, 0x00 },
+	{ 0x31, 0x04 },
+	{ 0x32, 0x03 },
+	{ 0x40, 0x83 },
+	{ 0x46, 0x25 },
+	{ 0x60, 0x00 },
+	{ 0x27, 0x00 },
+	{ 0x50, 0x06 },
+	{ 0x51, 0x00 },
+	{ 0x52, 0x96 },
+	{ 0x56, 0x08 },
+	{ 0x57, 0x30 },
+	{ 0x61, 0x00 },
+	{ 0x62, 0x00 },
+	{ 0x64, 0x00 },
+	{ 0x65, 0x00 },
+	{ 0x66, 0xA0 },
+
+	{ 0xFF, 0x01 },
+	{ 0x22, 0x32 },
+	{ 0x47, 0x14 },
+	{ 0x49, 0xFF },
+	{ 0x4A, 0x00 },
+
+	{ 0xFF, 0x00 },
+	{ 0x7A, 0x0A },
+	{ 0x7B, 0x00 },
+	{ 0x78, 0x21 },
+
+	{ 0xFF, 0x01 },
+	{ 0x23, 0x34 },
+	{ 0x42, 0x00 },
+	{ 0x44, 0xFF },
+	{ 0x45, 0x26 },
+	{ 0x46, 0x05 },
+	{ 0x40, 0x40 },
+	{ 0x0E, 0x06 },
+	{ 0x20, 0x1A },
+	{ 0x43, 0x40 },
+
+	{ 0xFF, 0x00 },
+	{ 0x34, 0x03 },
+	{ 0x35, 0x44 },
+
+	{ 0xFF, 0x01 },
+	{ 0x31, 0x04 },
+	{ 0x4B, 0x09 },
+	{ 0x4C, 0x05 },
+	{ 0x4D, 0x04 },
+
+	{ 0xFF, 0x00 },
+	{ 0x44, 0x00 },
+	{ 0x45, 0x20 },
+	{ 0x47, 0x08 },
+	{ 0x48, 0x28 },
+	{ 0x67, 0x00 },
+	{ 0x70, 0x04 },
+	{ 0x71, 0x01 },
+	{ 0x72, 0xFE },
+	{ 0x76, 0x00 },
+	{ 0x77, 0x00 },
+
+	{ 0xFF, 0x01 },
+	{ 0x0D, 0x01 },
+
+	{ 0xFF, 0x00 },
+	{ 0x80, 0x01 },
+	{ 0x01, 0xF8 },
+
+	{ 0xFF, 0x01 },
+	{ 0x8E, 0x01 },
+	{ 0x00, 0x01 },
+	{ 0xFF, 0x00 },
+	{ 0x80, 0x00 }
+};
+
+/* Registers read by vl53l0x_requestRange: interrupt status, then range */
+const u8 au8_asyncRegisters[2] = { RESULT_INTERRUPT_STATUS, RESULT_RANGE_STATUS + 10 };
+/* Interrupt clear written once vl53l0x_requestRange found a sample */
+const u8 au8_asyncInterruptClear[2] = { SYSTEM_INTERRUPT_CLEAR, 0x01 };
+
+/* Registers which aren't 8 bit and volatile. Apart from the page select, the cached ones are only changed by the driver and cached on the page they are used on. */
+const regmap_register_struct_t as_vl53l0xRegisters[] =
+{
+	{ 0x00, POWER_MANAGEMENT_GO1_POWER_FORCE, 1, REGMAP_CACHED },
+	{ 0x00, SYSTEM_SEQUENCE_CONFIG, 1, REGMAP_CACHED },
+	{ 0x00, SYSTEM_INTERRUPT_CONFIG_GPIO, 1, REGMAP_CACHED },
+	{ 0x00, GPIO_HV_MUX_ACTIVE_HIGH, 1, REGMAP_CACHED },
+	{ 0x01, 0x00, 1, REGMAP_CACHED },	/* Internal access */
+	{ 0x01, 0x91, 1, REGMAP_CACHED },	/* Stop variable */
+	{ 0x00, SYSTEM_INTERMEASUREMENT_PERIOD, 4, 0 },
+	{ 0x00, SYSTEM_THRESH_HIGH, 2, 0 },
+	{ 0x00, SYSTEM_THRESH_LOW, 2, 0 },
+	{ 0x00, CROSSTALK_COMPENSATION_PEAK_RATE_MCPS, 2, 0 },
+	{ 0x00, ALGO_PART_TO_PART_RANGE_OFFSET_MM, 2, 0 },
+	{ 0x00, FINAL_RANGE_CONFIG_MIN_COUNT_RATE_RTN_LIMIT, 2, 0 },
+	{ 0x00, PRE_RANGE_CONFIG_TIMEOUT_MACROP_HI, 2, 0 },
+	{ 0x00, FINAL_RANGE_CONFIG_TIMEOUT_MACROP_HI, 2, 0 },
+	{ 0x00, OSC_CALIBRATE_VAL, 2, 0 }
+};
+
+const regmap_map_struct_t s_vl53l0xMap = { as_vl53l0xRegisters, sizeof(as_vl53l0xRegisters) / sizeof(as_vl53l0xRegisters[0]), TRUE, 0xFF };
+
 /************************************************************************/
 /* Internal functions                                                   */
 /************************************************************************/
 
-void startTimeout(vl53l0x_struct_t* ps_sensor)
+#ifdef VL53L0X_STATISTICS
+void countMeasurementStart(vl53l0x_struct_t* ps_sensor)
 {
-	ps_sensor->timeoutStart = u32_milliseconds;
+	ps_sensor->s_statistics.lastPoll = vl53l0x_getMilliseconds();
 }
 
-bool checkTimeoutExpired(vl53l0x_struct_t* ps_sensor)
+void countPoll(vl53l0x_struct_t* ps_sensor, bool b_ready)
 {
-	return ps_sensor->i2cTimeout > 0 && ((u32_milliseconds - ps_sensor->timeoutStart) > ps_sensor->i2cTimeout);
-}
+	u32 now = vl53l0x_getMilliseconds();
+	u32 latency = now - ps_sensor->s_statistics.lastPoll;
+	u8 bin = 0;
 
-u8 decodeVcselPeriod(u8 reg_val)
-{
-	return ((reg_val) + 1) << 1;
-}
+	ps_sensor->s_statistics.lastPoll = now;
 
-u8 encodeVcselPeriod(u8 period_pclks)
-{
-	return ((period_pclks) >> 1) - 1;
+	if (!b_ready)
+	{
+		ps_sensor->s_statistics.emptyPolls++;
+		return;
+	}
+
+	/* Bin n holds latencies up to 2^n - 1 ms */
+	while (latency != 0 && bin < VL53L0X_LATENCY_BINS - 1)
+	{
+		latency >>= 1;
+		bin++;
+	}
+
+	if (ps_sensor->s_statistics.au16_latency[bin] != 0xFFFF)
+		ps_sensor->s_statistics.au16_latency[bin]++;
+	ps_sensor->s_statistics.samples++;
 }
 
-u32 calcMacroPeriod(u8 vcsel_period_pclks)
+void countTimeout(vl53l0x_struct_t* ps_sensor)
 {
-	/* PLL_period_ps = 1655; macro_period_vclks = 2304 */
-	return (((u32) 2304 * (vcsel_period_pclks) * 1655) + 500) / 1000;
+	ps_sensor->s_statistics.timeouts++;
 }
 
-void writeReg(vl53l0x_struct_t* ps_sensor, u8 reg, u8 value)
+void printCounter(char* pc8_name, u32 u32_value)
 {
-	i2c_sendStart( (ps_sensor->address << 1) | I2C_WRITE );
-	i2c_write(reg);
-	i2c_write(value);
-	i2c_sendStop();
+	debug_writeString(pc8_name);
+
+	/* The debug interface only writes 16 bit decimals */
+	if (u32_value > 0xFFFF)
+	{
+		debug_writeString("0x");
+		debug_writeHexDWord(u32_value);
+	}
+	else
+		debug_writeDecimal(u32_value);
+
+	debug_writeNewLine();
 }
+#endif
 
-void writeReg16Bit(vl53l0x_struct_t* ps_sensor, u8 reg, u16 value)
+void startTimeout(vl53l0x_struct_t* ps_sensor)
 {
-	i2c_sendStart( (ps_sensor->address << 1) | I2C_WRITE );
-	i2c_write(reg);
-	i2c_write((value >> 8) & 0xFF);
-	i2c_write((value     ) & 0xFF);
-	i2c_sendStop();
+	ps_sensor->timeoutStart = u32_milliseconds;
 }
 
-void writeReg32Bit(vl53l0x_struct_t* ps_sensor, u8 reg, u32 value)
+bool checkTimeoutExpired(vl53l0x_struct_t* ps_sensor)
 {
-	i2c_sendStart( (ps_sensor->address << 1) | I2C_WRITE );
-	i2c_write(reg);
-	i2c_write((value >>24) & 0xFF);
-	i2c_write((value >>16) & 0xFF);
-	i2c_write((value >> 8) & 0xFF);
-	i2c_write((value     ) & 0xFF);
-	i2c_sendStop();
+	bool expired = ps_sensor->i2cTimeout > 0 && ((u32_milliseconds - ps_sensor->timeoutStart) > ps_sensor->i2cTimeout);
+
+	if (expired)
+		countTimeout(ps_sensor);
+
+	return expired;
 }
 
-u8 readReg(vl53l0x_struct_t* ps_sensor, u8 reg)
+u8 decodeVcselPeriod(u8 reg_val)
 {
-	u8 value;
-	i2c_sendStart( (ps_sensor->address << 1) | I2C_WRITE );
-	i2c_write( reg );
-	i2c_sendRepStart( (ps_sensor->address << 1) | I2C_READ );
-	value = i2c_readNak();
-	i2c_sendStop();
-	return value;
+	return ((reg_val) + 1) << 1;
 }
 
-u16 readReg16Bit(vl53l0x_struct_t* ps_sensor, u8 reg)
+u8 encodeVcselPeriod(u8 period_pclks)
 {
-	u16 value;
-	i2c_sendStart( (ps_sensor->address << 1) | I2C_WRITE );
-	i2c_write( reg );
-	i2c_sendRepStart( (ps_sensor->address << 1) | I2C_READ );
-	value  = i2c_readAck() << 8;
-	value |= i2c_readNak();
-	i2c_sendStop();
-	return value;
+	return ((period_pclks) >> 1) - 1;
 }
 
-u32 readReg32Bit(vl53l0x_struct_t* ps_sensor, u8 reg)
+u32 calcMacroPeriod(u8 vcsel_period_pclks)
 {
-	u32 value;
-	i2c_sendStart( (ps_sensor->address << 1) | I2C_WRITE );
-	i2c_write( reg );
-	i2c_sendRepStart( (ps_sensor->address << 1) | I2C_READ );
-	value  = (u32)i2c_readAck() <<24;
-	value |= (u32)i2c_readAck() <<16;
-	value |= (u32)i2c_readAck() << 8;
-	value |= i2c_readNak();
-	i2c_sendStop();
-	return value;
+	/* PLL_period_ps = 1655; macro_period_vclks = 2304 */
+	return (((u32) 2304 * (vcsel_period_pclks) * 1655) + 500) / 1000;
 }
 
-void writeMulti(vl53l0x_struct_t* ps_sensor, u8 reg, u8 const *src, u8 count)
+void loadStopVariable(vl53l0x_struct_t* ps_sensor)
 {
-	i2c_sendStart( (ps_sensor->address << 1) | I2C_WRITE );
-	i2c_write( reg );
-	while ( count-- > 0 )
-		i2c_write( *src++ );
+	/* The stop variable stays in place until the sensor is reset or ranging is stopped, so the sequence is only needed once */
+	u8 stopVariable;
 
-	i2c_sendStop();
-}
+	if (regmap_getCached(&ps_sensor->s_regmap, 0x01, 0x91, &stopVariable) && stopVariable == ps_sensor->stopVariable)
+		return;
 
-void readMulti(vl53l0x_struct_t* ps_sensor, u8 reg, u8 * dst, u8 count)
-{
-	i2c_sendStart( (ps_sensor->address << 1) | I2C_WRITE );
-	i2c_write( reg );
-	i2c_sendRepStart( (ps_sensor->address << 1) | I2C_READ );
-	while ( count > 0 )
+	u8 au8_writes[][2] =
 	{
-		if ( count > 1 )
-			*dst++ = i2c_readAck();
-		else
-			*dst++ = i2c_readNak();
-		count--;
-	}
-	i2c_sendStop();
+		{ 0x80, 0x01 },
+		{ 0xFF, 0x01 },
+		{ 0x00, 0x00 },
+		{ 0x91, ps_sensor->stopVariable },
+		{ 0x00, 0x01 },
+		{ 0xFF, 0x00 },
+		{ 0x80, 0x00 }
+	};
+
+	regmap_writeSequence(&ps_sensor->s_regmap, au8_writes, sizeof(au8_writes) / sizeof(au8_writes[0]));
 }
 
 bool getSpadInfo(vl53l0x_struct_t* ps_sensor, u8 * count, bool * type_is_aperture)
 {
 	u8 tmp;
 
-	writeReg(ps_sensor, 0x80, 0x01);
-	writeReg(ps_sensor, 0xFF, 0x01);
-	writeReg(ps_sensor, 0x00, 0x00);
+	regmap_write(&ps_sensor->s_regmap, 0x80, 0x01);
+	regmap_write(&ps_sensor->s_regmap, 0xFF, 0x01);
+	regmap_write(&ps_sensor->s_regmap, 0x00, 0x00);
 
-	writeReg(ps_sensor, 0xFF, 0x06);
-	writeReg(ps_sensor, 0x83, readReg(ps_sensor, 0x83) | 0x04);
-	writeReg(ps_sensor, 0xFF, 0x07);
-	writeReg(ps_sensor, 0x81, 0x01);
+	regmap_write(&ps_sensor->s_regmap, 0xFF, 0x06);
+	regmap_write(&ps_sensor->s_regmap, 0x83, regmap_read(&ps_sensor->s_regmap, 0x83) | 0x04);
+	regmap_write(&ps_sensor->s_regmap, 0xFF, 0x07);
+	regmap_write(&ps_sensor->s_regmap, 0x81, 0x01);
 
-	writeReg(ps_sensor, 0x80, 0x01);
+	regmap_write(&ps_sensor->s_regmap, 0x80, 0x01);
 
-	writeReg(ps_sensor, 0x94, 0x6b);
-	writeReg(ps_sensor, 0x83, 0x00);
+	regmap_write(&ps_sensor->s_regmap, 0x94, 0x6b);
+	regmap_write(&ps_sensor->s_regmap, 0x83, 0x00);
 	startTimeout(ps_sensor);
-	while (readReg(ps_sensor, 0x83) == 0x00)
+	while (regmap_read(&ps_sensor->s_regmap, 0x83) == 0x00)
 	{
 		if (checkTimeoutExpired(ps_sensor)) { return FALSE; }
 	}
-	writeReg(ps_sensor, 0x83, 0x01);
-	tmp = readReg(ps_sensor, 0x92);
+	regmap_write(&ps_sensor->s_regmap, 0x83, 0x01);
+	tmp = regmap_read(&ps_sensor->s_regmap, 0x92);
 
 	*count = tmp & 0x7f;
 	*type_is_aperture = (tmp >> 7) & 0x01;
 
-	writeReg(ps_sensor, 0x81, 0x00);
-	writeReg(ps_sensor, 0xFF, 0x06);
-	writeReg(ps_sensor, 0x83, readReg(ps_sensor, 0x83)  & ~0x04);
-	writeReg(ps_sensor, 0xFF, 0x01);
-	writeReg(ps_sensor, 0x00, 0x01);
+	regmap_write(&ps_sensor->s_regmap, 0x81, 0x00);
+	regmap_write(&ps_sensor->s_regmap, 0xFF, 0x06);
+	regmap_write(&ps_sensor->s_regmap, 0x83, regmap_read(&ps_sensor->s_regmap, 0x83)  & ~0x04);
+	regmap_write(&ps_sensor->s_regmap, 0xFF, 0x01);
+	regmap_write(&ps_sensor->s_regmap, 0x00, 0x01);
 
-	writeReg(ps_sensor, 0xFF, 0x00);
-	writeReg(ps_sensor, 0x80, 0x00);
+	regmap_write(&ps_sensor->s_regmap, 0xFF, 0x00);
+	regmap_write(&ps_sensor->s_regmap, 0x80, 0x00);
 
 	return TRUE;
 }
 
 void getSequenceStepEnables(vl53l0x_struct_t* ps_sensor, sequenceStepEnables_t* enables)
 {
-	u8 sequence_config = readReg(ps_sensor, SYSTEM_SEQUENCE_CONFIG);
+	u8 sequence_config = regmap_read(&ps_sensor->s_regmap, SYSTEM_SEQUENCE_CONFIG);
 
 	enables->tcc          = (sequence_config >> 4) & 0x1;
 	enables->dss          = (sequence_config >> 3) & 0x1;
@@ -313,35 +453,35 @@ u32 timeoutMclksToMicroseconds(u16 timeout_period_mclks, u8 vcsel_period_pclks)
 	return ((timeout_period_mclks * macro_period_ns) + (macro_period_ns / 2)) / 1000;
 }
 
-u8 getVcselPulsePeriod(vl53l0x_struct_t* ps_sensor, vcselPeriodType_enum_t e_vcselPeriodType)
+u8 getVcselPulsePeriod(vl53l0x_struct_t* ps_sensor, vl53l0x_vcselPeriod_enum_t e_vcselPeriodType)
 {
-	if (e_vcselPeriodType == VcselPeriodPreRange)
-		return decodeVcselPeriod(readReg(ps_sensor, PRE_RANGE_CONFIG_VCSEL_PERIOD));
-	else if (e_vcselPeriodType == VcselPeriodFinalRange)
-		return decodeVcselPeriod(readReg(ps_sensor, FINAL_RANGE_CONFIG_VCSEL_PERIOD));
+	if (e_vcselPeriodType == VL53L0X_VCSEL_PRE_RANGE)
+		return decodeVcselPeriod(regmap_read(&ps_sensor->s_regmap, PRE_RANGE_CONFIG_VCSEL_PERIOD));
+	else if (e_vcselPeriodType == VL53L0X_VCSEL_FINAL_RANGE)
+		return decodeVcselPeriod(regmap_read(&ps_sensor->s_regmap, FINAL_RANGE_CONFIG_VCSEL_PERIOD));
 	else
 		return 0xff;
 }
 
 void getSequenceStepTimeouts(vl53l0x_struct_t* ps_sensor, sequenceStepEnables_t const * enables, sequenceStepTimeouts_t * timeouts)
 {
-	timeouts->pre_range_vcsel_period_pclks = getVcselPulsePeriod(ps_sensor, VcselPeriodPreRange);
+	timeouts->pre_range_vcsel_period_pclks = getVcselPulsePeriod(ps_sensor, VL53L0X_VCSEL_PRE_RANGE);
 
-	timeouts->msrc_dss_tcc_mclks = readReg(ps_sensor, MSRC_CONFIG_TIMEOUT_MACROP) + 1;
+	timeouts->msrc_dss_tcc_mclks = regmap_read(&ps_sensor->s_regmap, MSRC_CONFIG_TIMEOUT_MACROP) + 1;
 	timeouts->msrc_dss_tcc_us =
 	timeoutMclksToMicroseconds(timeouts->msrc_dss_tcc_mclks,
 	timeouts->pre_range_vcsel_period_pclks);
 
 	timeouts->pre_range_mclks =
-	decodeTimeout(readReg16Bit(ps_sensor, PRE_RANGE_CONFIG_TIMEOUT_MACROP_HI));
+	decodeTimeout(regmap_read(&ps_sensor->s_regmap, PRE_RANGE_CONFIG_TIMEOUT_MACROP_HI));
 	timeouts->pre_range_us =
 	timeoutMclksToMicroseconds(timeouts->pre_range_mclks,
 	timeouts->pre_range_vcsel_period_pclks);
 
-	timeouts->final_range_vcsel_period_pclks = getVcselPulsePeriod(ps_sensor, VcselPeriodFinalRange);
+	timeouts->final_range_vcsel_period_pclks = getVcselPulsePeriod(ps_sensor, VL53L0X_VCSEL_FINAL_RANGE);
 
 	timeouts->final_range_mclks =
-	decodeTimeout(readReg16Bit(ps_sensor, FINAL_RANGE_CONFIG_TIMEOUT_MACROP_HI));
+	decodeTimeout(regmap_read(&ps_sensor->s_regmap, FINAL_RANGE_CONFIG_TIMEOUT_MACROP_HI));
 
 	if (enables->pre_range)
 	timeouts->final_range_mclks -= timeouts->pre_range_mclks;
@@ -360,147 +500,225 @@ u32 timeoutMicrosecondsToMclks(u32 timeout_period_us, u8 vcsel_period_pclks)
 
 bool performSingleRefCalibration(vl53l0x_struct_t* ps_sensor, u8 vhv_init_byte)
 {
-	writeReg(ps_sensor, SYSRANGE_START, 0x01 | vhv_init_byte);
+	regmap_write(&ps_sensor->s_regmap, SYSRANGE_START, 0x01 | vhv_init_byte);
 
 	startTimeout(ps_sensor);
-	while ((readReg(ps_sensor, RESULT_INTERRUPT_STATUS) & 0x07) == 0)
+	while ((regmap_read(&ps_sensor->s_regmap, RESULT_INTERRUPT_STATUS) & 0x07) == 0)
 	if (checkTimeoutExpired(ps_sensor))
 	return FALSE;
 
-	writeReg(ps_sensor, SYSTEM_INTERRUPT_CLEAR, 0x01);
-	writeReg(ps_sensor, SYSRANGE_START, 0x00);
+	regmap_write(&ps_sensor->s_regmap, SYSTEM_INTERRUPT_CLEAR, 0x01);
+	regmap_write(&ps_sensor->s_regmap, SYSRANGE_START, 0x00);
 
 	return TRUE;
 }
 
-bool setVcselPulsePeriod(vl53l0x_struct_t* ps_sensor, vcselPeriodType_enum_t e_vcselPeriodType, u8 period_pclks)
+bool setPreRangePhaseLimits(vl53l0x_struct_t* ps_sensor, u8 period_pclks)
 {
-	u8 vcsel_period_reg = encodeVcselPeriod(period_pclks);
-
-	sequenceStepEnables_t enables;
-	sequenceStepTimeouts_t timeouts;
+	u8 phaseHigh;
 
-	getSequenceStepEnables(ps_sensor, &enables);
-	getSequenceStepTimeouts(ps_sensor, &enables, &timeouts);
-
-	/* Apply specific settings for the requested clock period. Re-calculate and apply timeouts, in macro periods */
-	/* When the VCSEL period for the pre or final range is changed, the corresponding timeout must be read from the device using the current VCSEL period, then the new VCSEL period can be applied. The timeout then must be written back to the device using the new VCSEL period. For the MSRC timeout, the same applies - this timeout being dependent on the pre-range vcsel period. */
-	if (e_vcselPeriodType == VcselPeriodPreRange)
+	switch (period_pclks)
 	{
-		/* Set phase check limits */
-		switch (period_pclks)
-		{
-			case 12:
-			writeReg(ps_sensor, PRE_RANGE_CONFIG_VALID_PHASE_HIGH, 0x18);
+		case 12:
+			phaseHigh = 0x18;
 			break;
 
-			case 14:
-			writeReg(ps_sensor, PRE_RANGE_CONFIG_VALID_PHASE_HIGH, 0x30);
+		case 14:
+			phaseHigh = 0x30;
 			break;
 
-			case 16:
-			writeReg(ps_sensor, PRE_RANGE_CONFIG_VALID_PHASE_HIGH, 0x40);
+		case 16:
+			phaseHigh = 0x40;
 			break;
 
-			case 18:
-			writeReg(ps_sensor, PRE_RANGE_CONFIG_VALID_PHASE_HIGH, 0x50);
+		case 18:
+			phaseHigh = 0x50;
 			break;
 
-			default:
+		default:
 			return FALSE;
-		}
-		writeReg(ps_sensor, PRE_RANGE_CONFIG_VALID_PHASE_LOW, 0x08);
+	}
 
-		/* Apply new VCSEL period */
-		writeReg(ps_sensor, PRE_RANGE_CONFIG_VCSEL_PERIOD, vcsel_period_reg);
+	regmap_write(&ps_sensor->s_regmap, PRE_RANGE_CONFIG_VALID_PHASE_HIGH, phaseHigh);
+	regmap_write(&ps_sensor->s_regmap, PRE_RANGE_CONFIG_VALID_PHASE_LOW, 0x08);
 
-		/* Update timeouts */
-		u16 new_pre_range_timeout_mclks = timeoutMicrosecondsToMclks(timeouts.pre_range_us, period_pclks);
-		writeReg16Bit(ps_sensor, PRE_RANGE_CONFIG_TIMEOUT_MACROP_HI, encodeTimeout(new_pre_range_timeout_mclks));
-		u16 new_msrc_timeout_mclks = timeoutMicrosecondsToMclks(timeouts.msrc_dss_tcc_us, period_pclks);
-		writeReg(ps_sensor, MSRC_CONFIG_TIMEOUT_MACROP, (new_msrc_timeout_mclks > 256) ? 255 : (new_msrc_timeout_mclks - 1));
-	}
-	else if (e_vcselPeriodType == VcselPeriodFinalRange)
+	return TRUE;
+}
+
+bool setFinalRangePhaseLimits(vl53l0x_struct_t* ps_sensor, u8 period_pclks)
+{
+	u8 phaseHigh, vcselWidth, phasecalTimeout, phasecalLimit;
+
+	switch (period_pclks)
 	{
-		switch (period_pclks)
-		{
-			case 8:
-			writeReg(ps_sensor, FINAL_RANGE_CONFIG_VALID_PHASE_HIGH, 0x10);
-			writeReg(ps_sensor, FINAL_RANGE_CONFIG_VALID_PHASE_LOW,  0x08);
-			writeReg(ps_sensor, GLOBAL_CONFIG_VCSEL_WIDTH, 0x02);
-			writeReg(ps_sensor, ALGO_PHASECAL_CONFIG_TIMEOUT, 0x0C);
-			writeReg(ps_sensor, 0xFF, 0x01);
-			writeReg(ps_sensor, ALGO_PHASECAL_LIM, 0x30);
-			writeReg(ps_sensor, 0xFF, 0x00);
+		case 8:
+			phaseHigh = 0x10;
+			vcselWidth = 0x02;
+			phasecalTimeout = 0x0C;
+			phasecalLimit = 0x30;
 			break;
 
-			case 10:
-			writeReg(ps_sensor, FINAL_RANGE_CONFIG_VALID_PHASE_HIGH, 0x28);
-			writeReg(ps_sensor, FINAL_RANGE_CONFIG_VALID_PHASE_LOW,  0x08);
-			writeReg(ps_sensor, GLOBAL_CONFIG_VCSEL_WIDTH, 0x03);
-			writeReg(ps_sensor, ALGO_PHASECAL_CONFIG_TIMEOUT, 0x09);
-			writeReg(ps_sensor, 0xFF, 0x01);
-			writeReg(ps_sensor, ALGO_PHASECAL_LIM, 0x20);
-			writeReg(ps_sensor, 0xFF, 0x00);
+		case 10:
+			phaseHigh = 0x28;
+			vcselWidth = 0x03;
+			phasecalTimeout = 0x09;
+			phasecalLimit = 0x20;
 			break;
 
-			case 12:
-			writeReg(ps_sensor, FINAL_RANGE_CONFIG_VALID_PHASE_HIGH, 0x38);
-			writeReg(ps_sensor, FINAL_RANGE_CONFIG_VALID_PHASE_LOW,  0x08);
-			writeReg(ps_sensor, GLOBAL_CONFIG_VCSEL_WIDTH, 0x03);
-			writeReg(ps_sensor, ALGO_PHASECAL_CONFIG_TIMEOUT, 0x08);
-			writeReg(ps_sensor, 0xFF, 0x01);
-			writeReg(ps_sensor, ALGO_PHASECAL_LIM, 0x20);
-			writeReg(ps_sensor, 0xFF, 0x00);
+		case 12:
+			phaseHigh = 0x38;
+			vcselWidth = 0x03;
+			phasecalTimeout = 0x08;
+			phasecalLimit = 0x20;
 			break;
 
-			case 14:
-			writeReg(ps_sensor, FINAL_RANGE_CONFIG_VALID_PHASE_HIGH, 0x48);
-			writeReg(ps_sensor, FINAL_RANGE_CONFIG_VALID_PHASE_LOW,  0x08);
-			writeReg(ps_sensor, GLOBAL_CONFIG_VCSEL_WIDTH, 0x03);
-			writeReg(ps_sensor, ALGO_PHASECAL_CONFIG_TIMEOUT, 0x07);
-			writeReg(ps_sensor, 0xFF, 0x01);
-			writeReg(ps_sensor, ALGO_PHASECAL_LIM, 0x20);
-			writeReg(ps_sensor, 0xFF, 0x00);
+		case 14:
+			phaseHigh = 0x48;
+			vcselWidth = 0x03;
+			phasecalTimeout = 0x07;
+			phasecalLimit = 0x20;
 			break;
 
-			default:
+		default:
 			return FALSE;
-		}
+	}
 
-		/* Apply new VCSEL period */
-		writeReg(ps_sensor, FINAL_RANGE_CONFIG_VCSEL_PERIOD, vcsel_period_reg);
+	regmap_write(&ps_sensor->s_regmap, FINAL_RANGE_CONFIG_VALID_PHASE_HIGH, phaseHigh);
+	regmap_write(&ps_sensor->s_regmap, FINAL_RANGE_CONFIG_VALID_PHASE_LOW,  0x08);
+	regmap_write(&ps_sensor->s_regmap, GLOBAL_CONFIG_VCSEL_WIDTH, vcselWidth);
+	regmap_write(&ps_sensor->s_regmap, ALGO_PHASECAL_CONFIG_TIMEOUT, phasecalTimeout);
+	regmap_write(&ps_sensor->s_regmap, 0xFF, 0x01);
+	regmap_write(&ps_sensor->s_regmap, ALGO_PHASECAL_LIM, phasecalLimit);
+	regmap_write(&ps_sensor->s_regmap, 0xFF, 0x00);
 
-		/* For the final range timeout, the pre-range timeout must be added. To do this both final and pre-range timeouts must be expressed in macro periods MClks because they have different vcsel periods. */
-		u16 new_final_range_timeout_mclks = timeoutMicrosecondsToMclks(timeouts.final_range_us, period_pclks);
+	return TRUE;
+}
 
-		if (enables.pre_range)
-		new_final_range_timeout_mclks += timeouts.pre_range_mclks;
+void haltRanging(vl53l0x_struct_t* ps_sensor)
+{
+	u8 au8_writes[][2] =
+	{
+		{ SYSRANGE_START, 0x01 },
+		{ 0xFF, 0x01 },
+		{ 0x00, 0x00 },
+		{ 0x91, 0x00 },
+		{ 0x00, 0x01 },
+		{ 0xFF, 0x00 }
+	};
+
+	regmap_writeSequence(&ps_sensor->s_regmap, au8_writes, sizeof(au8_writes) / sizeof(au8_writes[0]));
+}
+
+void applyCalibration(vl53l0x_struct_t* ps_sensor)
+{
+	/* The offset register is 12 bit two's complement */
+	regmap_write(&ps_sensor->s_regmap, ALGO_PART_TO_PART_RANGE_OFFSET_MM, (u16)ps_sensor->s_calibration.offset & 0x0FFF);
+	regmap_write(&ps_sensor->s_regmap, CROSSTALK_COMPENSATION_PEAK_RATE_MCPS, ps_sensor->s_calibration.crosstalk);
+}
+
+bool averageSamples(vl53l0x_struct_t* ps_sensor, u8 u8_samples, vl53l0x_sample_struct_t* ps_average)
+{
+	u8 i;
+	u8 valid = 0;
+	u32 range = 0;
+	u32 signalRate = 0;
+	u32 spadCount = 0;
+	vl53l0x_sample_struct_t s_sample;
+
+	for (i = 0; i < u8_samples; i++)
+	{
+		vl53l0x_startSingle(ps_sensor);
+		startTimeout(ps_sensor);
+		while (!vl53l0x_readSample(ps_sensor, &s_sample))
+		{
+			if (checkTimeoutExpired(ps_sensor))
+			{
+				ps_sensor->timedOut = TRUE;
+				return FALSE;
+			}
+		}
 
-		writeReg16Bit(ps_sensor, FINAL_RANGE_CONFIG_TIMEOUT_MACROP_HI, encodeTimeout(new_final_range_timeout_mclks));
+		if (s_sample.rangeStatus != VL53L0X_RANGE_STATUS_VALID)
+			continue;
+
+		range += s_sample.range;
+		signalRate += s_sample.signalRate;
+		spadCount += s_sample.effectiveSpadCount;
+		valid++;
 	}
-	else
-	return FALSE;
 
-	/* Perform the phase calibration. This is needed after changing on VCSEL period. */
-	u8 sequence_config = readReg(ps_sensor, SYSTEM_SEQUENCE_CONFIG);
-	writeReg(ps_sensor, SYSTEM_SEQUENCE_CONFIG, 0x02);
-	performSingleRefCalibration(ps_sensor, 0x0);
-	writeReg(ps_sensor, SYSTEM_SEQUENCE_CONFIG, sequence_config);
+	if (valid == 0)
+		return FALSE;
+
+	ps_average->rangeStatus = VL53L0X_RANGE_STATUS_VALID;
+	ps_average->range = (range + valid / 2) / valid;
+	ps_average->signalRate = (signalRate + valid / 2) / valid;
+	ps_average->effectiveSpadCount = (spadCount + valid / 2) / valid;
 
 	return TRUE;
 }
 
-bool setSignalRateLimit(vl53l0x_struct_t* ps_sensor, float f_limit)
+bool performPhaseCalibration(vl53l0x_struct_t* ps_sensor)
 {
-	if (f_limit < 0 || f_limit > 511.99) { return FALSE; }
+	bool result;
+	u8 sequenceConfig;
 
-	/* Q9.7 fixed point format (9 integer bits, 7 fractional bits) */
-	writeReg16Bit(ps_sensor, FINAL_RANGE_CONFIG_MIN_COUNT_RATE_RTN_LIMIT, f_limit * (1 << 7));
-	return TRUE;
+	/* The phase calibration is needed after changing a VCSEL period. It must run with only the phase calibration step enabled, then the steps chosen before are enabled again. The register is cached, so saving it costs no transfer. */
+	sequenceConfig = regmap_read(&ps_sensor->s_regmap, SYSTEM_SEQUENCE_CONFIG);
+	regmap_write(&ps_sensor->s_regmap, SYSTEM_SEQUENCE_CONFIG, 0x02);
+	result = performSingleRefCalibration(ps_sensor, 0x0);
+	regmap_write(&ps_sensor->s_regmap, SYSTEM_SEQUENCE_CONFIG, sequenceConfig);
+
+	return result;
+}
+
+void asyncFinish(vl53l0x_struct_t* ps_sensor, u16 u16_range)
+{
+	ps_sensor->asyncPending = FALSE;
+	ps_sensor->f_rangeCallback(ps_sensor, u16_range);
 }
 
-bool setMeasurementTimingBudget(vl53l0x_struct_t* ps_sensor, u32 u32_budget)
+void asyncCleared(i2cBus_transaction_struct_t* ps_transaction)
+{
+	vl53l0x_struct_t* ps_sensor = ps_transaction->p_context;
+
+	/* A sample whose interrupt is still set comes again with the next request */
+	if (regmap_endFrame(&ps_sensor->s_regmap, ps_transaction) != I2CBUS_DONE)
+		asyncFinish(ps_sensor, 0xFFFF);
+	else
+		asyncFinish(ps_sensor, ((u16)ps_sensor->au8_asyncData[1] << 8) | ps_sensor->au8_asyncData[2]);
+}
+
+void asyncPolled(i2cBus_transaction_struct_t* ps_transaction)
+{
+	vl53l0x_struct_t* ps_sensor = ps_transaction->p_context;
+
+	if (regmap_endFrame(&ps_sensor->s_regmap, ps_transaction) != I2CBUS_DONE || (ps_sensor->au8_asyncData[0] & 0x07) == 0)
+	{
+		countPoll(ps_sensor, FALSE);
+		asyncFinish(ps_sensor, 0xFFFF);
+		return;
+	}
+	countPoll(ps_sensor, TRUE);
+
+	/* The frame is done, so it can carry the interrupt clear */
+	regmap_beginFrame(&ps_sensor->s_regmap, ps_transaction);
+	i2cBus_addWrite(ps_transaction, au8_asyncInterruptClear, 2);
+	ps_transaction->f_callback = asyncCleared;
+	ps_transaction->p_context = ps_sensor;
+	i2cBus_submit(ps_transaction);
+}
+
+/************************************************************************/
+/* Exported functions                                                   */
+/************************************************************************/
+
+void vl53l0x_setSignalRateLimit(vl53l0x_struct_t* ps_sensor, u16 u16_limit)
+{
+	regmap_write(&ps_sensor->s_regmap, FINAL_RANGE_CONFIG_MIN_COUNT_RATE_RTN_LIMIT, u16_limit);
+}
+
+bool vl53l0x_setTimingBudget(vl53l0x_struct_t* ps_sensor, u32 u32_budget)
 {
 	sequenceStepEnables_t enables;
 	sequenceStepTimeouts_t timeouts;
@@ -549,24 +767,83 @@ bool setMeasurementTimingBudget(vl53l0x_struct_t* ps_sensor, u32 u32_budget)
 		if (enables.pre_range)
 		final_range_timeout_mclks += timeouts.pre_range_mclks;
 
-		writeReg16Bit(ps_sensor, FINAL_RANGE_CONFIG_TIMEOUT_MACROP_HI,
+		regmap_write(&ps_sensor->s_regmap, FINAL_RANGE_CONFIG_TIMEOUT_MACROP_HI,
 		encodeTimeout(final_range_timeout_mclks));
 	}
+	ps_sensor->timingBudget = u32_budget;
 	return TRUE;
 }
 
-/************************************************************************/
-/* Exported functions                                                   */
-/************************************************************************/
+bool vl53l0x_setVcselPulsePeriod(vl53l0x_struct_t* ps_sensor, vl53l0x_vcselPeriod_enum_t e_vcselPeriodType, u8 u8_period)
+{
+	u8 vcsel_period_reg = encodeVcselPeriod(u8_period);
+
+	sequenceStepEnables_t enables;
+	sequenceStepTimeouts_t timeouts;
+
+	getSequenceStepEnables(ps_sensor, &enables);
+	getSequenceStepTimeouts(ps_sensor, &enables, &timeouts);
+
+	/* When the VCSEL period for the pre or final range is changed, the corresponding timeout must be read from the device using the current VCSEL period, then the new VCSEL period can be applied. The timeout then must be written back to the device using the new VCSEL period. For the MSRC timeout, the same applies - this timeout being dependent on the pre-range vcsel period. */
+	if (e_vcselPeriodType == VL53L0X_VCSEL_PRE_RANGE)
+	{
+		if (!setPreRangePhaseLimits(ps_sensor, u8_period))
+			return FALSE;
+
+		regmap_write(&ps_sensor->s_regmap, PRE_RANGE_CONFIG_VCSEL_PERIOD, vcsel_period_reg);
+
+		u16 new_pre_range_timeout_mclks = timeoutMicrosecondsToMclks(timeouts.pre_range_us, u8_period);
+		regmap_write(&ps_sensor->s_regmap, PRE_RANGE_CONFIG_TIMEOUT_MACROP_HI, encodeTimeout(new_pre_range_timeout_mclks));
+		u16 new_msrc_timeout_mclks = timeoutMicrosecondsToMclks(timeouts.msrc_dss_tcc_us, u8_period);
+		regmap_write(&ps_sensor->s_regmap, MSRC_CONFIG_TIMEOUT_MACROP, (new_msrc_timeout_mclks > 256) ? 255 : (new_msrc_timeout_mclks - 1));
+
+		ps_sensor->preRangeVcselPeriod = u8_period;
+	}
+	else if (e_vcselPeriodType == VL53L0X_VCSEL_FINAL_RANGE)
+	{
+		if (!setFinalRangePhaseLimits(ps_sensor, u8_period))
+			return FALSE;
+
+		regmap_write(&ps_sensor->s_regmap, FINAL_RANGE_CONFIG_VCSEL_PERIOD, vcsel_period_reg);
+
+		/* For the final range timeout, the pre-range timeout must be added. To do this both final and pre-range timeouts must be expressed in macro periods MClks because they have different vcsel periods. */
+		u16 new_final_range_timeout_mclks = timeoutMicrosecondsToMclks(timeouts.final_range_us, u8_period);
+
+		if (enables.pre_range)
+			new_final_range_timeout_mclks += timeouts.pre_range_mclks;
+
+		regmap_write(&ps_sensor->s_regmap, FINAL_RANGE_CONFIG_TIMEOUT_MACROP_HI, encodeTimeout(new_final_range_timeout_mclks));
+
+		ps_sensor->finalRangeVcselPeriod = u8_period;
+	}
+	else
+		return FALSE;
+
+	/* The step timeouts changed with the period, so the final range timeout must be recomputed to keep the timing budget */
+	if (ps_sensor->timingBudget != 0 && !vl53l0x_setTimingBudget(ps_sensor, ps_sensor->timingBudget))
+		return FALSE;
+
+	return performPhaseCalibration(ps_sensor);
+}
 
 void vl53l0x_init(vl53l0x_struct_t* ps_sensor)
 {
-	s_i2cInterface.frequency = 400000;
-	i2c_init(s_i2cInterface);
-	i2c_start();
+	regmap_init(&ps_sensor->s_regmap, &s_vl53l0xMap, ps_sensor->address, VL53L0X_I2C_FREQUENCY);
 
 	ps_sensor->i2cTimeout = 0;
 	ps_sensor->timedOut = FALSE;
+	ps_sensor->timingBudget = 0;
+	regmap_invalidate(&ps_sensor->s_regmap);
+	ps_sensor->preRangeVcselPeriod = 0;
+	ps_sensor->finalRangeVcselPeriod = 0;
+	ps_sensor->s_calibration.valid = FALSE;
+	ps_sensor->rangingPeriod = 0;
+	ps_sensor->continuous = FALSE;
+	ps_sensor->standby = FALSE;
+	ps_sensor->asyncPending = FALSE;
+#ifdef VL53L0X_STATISTICS
+	vl53l0x_resetStatistics(ps_sensor);
+#endif
 
 	gpio_init(ps_sensor->xshutPin);
 	gpio_setDirectionOutput(&ps_sensor->xshutPin);
@@ -577,27 +854,32 @@ bool vl53l0x_start(vl53l0x_struct_t* ps_sensor)
 {
 	gpio_out_set(ps_sensor->xshutPin);
 	_delay_ms(2);
+	ps_sensor->s_regmap.address = ps_sensor->address;
+	i2cBus_initSpeed(&ps_sensor->s_regmap.s_busSpeed, ps_sensor->s_regmap.s_busSpeed.maxFrequency);
+	regmap_invalidate(&ps_sensor->s_regmap);
+	ps_sensor->continuous = FALSE;
+	ps_sensor->standby = FALSE;
 
-	writeReg(ps_sensor, VHV_CONFIG_PAD_SCL_SDA__EXTSUP_HV, readReg(ps_sensor, VHV_CONFIG_PAD_SCL_SDA__EXTSUP_HV) | 0x01);
+	regmap_write(&ps_sensor->s_regmap, VHV_CONFIG_PAD_SCL_SDA__EXTSUP_HV, regmap_read(&ps_sensor->s_regmap, VHV_CONFIG_PAD_SCL_SDA__EXTSUP_HV) | 0x01);
 
 	/* Set I2C standard mode */
-	writeReg(ps_sensor, 0x88, 0x00);
+	regmap_write(&ps_sensor->s_regmap, 0x88, 0x00);
 
-	writeReg(ps_sensor, 0x80, 0x01);
-	writeReg(ps_sensor, 0xFF, 0x01);
-	writeReg(ps_sensor, 0x00, 0x00);
-	ps_sensor->stopVariable = readReg(ps_sensor, 0x91);
-	writeReg(ps_sensor, 0x00, 0x01);
-	writeReg(ps_sensor, 0xFF, 0x00);
-	writeReg(ps_sensor, 0x80, 0x00);
+	regmap_write(&ps_sensor->s_regmap, 0x80, 0x01);
+	regmap_write(&ps_sensor->s_regmap, 0xFF, 0x01);
+	regmap_write(&ps_sensor->s_regmap, 0x00, 0x00);
+	ps_sensor->stopVariable = regmap_read(&ps_sensor->s_regmap, 0x91);
+	regmap_write(&ps_sensor->s_regmap, 0x00, 0x01);
+	regmap_write(&ps_sensor->s_regmap, 0xFF, 0x00);
+	regmap_write(&ps_sensor->s_regmap, 0x80, 0x00);
 
 	/* Disable SIGNAL_RATE_MSRC (bit 1) and SIGNAL_RATE_PRE_RANGE (bit 4) limit checks */
-	writeReg(ps_sensor, MSRC_CONFIG_CONTROL, readReg(ps_sensor, MSRC_CONFIG_CONTROL) | 0x12);
+	regmap_write(&ps_sensor->s_regmap, MSRC_CONFIG_CONTROL, regmap_read(&ps_sensor->s_regmap, MSRC_CONFIG_CONTROL) | 0x12);
 
 	/* Set final range signal rate limit to 0.25 MCPS (million counts per second) */
-	setSignalRateLimit(ps_sensor, 0.25);
+	vl53l0x_setSignalRateLimit(ps_sensor, as_modeSettings[VL53L0X_DEFAULT].signalRateLimit);
 
-	writeReg(ps_sensor, SYSTEM_SEQUENCE_CONFIG, 0xFF);
+	regmap_write(&ps_sensor->s_regmap, SYSTEM_SEQUENCE_CONFIG, 0xFF);
 
 	u8 spad_count;
 	bool spad_type_is_aperture;
@@ -605,13 +887,13 @@ bool vl53l0x_start(vl53l0x_struct_t* ps_sensor)
 
 	/* Read SPAD map */
 	u8 ref_spad_map[6];
-	readMulti(ps_sensor, GLOBAL_CONFIG_SPAD_ENABLES_REF_0, ref_spad_map, 6);
+	regmap_readBlock(&ps_sensor->s_regmap, GLOBAL_CONFIG_SPAD_ENABLES_REF_0, ref_spad_map, 6);
 
-	writeReg(ps_sensor, 0xFF, 0x01);
-	writeReg(ps_sensor, DYNAMIC_SPAD_REF_EN_START_OFFSET, 0x00);
-	writeReg(ps_sensor, DYNAMIC_SPAD_NUM_REQUESTED_REF_SPAD, 0x2C);
-	writeReg(ps_sensor, 0xFF, 0x00);
-	writeReg(ps_sensor, GLOBAL_CONFIG_REF_EN_START_SELECT, 0xB4);
+	regmap_write(&ps_sensor->s_regmap, 0xFF, 0x01);
+	regmap_write(&ps_sensor->s_regmap, DYNAMIC_SPAD_REF_EN_START_OFFSET, 0x00);
+	regmap_write(&ps_sensor->s_regmap, DYNAMIC_SPAD_NUM_REQUESTED_REF_SPAD, 0x2C);
+	regmap_write(&ps_sensor->s_regmap, 0xFF, 0x00);
+	regmap_write(&ps_sensor->s_regmap, GLOBAL_CONFIG_REF_EN_START_SELECT, 0xB4);
 
 	u8 first_spad_to_enable = spad_type_is_aperture ? 12 : 0;
 	u8 spads_enabled = 0;
@@ -625,122 +907,42 @@ bool vl53l0x_start(vl53l0x_struct_t* ps_sensor)
 			spads_enabled++;
 	}
 
-	writeMulti(ps_sensor, GLOBAL_CONFIG_SPAD_ENABLES_REF_0, ref_spad_map, 6);
+	regmap_writeBlock(&ps_sensor->s_regmap, GLOBAL_CONFIG_SPAD_ENABLES_REF_0, ref_spad_map, 6);
 
 	/* Default tuning settings */
-	writeReg(ps_sensor, 0xFF, 0x01);
-	writeReg(ps_sensor, 0x00, 0x00);
-
-	writeReg(ps_sensor, 0xFF, 0x00);
-	writeReg(ps_sensor, 0x09, 0x00);
-	writeReg(ps_sensor, 0x10, 0x00);
-	writeReg(ps_sensor, 0x11, 0x00);
-
-	writeReg(ps_sensor, 0x24, 0x01);
-	writeReg(ps_sensor, 0x25, 0xFF);
-	writeReg(ps_sensor, 0x75, 0x00);
-
-	writeReg(ps_sensor, 0xFF, 0x01);
-	writeReg(ps_sensor, 0x4E, 0x2C);
-	writeReg(ps_sensor, 0x48, 0x00);
-	writeReg(ps_sensor, 0x30, 0x20);
-
-	writeReg(ps_sensor, 0xFF, 0x00);
-	writeReg(ps_sensor, 0x30, 0x09);
-	writeReg(ps_sensor, 0x54, 0x00);
-	writeReg(ps_sensor, 0x31, 0x04);
-	writeReg(ps_sensor, 0x32, 0x03);
-	writeReg(ps_sensor, 0x40, 0x83);
-	writeReg(ps_sensor, 0x46, 0x25);
-	writeReg(ps_sensor, 0x60, 0x00);
-	writeReg(ps_sensor, 0x27, 0x00);
-	writeReg(ps_sensor, 0x50, 0x06);
-	writeReg(ps_sensor, 0x51, 0x00);
-	writeReg(ps_sensor, 0x52, 0x96);
-	writeReg(ps_sensor, 0x56, 0x08);
-	writeReg(ps_sensor, 0x57, 0x30);
-	writeReg(ps_sensor, 0x61, 0x00);
-	writeReg(ps_sensor, 0x62, 0x00);
-	writeReg(ps_sensor, 0x64, 0x00);
-	writeReg(ps_sensor, 0x65, 0x00);
-	writeReg(ps_sensor, 0x66, 0xA0);
-
-	writeReg(ps_sensor, 0xFF, 0x01);
-	writeReg(ps_sensor, 0x22, 0x32);
-	writeReg(ps_sensor, 0x47, 0x14);
-	writeReg(ps_sensor, 0x49, 0xFF);
-	writeReg(ps_sensor, 0x4A, 0x00);
-
-	writeReg(ps_sensor, 0xFF, 0x00);
-	writeReg(ps_sensor, 0x7A, 0x0A);
-	writeReg(ps_sensor, 0x7B, 0x00);
-	writeReg(ps_sensor, 0x78, 0x21);
-
-	writeReg(ps_sensor, 0xFF, 0x01);
-	writeReg(ps_sensor, 0x23, 0x34);
-	writeReg(ps_sensor, 0x42, 0x00);
-	writeReg(ps_sensor, 0x44, 0xFF);
-	writeReg(ps_sensor, 0x45, 0x26);
-	writeReg(ps_sensor, 0x46, 0x05);
-	writeReg(ps_sensor, 0x40, 0x40);
-	writeReg(ps_sensor, 0x0E, 0x06);
-	writeReg(ps_sensor, 0x20, 0x1A);
-	writeReg(ps_sensor, 0x43, 0x40);
-
-	writeReg(ps_sensor, 0xFF, 0x00);
-	writeReg(ps_sensor, 0x34, 0x03);
-	writeReg(ps_sensor, 0x35, 0x44);
-
-	writeReg(ps_sensor, 0xFF, 0x01);
-	writeReg(ps_sensor, 0x31, 0x04);
-	writeReg(ps_sensor, 0x4B, 0x09);
-	writeReg(ps_sensor, 0x4C, 0x05);
-	writeReg(ps_sensor, 0x4D, 0x04);
-
-	writeReg(ps_sensor, 0xFF, 0x00);
-	writeReg(ps_sensor, 0x44, 0x00);
-	writeReg(ps_sensor, 0x45, 0x20);
-	writeReg(ps_sensor, 0x47, 0x08);
-	writeReg(ps_sensor, 0x48, 0x28);
-	writeReg(ps_sensor, 0x67, 0x00);
-	writeReg(ps_sensor, 0x70, 0x04);
-	writeReg(ps_sensor, 0x71, 0x01);
-	writeReg(ps_sensor, 0x72, 0xFE);
-	writeReg(ps_sensor, 0x76, 0x00);
-	writeReg(ps_sensor, 0x77, 0x00);
-
-	writeReg(ps_sensor, 0xFF, 0x01);
-	writeReg(ps_sensor, 0x0D, 0x01);
-
-	writeReg(ps_sensor, 0xFF, 0x00);
-	writeReg(ps_sensor, 0x80, 0x01);
-	writeReg(ps_sensor, 0x01, 0xF8);
-
-	writeReg(ps_sensor, 0xFF, 0x01);
-	writeReg(ps_sensor, 0x8E, 0x01);
-	writeReg(ps_sensor, 0x00, 0x01);
-	writeReg(ps_sensor, 0xFF, 0x00);
-	writeReg(ps_sensor, 0x80, 0x00);
+	regmap_writeSequence(&ps_sensor->s_regmap, au8_tuningSettings, sizeof(au8_tuningSettings) / sizeof(au8_tuningSettings[0]));
 
 	/* Set interrupt config to new sample ready */
-	writeReg(ps_sensor, SYSTEM_INTERRUPT_CONFIG_GPIO, 0x04);
-	writeReg(ps_sensor, GPIO_HV_MUX_ACTIVE_HIGH, readReg(ps_sensor, GPIO_HV_MUX_ACTIVE_HIGH) & ~0x10); // active low
-	writeReg(ps_sensor, SYSTEM_INTERRUPT_CLEAR, 0x01);
+	regmap_write(&ps_sensor->s_regmap, SYSTEM_INTERRUPT_CONFIG_GPIO, 0x04);
+	regmap_write(&ps_sensor->s_regmap, GPIO_HV_MUX_ACTIVE_HIGH, regmap_read(&ps_sensor->s_regmap, GPIO_HV_MUX_ACTIVE_HIGH) & ~0x10); // active low
+	regmap_write(&ps_sensor->s_regmap, SYSTEM_INTERRUPT_CLEAR, 0x01);
 
 	/* Disable Minimum Signal Rate Check and Target CentreCheck by default */
-	writeReg(ps_sensor, SYSTEM_SEQUENCE_CONFIG, 0xE8);
+	regmap_write(&ps_sensor->s_regmap, SYSTEM_SEQUENCE_CONFIG, 0xE8);
 
 	/* Set default timing budget */
-	setMeasurementTimingBudget(ps_sensor, 30);
+	regmap_write(&ps_sensor->s_regmap, FINAL_RANGE_CONFIG_TIMEOUT_MACROP_HI, as_modeSettings[VL53L0X_DEFAULT].finalRangeTimeout);
+	ps_sensor->timingBudget = as_modeSettings[VL53L0X_DEFAULT].timingBudget;
+	ps_sensor->preRangeVcselPeriod = as_modeSettings[VL53L0X_DEFAULT].preRangeVcselPeriod;
+	ps_sensor->finalRangeVcselPeriod = as_modeSettings[VL53L0X_DEFAULT].finalRangeVcselPeriod;
 
 	/* perform calibrations */
-	writeReg(ps_sensor, SYSTEM_SEQUENCE_CONFIG, 0x01);
+	regmap_write(&ps_sensor->s_regmap, SYSTEM_SEQUENCE_CONFIG, 0x01);
 	if (!performSingleRefCalibration(ps_sensor, 0x40)) { return FALSE; }
-	writeReg(ps_sensor, SYSTEM_SEQUENCE_CONFIG, 0x02);
+	regmap_write(&ps_sensor->s_regmap, SYSTEM_SEQUENCE_CONFIG, 0x02);
 	if (!performSingleRefCalibration(ps_sensor, 0x00)) { return FALSE; }
 
 	/* Restore the previous Sequence Config */
-	writeReg(ps_sensor, SYSTEM_SEQUENCE_CONFIG, 0xE8);
+	regmap_write(&ps_sensor->s_regmap, SYSTEM_SEQUENCE_CONFIG, 0xE8);
+
+	/* Keep the factory offset unless a calibration replaces it */
+	if (ps_sensor->s_calibration.valid)
+		applyCalibration(ps_sensor);
+	else
+	{
+		ps_sensor->s_calibration.offset = ((s16)(regmap_read(&ps_sensor->s_regmap, ALGO_PART_TO_PART_RANGE_OFFSET_MM) << 4)) >> 4;
+		ps_sensor->s_calibration.crosstalk = 0;
+	}
 	
 	return TRUE;
 }
@@ -748,177 +950,305 @@ bool vl53l0x_start(vl53l0x_struct_t* ps_sensor)
 void vl53l0x_stop(vl53l0x_struct_t* ps_sensor)
 {
 	gpio_out_reset(ps_sensor->xshutPin);
+	regmap_invalidate(&ps_sensor->s_regmap);
+	ps_sensor->continuous = FALSE;
+	ps_sensor->standby = FALSE;
+}
+
+void vl53l0x_standby(vl53l0x_struct_t* ps_sensor)
+{
+	if (ps_sensor->standby)
+		return;
+
+	if (ps_sensor->continuous)
+		haltRanging(ps_sensor);
+
+	/* Drop a sample finished before the stop, so the first one after resuming is fresh */
+	regmap_write(&ps_sensor->s_regmap, SYSTEM_INTERRUPT_CLEAR, 0x01);
+	ps_sensor->standby = TRUE;
+}
+
+void vl53l0x_resume(vl53l0x_struct_t* ps_sensor)
+{
+	if (!ps_sensor->standby)
+		return;
+
+	ps_sensor->standby = FALSE;
+	if (ps_sensor->continuous)
+		vl53l0x_startContinuous(ps_sensor, ps_sensor->rangingPeriod);
 }
 
 void vl53l0x_setAddress(vl53l0x_struct_t* ps_sensor, u8 u8_address)
 {
-	writeReg(ps_sensor, I2C_SLAVE_DEVICE_ADDRESS, u8_address & 0x7F );
+	regmap_write(&ps_sensor->s_regmap, I2C_SLAVE_DEVICE_ADDRESS, u8_address & 0x7F );
 	ps_sensor->address = u8_address;
+	ps_sensor->s_regmap.address = u8_address;
 }
 
 bool vl53l0x_setMode(vl53l0x_struct_t* ps_sensor, vl53l0x_mode_enum_t e_mode)
 {
-	bool result = FALSE;
+	modeSettings_struct_t const * ps_settings;
+	bool vcselChanged;
+
+	if (e_mode > VL53L0X_MAX_SPEED)
+		return FALSE;
+
+	ps_settings = &as_modeSettings[e_mode];
+	vcselChanged = (ps_sensor->preRangeVcselPeriod != ps_settings->preRangeVcselPeriod) || (ps_sensor->finalRangeVcselPeriod != ps_settings->finalRangeVcselPeriod);
+
+	vl53l0x_setSignalRateLimit(ps_sensor, ps_settings->signalRateLimit);
 
-	switch (e_mode)
+	if (vcselChanged)
 	{
-		case VL53L0X_DEFAULT:
-			result = setSignalRateLimit(ps_sensor, 0.25);
-			if (result == TRUE)
-			{
-				/* Not working! */
-				/*result = vl53l0x_setVcselPulsePeriod(ps_sensor, VcselPeriodPreRange, 14);
-				if (result == TRUE)
-				{
-					result = vl53l0x_setVcselPulsePeriod(ps_sensor, VcselPeriodFinalRange, 10);
-					if (result == TRUE)
-					{*/
-						result = setMeasurementTimingBudget(ps_sensor, 30 * 1000UL);
-				/*	}
-				}*/
-			}
-			break;
-		case VL53L0X_MAX_ACCURACY:
-			result = setSignalRateLimit(ps_sensor, 0.25);
-			if (result == TRUE)
-			{
-				/* Not working! */
-				/*result = vl53l0x_setVcselPulsePeriod(ps_sensor, VcselPeriodPreRange, 14);
-				if (result == TRUE)
-				{
-					result = vl53l0x_setVcselPulsePeriod(ps_sensor, VcselPeriodFinalRange, 10);
-					if (result == TRUE)
-					{*/
-						result = setMeasurementTimingBudget(ps_sensor, 200 * 1000UL);
-				/*	}
-				}*/
-			}
-			break;
-		case VL53L0X_MAX_RANGE:
-			result = setSignalRateLimit(ps_sensor, 0.1);
-			if (result == TRUE)
-			{
-				/* Not working! */
-				/*result = vl53l0x_setVcselPulsePeriod(ps_sensor, VcselPeriodPreRange, 18);
-				if (result == TRUE)
-				{
-					result = vl53l0x_setVcselPulsePeriod(ps_sensor, VcselPeriodFinalRange, 14);
-					if (result == TRUE)
-					{*/
-						result = setMeasurementTimingBudget(ps_sensor, 33 * 1000UL);
-				/*	}
-				}*/
-			}
-			break;
-		case VL53L0X_MAX_SPEED:
-			result = setSignalRateLimit(ps_sensor, 0.25);
-			if (result == TRUE)
-			{
-				/* Not working! */
-				/*result = vl53l0x_setVcselPulsePeriod(ps_sensor, VcselPeriodPreRange, 14);
-				if (result == TRUE)
-				{
-					result = vl53l0x_setVcselPulsePeriod(ps_sensor, VcselPeriodFinalRange, 10);
-					if (result == TRUE)
-					{*/
-						result = setMeasurementTimingBudget(ps_sensor, 20 * 1000UL);
-				/*	}
-				}*/
-			}
-			break;
+		setPreRangePhaseLimits(ps_sensor, ps_settings->preRangeVcselPeriod);
+		regmap_write(&ps_sensor->s_regmap, PRE_RANGE_CONFIG_VCSEL_PERIOD, encodeVcselPeriod(ps_settings->preRangeVcselPeriod));
+		regmap_write(&ps_sensor->s_regmap, PRE_RANGE_CONFIG_TIMEOUT_MACROP_HI, ps_settings->preRangeTimeout);
+		regmap_write(&ps_sensor->s_regmap, MSRC_CONFIG_TIMEOUT_MACROP, ps_settings->msrcTimeout);
+
+		setFinalRangePhaseLimits(ps_sensor, ps_settings->finalRangeVcselPeriod);
+		regmap_write(&ps_sensor->s_regmap, FINAL_RANGE_CONFIG_VCSEL_PERIOD, encodeVcselPeriod(ps_settings->finalRangeVcselPeriod));
 	}
 
-	return result;
+	regmap_write(&ps_sensor->s_regmap, FINAL_RANGE_CONFIG_TIMEOUT_MACROP_HI, ps_settings->finalRangeTimeout);
+	ps_sensor->timingBudget = ps_settings->timingBudget;
+	ps_sensor->preRangeVcselPeriod = ps_settings->preRangeVcselPeriod;
+	ps_sensor->finalRangeVcselPeriod = ps_settings->finalRangeVcselPeriod;
+
+	if (vcselChanged)
+		return performPhaseCalibration(ps_sensor);
+
+	return TRUE;
+}
+
+bool vl53l0x_setInterruptMode(vl53l0x_struct_t* ps_sensor, vl53l0x_interrupt_enum_t e_mode, u16 u16_lowThreshold, u16 u16_highThreshold)
+{
+	if (e_mode > VL53L0X_INTERRUPT_NEW_SAMPLE)
+		return FALSE;
+
+	if (u16_lowThreshold > VL53L0X_THRESHOLD_MAX || u16_highThreshold > VL53L0X_THRESHOLD_MAX)
+		return FALSE;
+
+	if (e_mode == VL53L0X_INTERRUPT_OUT_OF_WINDOW && u16_lowThreshold > u16_highThreshold)
+		return FALSE;
+
+	/* Thresholds are 12 bit values in units of 2mm */
+	regmap_write(&ps_sensor->s_regmap, SYSTEM_THRESH_LOW, (u16_lowThreshold >> 1) & 0x0FFF);
+	regmap_write(&ps_sensor->s_regmap, SYSTEM_THRESH_HIGH, (u16_highThreshold >> 1) & 0x0FFF);
+	regmap_write(&ps_sensor->s_regmap, SYSTEM_INTERRUPT_CONFIG_GPIO, e_mode);
+	regmap_write(&ps_sensor->s_regmap, SYSTEM_INTERRUPT_CLEAR, 0x01);
+
+	return TRUE;
 }
 
 void vl53l0x_startContinuous(vl53l0x_struct_t* ps_sensor, u32 u32_rangingPeriod)
 {
-	writeReg(ps_sensor, 0x80, 0x01);
-	writeReg(ps_sensor, 0xFF, 0x01);
-	writeReg(ps_sensor, 0x00, 0x00);
-	writeReg(ps_sensor, 0x91, ps_sensor->stopVariable);
-	writeReg(ps_sensor, 0x00, 0x01);
-	writeReg(ps_sensor, 0xFF, 0x00);
-	writeReg(ps_sensor, 0x80, 0x00);
+	ps_sensor->rangingPeriod = u32_rangingPeriod;
+	ps_sensor->continuous = TRUE;
+	loadStopVariable(ps_sensor);
 
 	if (u32_rangingPeriod != 0)
 	{
 		/* Continuous timed mode */
 
-		u16 osc_calibrate_val = readReg16Bit(ps_sensor, OSC_CALIBRATE_VAL);
+		u16 osc_calibrate_val = regmap_read(&ps_sensor->s_regmap, OSC_CALIBRATE_VAL);
 
 		if (osc_calibrate_val != 0)
 			u32_rangingPeriod *= osc_calibrate_val;
 
-		writeReg32Bit(ps_sensor, SYSTEM_INTERMEASUREMENT_PERIOD, u32_rangingPeriod);
-		writeReg(ps_sensor, SYSRANGE_START, 0x04);
+		regmap_write(&ps_sensor->s_regmap, SYSTEM_INTERMEASUREMENT_PERIOD, u32_rangingPeriod);
+		regmap_write(&ps_sensor->s_regmap, SYSRANGE_START, 0x04);
 	}
 	else
 	{
 		/* Continuous back-to-back mode */
-		writeReg(ps_sensor, SYSRANGE_START, 0x02);
+		regmap_write(&ps_sensor->s_regmap, SYSRANGE_START, 0x02);
 	}
+
+	countMeasurementStart(ps_sensor);
 }
 
 void vl53l0x_stopContinuous(vl53l0x_struct_t* ps_sensor)
 {
-	writeReg(ps_sensor, SYSRANGE_START, 0x01);
-	writeReg(ps_sensor, 0xFF, 0x01);
-	writeReg(ps_sensor, 0x00, 0x00);
-	writeReg(ps_sensor, 0x91, 0x00);
-	writeReg(ps_sensor, 0x00, 0x01);
-	writeReg(ps_sensor, 0xFF, 0x00);
+	haltRanging(ps_sensor);
+	ps_sensor->continuous = FALSE;
 }
 
 u16 vl53l0x_readRangeContinuous(vl53l0x_struct_t* ps_sensor)
 {
+	u8 au8_range[2];
 	u16 temp;
-	if ((readReg(ps_sensor, RESULT_INTERRUPT_STATUS) & 0x07) == 0)
+	if ((regmap_read(&ps_sensor->s_regmap, RESULT_INTERRUPT_STATUS) & 0x07) == 0)
 	{
 		temp = 0xFFFF;
 	}
 	else
 	{
-		temp = readReg16Bit(ps_sensor, RESULT_RANGE_STATUS + 10);
-		writeReg(ps_sensor, SYSTEM_INTERRUPT_CLEAR, 0x01);
+		regmap_readBlockThenWrite(&ps_sensor->s_regmap, RESULT_RANGE_STATUS + 10, au8_range, 2, SYSTEM_INTERRUPT_CLEAR, 0x01);
+		temp = ((u16)au8_range[0] << 8) | au8_range[1];
 	}
 
+	countPoll(ps_sensor, temp != 0xFFFF);
+
 	return temp;
 }
 
+bool vl53l0x_readSample(vl53l0x_struct_t* ps_sensor, vl53l0x_sample_struct_t* ps_sample)
+{
+	u8 au8_result[12];
+
+	if ((regmap_read(&ps_sensor->s_regmap, RESULT_INTERRUPT_STATUS) & 0x07) == 0)
+	{
+		countPoll(ps_sensor, FALSE);
+		return FALSE;
+	}
+
+	regmap_readBlockThenWrite(&ps_sensor->s_regmap, RESULT_RANGE_STATUS, au8_result, 12, SYSTEM_INTERRUPT_CLEAR, 0x01);
+	countPoll(ps_sensor, TRUE);
+
+	ps_sample->rangeStatus = (au8_result[0] & 0x78) >> 3;
+	ps_sample->effectiveSpadCount = ((u16)au8_result[2] << 8) | au8_result[3];
+	ps_sample->signalRate = ((u16)au8_result[6] << 8) | au8_result[7];
+	ps_sample->ambientRate = ((u16)au8_result[8] << 8) | au8_result[9];
+	ps_sample->range = ((u16)au8_result[10] << 8) | au8_result[11];
+
+	return TRUE;
+}
+
+void vl53l0x_startSingle(vl53l0x_struct_t* ps_sensor)
+{
+	loadStopVariable(ps_sensor);
+	regmap_write(&ps_sensor->s_regmap, SYSRANGE_START, 0x01);
+	countMeasurementStart(ps_sensor);
+}
+
+bool vl53l0x_requestRange(vl53l0x_struct_t* ps_sensor, vl53l0x_rangeCallback_t f_callback)
+{
+	i2cBus_transaction_struct_t* ps_transaction = &ps_sensor->s_asyncTransaction;
+
+	if (ps_sensor->asyncPending)
+		return FALSE;
+	ps_sensor->asyncPending = TRUE;
+	ps_sensor->f_rangeCallback = f_callback;
+
+	/* Status and range in one frame, the range is only used if the status says it is new. The registers are on page 0, where the driver leaves the sensor. */
+	regmap_beginFrame(&ps_sensor->s_regmap, ps_transaction);
+	i2cBus_addWrite(ps_transaction, &au8_asyncRegisters[0], 1);
+	i2cBus_addRead(ps_transaction, &ps_sensor->au8_asyncData[0], 1);
+	i2cBus_addWrite(ps_transaction, &au8_asyncRegisters[1], 1);
+	i2cBus_addRead(ps_transaction, &ps_sensor->au8_asyncData[1], 2);
+	ps_transaction->f_callback = asyncPolled;
+	ps_transaction->p_context = ps_sensor;
+	i2cBus_submit(ps_transaction);
+
+	return TRUE;
+}
+
+bool vl53l0x_isRequestPending(vl53l0x_struct_t* ps_sensor)
+{
+	return ps_sensor->asyncPending;
+}
+
 u16 vl53l0x_readRangeSingle(vl53l0x_struct_t* ps_sensor)
 {
-	u16 temp;
+	u8 au8_range[2];
 
-	writeReg(ps_sensor, 0x80, 0x01);
-	writeReg(ps_sensor, 0xFF, 0x01);
-	writeReg(ps_sensor, 0x00, 0x00);
-	writeReg(ps_sensor, 0x91, ps_sensor->stopVariable);
-	writeReg(ps_sensor, 0x00, 0x01);
-	writeReg(ps_sensor, 0xFF, 0x00);
-	writeReg(ps_sensor, 0x80, 0x00);
-	writeReg(ps_sensor, SYSRANGE_START, 0x01);
+	vl53l0x_startSingle(ps_sensor);
 	/*Wait until start bit has been cleared */
 	startTimeout(ps_sensor);
-	while (readReg(ps_sensor, SYSRANGE_START) & 0x01)
+	while (regmap_read(&ps_sensor->s_regmap, SYSRANGE_START) & 0x01)
+	{
+		countPoll(ps_sensor, FALSE);
 		if (checkTimeoutExpired(ps_sensor))
 		{
 			ps_sensor->timedOut = TRUE;
 			return 0xffff;
 		}
+	}
 
 	startTimeout(ps_sensor);
-	while ((readReg(ps_sensor, RESULT_INTERRUPT_STATUS) & 0x07) == 0)
+	while ((regmap_read(&ps_sensor->s_regmap, RESULT_INTERRUPT_STATUS) & 0x07) == 0)
+	{
+		countPoll(ps_sensor, FALSE);
 		if (checkTimeoutExpired(ps_sensor))
 		{
 			ps_sensor->timedOut = TRUE;
 			return 0xffff;
 		}
+	}
+	countPoll(ps_sensor, TRUE);
 
-	temp = readReg16Bit(ps_sensor, RESULT_RANGE_STATUS + 10);
-	writeReg(ps_sensor, SYSTEM_INTERRUPT_CLEAR, 0x01);
+	regmap_readBlockThenWrite(&ps_sensor->s_regmap, RESULT_RANGE_STATUS + 10, au8_range, 2, SYSTEM_INTERRUPT_CLEAR, 0x01);
 
-	return temp;
+	return ((u16)au8_range[0] << 8) | au8_range[1];
+}
+
+bool vl53l0x_calibrateOffset(vl53l0x_struct_t* ps_sensor, u16 u16_targetDistance, u8 u8_samples)
+{
+	vl53l0x_sample_struct_t s_average;
+	s32 offset;
+
+	/* Measure without any offset */
+	regmap_write(&ps_sensor->s_regmap, ALGO_PART_TO_PART_RANGE_OFFSET_MM, 0);
+	if (!averageSamples(ps_sensor, u8_samples, &s_average))
+	{
+		applyCalibration(ps_sensor);
+		return FALSE;
+	}
+
+	offset = ((s32)u16_targetDistance - s_average.range) * 4;
+	if (offset < -2048)
+		offset = -2048;
+	else if (offset > 2047)
+		offset = 2047;
+
+	ps_sensor->s_calibration.offset = offset;
+	ps_sensor->s_calibration.valid = TRUE;
+	applyCalibration(ps_sensor);
+
+	return TRUE;
+}
+
+bool vl53l0x_calibrateCrosstalk(vl53l0x_struct_t* ps_sensor, u16 u16_targetDistance, u8 u8_samples)
+{
+	vl53l0x_sample_struct_t s_average;
+	u32 crosstalk = 0;
+
+	/* Measure without compensation */
+	regmap_write(&ps_sensor->s_regmap, CROSSTALK_COMPENSATION_PEAK_RATE_MCPS, 0);
+	if (!averageSamples(ps_sensor, u8_samples, &s_average) || s_average.effectiveSpadCount == 0)
+	{
+		applyCalibration(ps_sensor);
+		return FALSE;
+	}
+
+	/* Crosstalk returns at zero distance and pulls the range towards it in proportion to its share of the signal, so crosstalk per SPAD = signal rate * (1 - range / target) / SPAD count. A Q9.7 rate over a Q8.8 count is scaled by 2^-1, shifting by 14 gives Q3.13. */
+	if (s_average.range < u16_targetDistance)
+	{
+		crosstalk = ((u32)s_average.signalRate * (u16_targetDistance - s_average.range) + u16_targetDistance / 2) / u16_targetDistance;
+		crosstalk = ((crosstalk << 14) + s_average.effectiveSpadCount / 2) / s_average.effectiveSpadCount;
+		if (crosstalk > 0xFFFF)
+			crosstalk = 0xFFFF;
+	}
+
+	ps_sensor->s_calibration.crosstalk = crosstalk;
+	ps_sensor->s_calibration.valid = TRUE;
+	applyCalibration(ps_sensor);
+
+	return TRUE;
+}
+
+vl53l0x_calibration_struct_t const * vl53l0x_getCalibration(vl53l0x_struct_t* ps_sensor)
+{
+	return &ps_sensor->s_calibration;
+}
+
+void vl53l0x_setCalibration(vl53l0x_struct_t* ps_sensor, vl53l0x_calibration_struct_t const * ps_calibration)
+{
+	if (!ps_calibration->valid)
+		return;
+
+	ps_sensor->s_calibration = *ps_calibration;
+	applyCalibration(ps_sensor);
 }
 
 void vl53l0x_incrementTimeoutCounter()
@@ -926,9 +1256,79 @@ void vl53l0x_incrementTimeoutCounter()
 	u32_milliseconds++;
 }
 
+u32 vl53l0x_getMilliseconds()
+{
+	u32 tmp;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		tmp = u32_milliseconds;
+	}
+	return tmp;
+}
+
 bool vl53l0x_timeoutOccurred(vl53l0x_struct_t* ps_sensor)
 {
 	bool tmp = ps_sensor->timedOut;
 	ps_sensor->timedOut = FALSE;
 	return tmp;
 }
+
+#ifdef VL53L0X_STATISTICS
+vl53l0x_statistics_struct_t const * vl53l0x_getStatistics(vl53l0x_struct_t* ps_sensor)
+{
+	/* The register map counts the bus traffic */
+	ps_sensor->s_statistics.transactions = ps_sensor->s_regmap.transactions;
+	ps_sensor->s_statistics.bytes = ps_sensor->s_regmap.bytes;
+
+	return &ps_sensor->s_statistics;
+}
+
+void vl53l0x_resetStatistics(vl53l0x_struct_t* ps_sensor)
+{
+	u8 i;
+
+	ps_sensor->s_statistics.transactions = 0;
+	ps_sensor->s_statistics.bytes = 0;
+	ps_sensor->s_regmap.transactions = 0;
+	ps_sensor->s_regmap.bytes = 0;
+	ps_sensor->s_statistics.emptyPolls = 0;
+	ps_sensor->s_statistics.samples = 0;
+	ps_sensor->s_statistics.timeouts = 0;
+	ps_sensor->s_statistics.lastPoll = vl53l0x_getMilliseconds();
+
+	for (i = 0; i < VL53L0X_LATENCY_BINS; i++)
+		ps_sensor->s_statistics.au16_latency[i] = 0;
+}
+
+void vl53l0x_printStatistics(vl53l0x_struct_t* ps_sensor)
+{
+	u8 i;
+
+	debug_writeString("VL53L0X 0x");
+	debug_writeHex(ps_sensor->address);
+	debug_writeNewLine();
+
+	printCounter("transactions: ", ps_sensor->s_regmap.transactions);
+	printCounter("bytes: ", ps_sensor->s_regmap.bytes);
+	printCounter("empty polls: ", ps_sensor->s_statistics.emptyPolls);
+	printCounter("samples: ", ps_sensor->s_statistics.samples);
+	printCounter("timeouts: ", ps_sensor->s_statistics.timeouts);
+
+	debug_writeString("latency ms: <1");
+	for (i = 1; i < VL53L0X_LATENCY_BINS - 1; i++)
+	{
+		debug_writeString(" <");
+		debug_writeDecimal(1 << i);
+	}
+	debug_writeString(" >=");
+	debug_writeDecimal(1 << (VL53L0X_LATENCY_BINS - 2));
+	debug_writeNewLine();
+
+	for (i = 0; i < VL53L0X_LATENCY_BINS; i++)
+	{
+		debug_writeChar(' ');
+		debug_writeDecimal(ps_sensor->s_statistics.au16_latency[i]);
+	}
+	debug_writeNewLine();
+}
+#endif
@@ -0,0 +1,153 @@
+/**	@file		vl53l0x_adaptive.c
+	@brief		Automatic VL53L0X ranging mode selection
+	@details	See @link vl53l0x_adaptive.h @endlink for details.
+*/
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include "vl53l0x_adaptive.h"
+
+/************************************************************************/
+/* Defines, enums, structs, types                                       */
+/************************************************************************/
+
+/* Weight of a new sample in the running mean and variance, as a power of two */
+#define ADAPTIVE_STATISTICS_SHIFT	3
+
+/************************************************************************/
+/* Internal functions                                                   */
+/************************************************************************/
+
+bool aboveThreshold(vl53l0x_adaptive_struct_t* ps_adaptive, u32 u32_value, u32 u32_threshold, bool b_wasAbove)
+{
+	u32 band = u32_threshold >> ps_adaptive->hysteresisShift;
+
+	/* Once above, the value must fall below the lower edge of the band to count as below again, and the other way round */
+	if (b_wasAbove)
+		return u32_value + band > u32_threshold;
+
+	return u32_value > u32_threshold + band;
+}
+
+vl53l0x_mode_enum_t selectMode(vl53l0x_adaptive_struct_t* ps_adaptive, u16 u16_range)
+{
+	vl53l0x_mode_enum_t e_mode = ps_adaptive->e_mode;
+
+	if (aboveThreshold(ps_adaptive, ps_adaptive->velocity, ps_adaptive->fastVelocity, e_mode == VL53L0X_MAX_SPEED)
+		|| !aboveThreshold(ps_adaptive, u16_range, ps_adaptive->nearRange, e_mode != VL53L0X_MAX_SPEED))
+		return VL53L0X_MAX_SPEED;
+
+	if (aboveThreshold(ps_adaptive, u16_range, ps_adaptive->farRange, e_mode == VL53L0X_MAX_RANGE))
+		return VL53L0X_MAX_RANGE;
+
+	if (aboveThreshold(ps_adaptive, ps_adaptive->variance, ps_adaptive->noisyVariance, e_mode == VL53L0X_MAX_ACCURACY)
+		&& !aboveThreshold(ps_adaptive, ps_adaptive->velocity, ps_adaptive->slowVelocity, e_mode != VL53L0X_MAX_ACCURACY))
+		return VL53L0X_MAX_ACCURACY;
+
+	return VL53L0X_DEFAULT;
+}
+
+bool applyMode(vl53l0x_adaptive_struct_t* ps_adaptive, vl53l0x_mode_enum_t e_mode)
+{
+	bool result;
+
+	/* Timeouts and VCSEL periods must not change in the middle of a measurement */
+	if (ps_adaptive->continuous)
+		vl53l0x_stopContinuous(ps_adaptive->ps_sensor);
+
+	result = vl53l0x_setMode(ps_adaptive->ps_sensor, e_mode);
+
+	if (ps_adaptive->continuous)
+		vl53l0x_startContinuous(ps_adaptive->ps_sensor, ps_adaptive->rangingPeriod);
+
+	if (result)
+	{
+		ps_adaptive->e_mode = e_mode;
+		ps_adaptive->switches++;
+	}
+
+	return result;
+}
+
+/************************************************************************/
+/* Exported functions                                                   */
+/************************************************************************/
+
+bool vl53l0x_adaptive_init(vl53l0x_adaptive_struct_t* ps_adaptive)
+{
+	bool result;
+
+	ps_adaptive->e_mode = VL53L0X_DEFAULT;
+	ps_adaptive->e_candidate = VL53L0X_DEFAULT;
+	ps_adaptive->candidateCount = 0;
+	ps_adaptive->velocity = 0;
+	ps_adaptive->lastRange = 0xFFFF;
+	ps_adaptive->trend = 0;
+	ps_adaptive->variance = 0;
+	ps_adaptive->switches = 0;
+
+	result = vl53l0x_setMode(ps_adaptive->ps_sensor, VL53L0X_DEFAULT);
+
+	if (ps_adaptive->continuous)
+		vl53l0x_startContinuous(ps_adaptive->ps_sensor, ps_adaptive->rangingPeriod);
+
+	return result;
+}
+
+void vl53l0x_adaptive_setVelocity(vl53l0x_adaptive_struct_t* ps_adaptive, s16 s16_velocity)
+{
+	ps_adaptive->velocity = (s16_velocity < 0) ? -s16_velocity : s16_velocity;
+}
+
+bool vl53l0x_adaptive_update(vl53l0x_adaptive_struct_t* ps_adaptive, u16 u16_range)
+{
+	s32 difference;
+	u32 square;
+	vl53l0x_mode_enum_t e_mode;
+
+	if (u16_range == 0xFFFF)
+		return FALSE;
+
+	/* The noise is measured on the change between samples minus its running mean, so approaching a wall doesn't look like noise. Both use shifts only. */
+	if (ps_adaptive->lastRange != 0xFFFF)
+	{
+		difference = ((s32)u16_range - ps_adaptive->lastRange) << 4;
+		ps_adaptive->trend += (difference - ps_adaptive->trend) >> ADAPTIVE_STATISTICS_SHIFT;
+
+		difference = (difference - ps_adaptive->trend) >> 4;
+		/* The change between two samples carries the noise of both */
+		square = (u32)(difference * difference) >> 1;
+		if (square >= ps_adaptive->variance)
+			ps_adaptive->variance += (square - ps_adaptive->variance) >> ADAPTIVE_STATISTICS_SHIFT;
+		else
+			ps_adaptive->variance -= (ps_adaptive->variance - square) >> ADAPTIVE_STATISTICS_SHIFT;
+	}
+	ps_adaptive->lastRange = u16_range;
+
+	e_mode = selectMode(ps_adaptive, u16_range);
+
+	if (e_mode == ps_adaptive->e_mode)
+	{
+		ps_adaptive->candidateCount = 0;
+		return FALSE;
+	}
+
+	/* Speeding up is a safety matter and happens at once, slowing down must be confirmed */
+	if (e_mode != VL53L0X_MAX_SPEED)
+	{
+		if (e_mode != ps_adaptive->e_candidate)
+		{
+			ps_adaptive->e_candidate = e_mode;
+			ps_adaptive->candidateCount = 0;
+		}
+
+		if (++ps_adaptive->candidateCount < ps_adaptive->dwell)
+			return FALSE;
+	}
+
+	ps_adaptive->candidateCount = 0;
+
+	return applyMode(ps_adaptive, e_mode);
+}
@@ -0,0 +1,329 @@
+/**	@file		vl53l0x_array.c
+	@brief		Multiple VL53L0X distance sensors sharing the same I2C bus
+	@details	See @link vl53l0x_array.h @endlink for details.
+*/
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include "vl53l0x_array.h"
+
+/************************************************************************/
+/* Internal functions                                                   */
+/************************************************************************/
+
+bool addressRangeValid(vl53l0x_array_struct_t* ps_array)
+{
+	if (ps_array->sensorCount == 0 || ps_array->sensorCount > VL53L0X_ARRAY_MAX_SENSORS)
+		return FALSE;
+
+	/* Every sensor comes out of reset on the default address, so none of the assigned addresses may be equal to it */
+	if (ps_array->firstAddress <= VL53L0X_ADDRESS_DEFAULT && ps_array->firstAddress + ps_array->sensorCount > VL53L0X_ADDRESS_DEFAULT)
+		return FALSE;
+
+	return (ps_array->firstAddress + ps_array->sensorCount - 1) <= 0x7F;
+}
+
+bool assignSlots(vl53l0x_array_struct_t* ps_array, u8* au8_conflicts, u8 u8_slotCount, u8 u8_sensor)
+{
+	u8 slot;
+	u8 mask = 1 << u8_sensor;
+
+	if (u8_sensor == ps_array->sensorCount)
+		return TRUE;
+
+	if (!(ps_array->activeSensors & mask))
+		return assignSlots(ps_array, au8_conflicts, u8_slotCount, u8_sensor + 1);
+
+	for (slot = 0; slot < u8_slotCount; slot++)
+	{
+		if (ps_array->au8_slots[slot] & au8_conflicts[u8_sensor])
+			continue;
+
+		ps_array->au8_slots[slot] |= mask;
+		if (assignSlots(ps_array, au8_conflicts, u8_slotCount, u8_sensor + 1))
+			return TRUE;
+		ps_array->au8_slots[slot] &= ~mask;
+	}
+
+	return FALSE;
+}
+
+void computeSchedule(vl53l0x_array_struct_t* ps_array)
+{
+	u8 i, j;
+	u8 au8_conflicts[VL53L0X_ARRAY_MAX_SENSORS];
+
+	/* Make the interference graph symmetric */
+	for (i = 0; i < ps_array->sensorCount; i++)
+		au8_conflicts[i] = ps_array->au8_conflicts[i] & ~(1 << i);
+	for (i = 0; i < ps_array->sensorCount; i++)
+		for (j = 0; j < ps_array->sensorCount; j++)
+			if (au8_conflicts[j] & (1 << i))
+				au8_conflicts[i] |= (1 << j);
+
+	/* Find the smallest number of slots covering all the sensors. Exhaustive search is cheap for 8 sensors and always succeeds with one slot per sensor. */
+	for (ps_array->slotCount = 1; ps_array->slotCount < ps_array->sensorCount; ps_array->slotCount++)
+	{
+		for (i = 0; i < VL53L0X_ARRAY_MAX_SENSORS; i++)
+			ps_array->au8_slots[i] = 0;
+
+		if (assignSlots(ps_array, au8_conflicts, ps_array->slotCount, 0))
+			break;
+	}
+	if (ps_array->slotCount == ps_array->sensorCount)
+	{
+		for (i = 0; i < VL53L0X_ARRAY_MAX_SENSORS; i++)
+			ps_array->au8_slots[i] = (i < ps_array->sensorCount) ? ((1 << i) & ps_array->activeSensors) : 0;
+	}
+
+	/* Fill every slot with all the sensors that disturb none of its members */
+	for (i = 0; i < ps_array->slotCount; i++)
+		for (j = 0; j < ps_array->sensorCount; j++)
+			if ((ps_array->activeSensors & (1 << j)) && !(ps_array->au8_slots[i] & au8_conflicts[j]))
+				ps_array->au8_slots[i] |= (1 << j);
+}
+
+u32 slotTimeout(vl53l0x_array_struct_t* ps_array)
+{
+	u8 i;
+	u32 budget = 0;
+
+	for (i = 0; i < ps_array->sensorCount; i++)
+		if ((ps_array->pendingSensors & (1 << i)) && ps_array->ps_sensors[i].timingBudget > budget)
+			budget = ps_array->ps_sensors[i].timingBudget;
+
+	/* Twice the timing budget, in milliseconds */
+	return (budget / 500) + 1;
+}
+
+u8 pollSensors(vl53l0x_array_struct_t* ps_array, u8 u8_sensors)
+{
+	u8 i;
+	u8 newSamples = 0;
+	u16 range;
+
+	for (i = 0; i < ps_array->sensorCount; i++)
+	{
+		if (!(u8_sensors & (1 << i)))
+			continue;
+
+		range = vl53l0x_readRangeContinuous(&ps_array->ps_sensors[i]);
+		if (range != 0xFFFF)
+		{
+			ps_array->au16_ranges[i] = range;
+			newSamples |= (1 << i);
+		}
+	}
+
+	return newSamples;
+}
+
+void expireSlot(vl53l0x_array_struct_t* ps_array, u32 u32_now)
+{
+	u8 i;
+
+	/* Don't let a sensor which stopped answering stall the whole schedule */
+	if (ps_array->pendingSensors == 0 || (u32_now - ps_array->slotStart) <= slotTimeout(ps_array))
+		return;
+
+	for (i = 0; i < ps_array->sensorCount; i++)
+		if (ps_array->pendingSensors & (1 << i))
+		{
+			ps_array->ps_sensors[i].timedOut = TRUE;
+#ifdef VL53L0X_STATISTICS
+			ps_array->ps_sensors[i].s_statistics.timeouts++;
+#endif
+		}
+	ps_array->pendingSensors = 0;
+}
+
+void startSlot(vl53l0x_array_struct_t* ps_array, u8 u8_skippedSensors)
+{
+	u8 i;
+
+	ps_array->pendingSensors = ps_array->au8_slots[ps_array->currentSlot] & ps_array->activeSensors & ~u8_skippedSensors;
+	ps_array->slotStart = vl53l0x_getMilliseconds();
+
+	for (i = 0; i < ps_array->sensorCount; i++)
+		if (ps_array->pendingSensors & (1 << i))
+			vl53l0x_startSingle(&ps_array->ps_sensors[i]);
+}
+
+/************************************************************************/
+/* Exported functions                                                   */
+/************************************************************************/
+
+void vl53l0x_array_init(vl53l0x_array_struct_t* ps_array)
+{
+	u8 i;
+
+	ps_array->activeSensors = 0;
+	ps_array->slotCount = 0;
+	ps_array->pendingSensors = 0;
+
+	for (i = 0; i < ps_array->sensorCount && i < VL53L0X_ARRAY_MAX_SENSORS; i++)
+	{
+		ps_array->ps_sensors[i].address = VL53L0X_ADDRESS_DEFAULT;
+		vl53l0x_init(&ps_array->ps_sensors[i]);
+		ps_array->au16_ranges[i] = 0xFFFF;
+	}
+}
+
+bool vl53l0x_array_start(vl53l0x_array_struct_t* ps_array)
+{
+	u8 i;
+	vl53l0x_struct_t* ps_sensor;
+
+	if (!addressRangeValid(ps_array))
+		return FALSE;
+
+	ps_array->activeSensors = 0;
+
+	/* Only one sensor at a time may be out of reset while it still answers on the default address */
+	for (i = 0; i < ps_array->sensorCount; i++)
+	{
+		ps_sensor = &ps_array->ps_sensors[i];
+		ps_sensor->address = VL53L0X_ADDRESS_DEFAULT;
+
+		if (!vl53l0x_start(ps_sensor))
+		{
+			vl53l0x_stop(ps_sensor);
+			continue;
+		}
+
+		vl53l0x_setAddress(ps_sensor, ps_array->firstAddress + i);
+
+		if (!vl53l0x_setMode(ps_sensor, ps_array->mode))
+		{
+			vl53l0x_stop(ps_sensor);
+			continue;
+		}
+
+		ps_array->activeSensors |= (1 << i);
+	}
+
+	computeSchedule(ps_array);
+
+	ps_array->currentSlot = 0;
+	ps_array->frameDuration = 0;
+	ps_array->frameStart = vl53l0x_getMilliseconds();
+
+	if (ps_array->singleShot)
+		ps_array->pendingSensors = 0;
+	else if (ps_array->slotCount == 1)
+	{
+		for (i = 0; i < ps_array->sensorCount; i++)
+			if (ps_array->activeSensors & (1 << i))
+				vl53l0x_startContinuous(&ps_array->ps_sensors[i], ps_array->rangingPeriod);
+	}
+	else
+		startSlot(ps_array, 0);
+
+	return ps_array->activeSensors == (u8)((1 << ps_array->sensorCount) - 1);
+}
+
+void vl53l0x_array_stop(vl53l0x_array_struct_t* ps_array)
+{
+	u8 i;
+
+	for (i = 0; i < ps_array->sensorCount; i++)
+	{
+		vl53l0x_stop(&ps_array->ps_sensors[i]);
+		ps_array->ps_sensors[i].address = VL53L0X_ADDRESS_DEFAULT;
+	}
+
+	ps_array->activeSensors = 0;
+	ps_array->pendingSensors = 0;
+}
+
+u8 vl53l0x_array_read(vl53l0x_array_struct_t* ps_array)
+{
+	u8 newSamples;
+	u32 now;
+
+	newSamples = pollSensors(ps_array, (ps_array->slotCount == 1) ? ps_array->activeSensors : ps_array->pendingSensors);
+
+	if (ps_array->slotCount > 1 && ps_array->activeSensors != 0)
+	{
+		ps_array->pendingSensors &= ~newSamples;
+		now = vl53l0x_getMilliseconds();
+		expireSlot(ps_array, now);
+
+		if (ps_array->pendingSensors == 0)
+		{
+			ps_array->currentSlot++;
+			if (ps_array->currentSlot == ps_array->slotCount)
+			{
+				ps_array->currentSlot = 0;
+				ps_array->frameDuration = now - ps_array->frameStart;
+				ps_array->frameStart = now;
+			}
+			startSlot(ps_array, 0);
+		}
+	}
+
+	return newSamples;
+}
+
+u8 vl53l0x_array_measure(vl53l0x_array_struct_t* ps_array)
+{
+	u8 newSamples = 0;
+	u8 measuredSensors = 0;
+	u8 slotSamples;
+
+	ps_array->frameStart = vl53l0x_getMilliseconds();
+
+	for (ps_array->currentSlot = 0; ps_array->currentSlot < ps_array->slotCount; ps_array->currentSlot++)
+	{
+		/* Trigger the whole slot first, then take each result as soon as its sensor is done. Sensors sharing several slots are only measured in the first one. */
+		startSlot(ps_array, measuredSensors);
+		measuredSensors |= ps_array->pendingSensors;
+		while (ps_array->pendingSensors != 0)
+		{
+			slotSamples = pollSensors(ps_array, ps_array->pendingSensors);
+			ps_array->pendingSensors &= ~slotSamples;
+			newSamples |= slotSamples;
+			expireSlot(ps_array, vl53l0x_getMilliseconds());
+		}
+	}
+
+	ps_array->currentSlot = 0;
+	ps_array->frameDuration = vl53l0x_getMilliseconds() - ps_array->frameStart;
+
+	return newSamples;
+}
+
+u32 vl53l0x_array_getSampleRate(vl53l0x_array_struct_t* ps_array, u8 u8_sensor)
+{
+	u8 i;
+	u8 slots = 0;
+	u32 frameDuration;
+	u32 budget;
+
+	if (u8_sensor >= ps_array->sensorCount || !(ps_array->activeSensors & (1 << u8_sensor)))
+		return 0;
+
+	budget = ps_array->ps_sensors[u8_sensor].timingBudget / 1000;
+
+	if (ps_array->slotCount == 1 && !ps_array->singleShot)
+		frameDuration = (ps_array->rangingPeriod > budget) ? ps_array->rangingPeriod : budget;
+	else if (ps_array->frameDuration != 0)
+		frameDuration = ps_array->frameDuration;
+	else
+		frameDuration = ps_array->slotCount * budget;
+
+	if (frameDuration == 0)
+		return 0;
+
+	/* A batch measures each sensor only once */
+	if (ps_array->singleShot)
+		slots = 1;
+	else
+		for (i = 0; i < ps_array->slotCount; i++)
+			if (ps_array->au8_slots[i] & (1 << u8_sensor))
+				slots++;
+
+	return (slots * 1000000UL) / frameDuration;
+}
@@ -0,0 +1,111 @@
+/**	@file		vl53l0x_filter.c
+	@brief		Outlier rejection and smoothing of VL53L0X ranges
+	@details	See @link vl53l0x_filter.h @endlink for details.
+*/
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include "vl53l0x_filter.h"
+
+/************************************************************************/
+/* Internal functions                                                   */
+/************************************************************************/
+
+bool sampleAcceptable(vl53l0x_filter_struct_t* ps_filter, vl53l0x_sample_struct_t const * ps_sample)
+{
+	return ps_sample->rangeStatus == VL53L0X_RANGE_STATUS_VALID
+		&& ps_sample->signalRate >= ps_filter->minSignalRate
+		&& ps_sample->range <= ps_filter->maxRange;
+}
+
+/* O(VL53L0X_FILTER_MEDIAN_SIZE): a linear removal and an insertion shift */
+void replaceSorted(vl53l0x_filter_struct_t* ps_filter, u16 u16_old, bool b_removeOld, u16 u16_new)
+{
+	u8 i;
+	u8 count = ps_filter->count;
+
+	/* Take the oldest sample out of the sorted list */
+	if (b_removeOld)
+	{
+		for (i = 0; i < count && ps_filter->au16_sorted[i] != u16_old; i++);
+		for (; i + 1 < count; i++)
+			ps_filter->au16_sorted[i] = ps_filter->au16_sorted[i + 1];
+		count--;
+	}
+
+	/* Insert the new one, shifting the larger ones up */
+	for (i = count; i > 0 && ps_filter->au16_sorted[i - 1] > u16_new; i--)
+		ps_filter->au16_sorted[i] = ps_filter->au16_sorted[i - 1];
+	ps_filter->au16_sorted[i] = u16_new;
+}
+
+/************************************************************************/
+/* Exported functions                                                   */
+/************************************************************************/
+
+void vl53l0x_filter_init(vl53l0x_filter_struct_t* ps_filter)
+{
+	ps_filter->range = 0xFFFF;
+	ps_filter->e_flag = VL53L0X_FILTER_STALE;
+	ps_filter->rejected = 0;
+	ps_filter->count = 0;
+	ps_filter->oldest = 0;
+	ps_filter->average = 0;
+}
+
+vl53l0x_filterFlag_enum_t vl53l0x_filter_push(vl53l0x_filter_struct_t* ps_filter, vl53l0x_sample_struct_t const * ps_sample)
+{
+	u16 median;
+	bool full = (ps_filter->count == VL53L0X_FILTER_MEDIAN_SIZE);
+
+	if (!sampleAcceptable(ps_filter, ps_sample))
+	{
+		if (ps_filter->rejected != 0xFFFF)
+			ps_filter->rejected++;
+		ps_filter->e_flag = VL53L0X_FILTER_STALE;
+		return ps_filter->e_flag;
+	}
+
+	/* The window is a ring, so the oldest sample is overwritten once it's full */
+	replaceSorted(ps_filter, ps_filter->au16_window[ps_filter->oldest], full, ps_sample->range);
+	if (full)
+	{
+		ps_filter->au16_window[ps_filter->oldest] = ps_sample->range;
+		ps_filter->oldest = (ps_filter->oldest + 1) % VL53L0X_FILTER_MEDIAN_SIZE;
+	}
+	else
+		ps_filter->au16_window[ps_filter->count++] = ps_sample->range;
+
+	median = ps_filter->au16_sorted[(ps_filter->count - 1) / 2];
+
+	/* Until the window is full, restart the average from the median so early samples aren't over-weighted */
+	if (ps_filter->count < VL53L0X_FILTER_MEDIAN_SIZE)
+	{
+		ps_filter->average = (u32)median << 4;
+		ps_filter->e_flag = VL53L0X_FILTER_VALID;
+	}
+	else
+	{
+		ps_filter->average = ps_filter->average - (ps_filter->average >> ps_filter->emaShift) + (((u32)median << 4) >> ps_filter->emaShift);
+		ps_filter->e_flag = VL53L0X_FILTER_FILTERED;
+	}
+
+	ps_filter->range = (ps_filter->average + 8) >> 4;
+
+	return ps_filter->e_flag;
+}
+
+vl53l0x_filterFlag_enum_t vl53l0x_filter_update(vl53l0x_filter_struct_t* ps_filter)
+{
+	vl53l0x_sample_struct_t s_sample;
+
+	if (!vl53l0x_readSample(ps_filter->ps_sensor, &s_sample))
+	{
+		ps_filter->e_flag = VL53L0X_FILTER_STALE;
+		return ps_filter->e_flag;
+	}
+
+	return vl53l0x_filter_push(ps_filter, &s_sample);
+}
@@ -0,0 +1,124 @@
+/**	@file		vl53l0x_history.c
+	@brief		Timestamped history of VL53L0X samples
+	@details	See @link vl53l0x_history.h @endlink for details.
+*/
+
+/************************************************************************/
+/* Project specific includes                                            */
+/************************************************************************/
+
+#include "vl53l0x_history.h"
+
+/************************************************************************/
+/* Internal functions                                                   */
+/************************************************************************/
+
+vl53l0x_record_struct_t const * recordAtAge(vl53l0x_history_struct_t const * ps_history, u8 u8_age)
+{
+	u8 index = (ps_history->newest + VL53L0X_HISTORY_SIZE - u8_age) % VL53L0X_HISTORY_SIZE;
+
+	return &ps_history->as_records[index];
+}
+
+u8 ageAtOrBefore(vl53l0x_history_struct_t const * ps_history, u32 u32_time)
+{
+	u8 newer = 0;
+	u8 older = ps_history->count;
+	u8 middle;
+
+	/* Timestamps decrease with age. Find the smallest age whose timestamp isn't after u32_time, count if there is none. The difference is taken as signed so the search works across a wrap of the millisecond counter. */
+	while (newer < older)
+	{
+		middle = (newer + older) / 2;
+
+		if ((s32)(recordAtAge(ps_history, middle)->timestamp - u32_time) <= 0)
+			older = middle;
+		else
+			newer = middle + 1;
+	}
+
+	return newer;
+}
+
+/************************************************************************/
+/* Exported functions                                                   */
+/************************************************************************/
+
+void vl53l0x_history_init(vl53l0x_history_struct_t* ps_history)
+{
+	ps_history->pushCount = 0;
+	ps_history->newest = VL53L0X_HISTORY_SIZE - 1;
+	ps_history->count = 0;
+}
+
+void vl53l0x_history_push(vl53l0x_history_struct_t* ps_history, vl53l0x_sample_struct_t const * ps_sample, u32 u32_timestamp)
+{
+	vl53l0x_record_struct_t* ps_record;
+
+	ps_history->newest = (ps_history->newest + 1) % VL53L0X_HISTORY_SIZE;
+	ps_record = &ps_history->as_records[ps_history->newest];
+	ps_record->timestamp = u32_timestamp;
+	ps_record->s_sample = *ps_sample;
+
+	if (ps_history->count < VL53L0X_HISTORY_SIZE)
+		ps_history->count++;
+	ps_history->pushCount++;
+}
+
+bool vl53l0x_history_update(vl53l0x_history_struct_t* ps_history)
+{
+	vl53l0x_sample_struct_t s_sample;
+
+	if (!vl53l0x_readSample(ps_history->ps_sensor, &s_sample))
+		return FALSE;
+
+	vl53l0x_history_push(ps_history, &s_sample, vl53l0x_getMilliseconds());
+
+	return TRUE;
+}
+
+vl53l0x_record_struct_t const * vl53l0x_history_getLatest(vl53l0x_history_struct_t const * ps_history)
+{
+	return vl53l0x_history_get(ps_history, 0);
+}
+
+vl53l0x_record_struct_t const * vl53l0x_history_get(vl53l0x_history_struct_t const * ps_history, u8 u8_age)
+{
+	if (u8_age >= ps_history->count)
+		return NULL;
+
+	return recordAtAge(ps_history, u8_age);
+}
+
+vl53l0x_record_struct_t const * vl53l0x_history_getAt(vl53l0x_history_struct_t const * ps_history, u32 u32_time)
+{
+	return vl53l0x_history_get(ps_history, ageAtOrBefore(ps_history, u32_time));
+}
+
+u32 vl53l0x_history_countSince(vl53l0x_history_struct_t const * ps_history, u32 u32_pushCount)
+{
+	return ps_history->pushCount - u32_pushCount;
+}
+
+u8 vl53l0x_history_window(vl53l0x_history_struct_t const * ps_history, vl53l0x_historyIterator_struct_t* ps_iterator, u32 u32_from, u32 u32_to)
+{
+	u8 newestAge = ageAtOrBefore(ps_history, u32_to);
+	/* The oldest record of the window is the one just newer than the last record before u32_from */
+	u8 oldestAge = ageAtOrBefore(ps_history, u32_from - 1);
+
+	ps_iterator->ps_history = ps_history;
+	ps_iterator->remaining = (oldestAge > newestAge) ? oldestAge - newestAge : 0;
+	ps_iterator->age = oldestAge - 1;
+
+	return ps_iterator->remaining;
+}
+
+vl53l0x_record_struct_t const * vl53l0x_history_next(vl53l0x_historyIterator_struct_t* ps_iterator)
+{
+	if (ps_iterator->remaining == 0)
+		return NULL;
+
+	ps_iterator->remaining--;
+
+	return recordAtAge(ps_iterator->ps_history, ps_iterator->age--);
+}
@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+"""Decodes the I2C bus trace printed by i2cBus_dumpTrace.
+
+Reads a debug UART capture (or the simulation bench output) from a file or the
+standard input. Every block between an "I2CTRACE" line and the next "END" line
+is decoded, other lines are ignored, so several dumps can be concatenated.
+
+Prints the bus utilisation of each device, the idle gaps between transactions
+and the registers taking the most bus time.
+
+Usage:
+    i2c_trace.py [--tick-us TICK] [--top N] [capture.txt]
+"""
+
+import argparse
+import sys
+from collections import defaultdict
+
+FLAG_WRITE = 0x01
+FLAG_READ = 0x02
+FLAG_REGISTER = 0x04
+
+STATUS_NAMES = {0: "pending", 1: "done", 2: "nack", 3: "error"}
+
+GAP_BINS = [(10, "<10 us"), (100, "<100 us"), (1000, "<1 ms"), (10000, "<10 ms"), (None, ">=10 ms")]
+
+
+class Record:
+    def __init__(self, fields):
+        self.address = int(fields[0], 16)
+        self.register = int(fields[1], 16)
+        self.bytes = int(fields[2], 16)
+        self.flags = int(fields[3], 16)
+        self.status = int(fields[4], 16)
+        self.start = int(fields[5], 16)
+        self.end = int(fields[6], 16)
+
+    def has_register(self):
+        return bool(self.flags & FLAG_REGISTER)
+
+    def direction(self):
+        return ("W" if self.flags & FLAG_WRITE else "") + ("R" if self.flags & FLAG_READ else "")
+
+
+def parse(lines):
+    """Returns the records of all the dumps and the number of records the device dropped."""
+    records = []
+    dropped = 0
+    in_block = False
+
+    for line in lines:
+        fields = line.split()
+        if not fields:
+            continue
+
+        if fields[0] == "I2CTRACE" and len(fields) == 3:
+            in_block = True
+            dropped += int(fields[2], 16)
+        elif fields[0] == "END":
+            in_block = False
+        elif in_block and len(fields) == 7:
+            try:
+                records.append(Record(fields))
+            except ValueError:
+                pass
+
+    return records, dropped
+
+
+def unwrap(records):
+    """Makes the 32 bit clock monotonic across overflows."""
+    offset = 0
+    last = None
+
+    for record in records:
+        if last is not None and record.start + offset < last:
+            offset += 1 << 32
+        record.start += offset
+        if record.end + offset < record.start:
+            record.end += offset + (1 << 32)
+        else:
+            record.end += offset
+        last = record.end
+
+
+def fmt_us(value):
+    if value >= 1000000:
+        return "%.2f s" % (value / 1000000.0)
+    if value >= 1000:
+        return "%.2f ms" % (value / 1000.0)
+    return "%.1f us" % value
+
+
+def report(records, dropped, tick_us, top):
+    if not records:
+        print("no trace records found")
+        return
+
+    unwrap(records)
+
+    span = (records[-1].end - records[0].start) * tick_us
+    busy = sum(r.end - r.start for r in records) * tick_us
+
+    print("records: %d, dropped by the device: %d" % (len(records), dropped))
+    print("span: %s, bus busy: %s (%.1f %%)" % (fmt_us(span), fmt_us(busy), 100.0 * busy / span if span else 100.0))
+    print()
+
+    devices = defaultdict(lambda: {"count": 0, "bytes": 0, "time": 0.0, "nack": 0, "error": 0})
+    for r in records:
+        device = devices[r.address]
+        device["count"] += 1
+        device["bytes"] += r.bytes
+        device["time"] += (r.end - r.start) * tick_us
+        if r.status == 2:
+            device["nack"] += 1
+        elif r.status == 3:
+            device["error"] += 1
+
+    print("%-8s %8s %8s %12s %8s %12s %6s %6s" % ("device", "frames", "bytes", "bus time", "share", "per frame", "nack", "error"))
+    for address, d in sorted(devices.items(), key=lambda item: -item[1]["time"]):
+        print("0x%02X     %8d %8d %12s %7.1f%% %12s %6d %6d" % (address, d["count"], d["bytes"], fmt_us(d["time"]),
+              100.0 * d["time"] / busy if busy else 0.0, fmt_us(d["time"] / d["count"]), d["nack"], d["error"]))
+    print()
+
+    gaps = [(b.start - a.end) * tick_us for a, b in zip(records, records[1:])]
+    if gaps:
+        print("idle gaps: %d, min %s, mean %s, max %s" % (len(gaps), fmt_us(min(gaps)), fmt_us(sum(gaps) / len(gaps)), fmt_us(max(gaps))))
+        counts = [0] * len(GAP_BINS)
+        for gap in gaps:
+            for i, (limit, _) in enumerate(GAP_BINS):
+                if limit is None or gap < limit:
+                    counts[i] += 1
+                    break
+        print("  " + "  ".join("%s: %d" % (name, count) for (_, name), count in zip(GAP_BINS, counts)))
+        print()
+
+    registers = defaultdict(lambda: {"count": 0, "bytes": 0, "time": 0.0, "directions": set()})
+    for r in records:
+        key = (r.address, r.register if r.has_register() else None)
+        entry = registers[key]
+        entry["count"] += 1
+        entry["bytes"] += r.bytes
+        entry["time"] += (r.end - r.start) * tick_us
+        entry["directions"].add(r.direction())
+
+    print("hot registers (top %d by bus time)" % top)
+    print("%-8s %-8s %8s %8s %12s %8s  %s" % ("device", "register", "frames", "bytes", "bus time", "share", "access"))
+    for (address, register), e in sorted(registers.items(), key=lambda item: -item[1]["time"])[:top]:
+        print("0x%02X     %-8s %8d %8d %12s %7.1f%%  %s" % (address, "0x%02X" % register if register is not None else "-", e["count"], e["bytes"],
+              fmt_us(e["time"]), 100.0 * e["time"] / busy if busy else 0.0, ",".join(sorted(d for d in e["directions"] if d))))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decodes the I2C bus trace printed by i2cBus_dumpTrace.")
+    parser.add_argument("capture", nargs="?", help="capture file, standard input if omitted")
+    parser.add_argument("--tick-us", type=float, default=1.0, help="microseconds per trace clock tick (default 1)")
+    parser.add_argument("--top", type=int, default=10, help="number of hot registers to list (default 10)")
+    args = parser.parse_args()
+
+    if args.capture:
+        with open(args.capture) as capture:
+            records, dropped = parse(capture)
+    else:
+        records, dropped = parse(sys.stdin)
+
+    report(records, dropped, args.tick_us, args.top)
+
+
+if __name__ == "__main__":
+    main()